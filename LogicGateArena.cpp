@@ -0,0 +1,154 @@
+#include "LogicGateArena.hpp"
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+
+CircuitArena::CircuitArena(size_t blockSize) : pool(blockSize) { init(); }
+
+void CircuitArena::init()
+{
+  gates = new (pool.allocate(sizeof(Map), alignof(Map))) Map(&pool);
+  wires = new (pool.allocate(sizeof(std::pmr::vector<Wire>), alignof(std::pmr::vector<Wire>)))
+      std::pmr::vector<Wire>(&pool);
+}
+
+void CircuitArena::clear()
+{
+  pool.release();
+  init();
+}
+
+Terminal* CircuitArena::allocate(size_t n)
+{
+  return static_cast<Terminal*>(pool.allocate(std::max<size_t>(n, 1) * sizeof(Terminal), alignof(Terminal)));
+}
+
+CircuitArena::Map::iterator CircuitArena::find(std::string_view name) const { return gates->find(name); }
+
+GateView CircuitArena::at(std::string_view name) const
+{
+  auto it = find(name);
+  if (it == gates->end())
+    throw std::out_of_range("");
+  return it->second;
+}
+
+GateView CircuitArena::put(std::string_view name, Terminal* terms, size_t n)
+{
+  GateView view(terms, n);
+  auto it = gates->lower_bound(name);
+  if (it == gates->end() || it->first != name)
+    gates->emplace_hint(it, std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(view));
+  else
+  {
+    // name may view the key itself, so the node is kept
+    unwire(it->first);
+    it->second = view;
+  }
+  return view;
+}
+
+GateView CircuitArena::add(std::string_view name, size_t in, size_t out)
+{
+  Terminal* terms = allocate(in + out);
+  for (size_t i = 0; i < in + out; i++)
+    new (terms + i) Terminal(i >= in, 0, 0);
+  return put(name, terms, in + out);
+}
+
+GateView CircuitArena::add(std::string_view name, GateView terms)
+{
+  Terminal* copy = allocate(terms.size());
+  std::uninitialized_copy(terms.begin(), terms.end(), copy);
+  return put(name, copy, terms.size());
+}
+
+GateView CircuitArena::add(std::string_view name, Gate const& gate)
+{
+  Terminal* terms = allocate(gate.size());
+  for (size_t i = 0; i < gate.size(); i++)
+    new (terms + i) Terminal(gate.terminal(i));
+  return put(name, terms, gate.size());
+}
+
+GateView CircuitArena::addTerminal(std::string_view name, Terminal term)
+{
+  auto it = find(name);
+  if (it == gates->end())
+    throw std::out_of_range("");
+  GateView old    = it->second;
+  Terminal* terms = allocate(old.size() + 1);
+  std::uninitialized_copy(old.begin(), old.end(), terms);
+  new (terms + old.size()) Terminal(term);
+  return it->second = GateView(terms, old.size() + 1);
+}
+
+void CircuitArena::unwire(std::string_view name)
+{
+  // The far end of every dropped wire loses a connection
+  auto dropped = std::remove_if(wires->begin(), wires->end(), [&](Wire const& w) {
+    if (w.from == name && w.to == name)
+      return true;
+    if (w.from == name)
+      --at(w.to).data()[w.in].conn_num;
+    else if (w.to == name)
+      --at(w.from).data()[w.out].conn_num;
+    else
+      return false;
+    return true;
+  });
+  wires->erase(dropped, wires->end());
+}
+
+bool CircuitArena::remove(std::string_view name)
+{
+  auto it = find(name);
+  if (it == gates->end())
+    return false;
+  unwire(it->first);
+  gates->erase(it);
+  return true;
+}
+
+void CircuitArena::connect(std::string_view from, size_t out, std::string_view to, size_t in)
+{
+  auto src = find(from), dst = find(to);
+  if (src == gates->end() || dst == gates->end())
+    throw std::out_of_range("");
+  Terminal const &o = src->second.terminal(out), &i = dst->second.terminal(in);
+  if (!o.isOutput || i.isOutput)
+    throw std::runtime_error("Wire must run from an output to an input");
+  if (o.conn_num >= 3 || i.conn_num)
+    throw std::runtime_error("Number of connections can't be increased!");
+  src->second.connect(out);
+  dst->second.connect(in);
+  wires->push_back({src->first, out, dst->first, in});
+}
+
+void CircuitArena::disconnect(std::string_view from, size_t out, std::string_view to, size_t in)
+{
+  auto it = std::find_if(wires->begin(), wires->end(), [&](Wire const& w) {
+    return w.from == from && w.out == out && w.to == to && w.in == in;
+  });
+  if (it == wires->end())
+    throw std::runtime_error("Can not disconnect! No connections");
+  --at(from).data()[out].conn_num;
+  --at(to).data()[in].conn_num;
+  wires->erase(it);
+}
+
+void CircuitArena::load(GateMap const& map)
+{
+  for (auto const& keyval : map)
+    add(keyval.first, keyval.second);
+}
+
+GateMap CircuitArena::toGateMap() const
+{
+  GateMap res;
+  for (auto const& keyval : *gates)
+    res.emplace(std::string(keyval.first), Gate(keyval.second));
+  return res;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+/**
+ *  Connection from output terminal out of gate from to input terminal in
+ *  of gate to (names view the keys of the arena)
+ *
+ */
+struct Wire
+{
+  std::string_view from;
+  size_t out;
+  std::string_view to;
+  size_t in;
+};
+/**
+ *  Named gates of a circuit allocated from one monotonic arena
+ *
+ *  Map nodes, names, terminal arrays and the wire list all come from a few
+ *  large blocks instead of one heap block each. Nothing is returned to the
+ *  arena before clear() or destruction, which drop the whole circuit by
+ *  releasing the blocks without visiting gates. Gates are handed out as
+ *  GateView; a view stays valid until its gate is replaced, grown or removed.
+ */
+class CircuitArena
+{
+  typedef std::pmr::map<std::pmr::string, GateView, std::less<>> Map;
+  std::pmr::monotonic_buffer_resource pool;
+  /**
+   *  Live in the arena and are never destroyed, only released with it
+   *
+   */
+  Map* gates;
+  std::pmr::vector<Wire>* wires;
+
+  void init();
+  Terminal* allocate(size_t n);
+  GateView put(std::string_view name, Terminal* terms, size_t n);
+  /**
+   *  Drop every wire into or out of gate name
+   *
+   */
+  void unwire(std::string_view name);
+  Map::iterator find(std::string_view name) const;
+
+public:
+  /**
+   *  Construct an empty arena
+   *
+   *  blockSize size of the first block (later blocks grow geometrically)
+   */
+  explicit CircuitArena(size_t blockSize = 1 << 16);
+  CircuitArena(CircuitArena const&) = delete;
+  CircuitArena& operator=(CircuitArena const&) = delete;
+  /**
+   *  Arena resource for caller containers that should share its lifetime
+   *
+   */
+  inline std::pmr::memory_resource* resource() { return &pool; }
+  inline size_t size() const { return gates->size(); }
+  inline Map::const_iterator begin() const { return gates->begin(); }
+  inline Map::const_iterator end() const { return gates->end(); }
+  /**
+   *  Add or replace gate name with in inputs then out outputs (all Low)
+   *
+   */
+  GateView add(std::string_view name, size_t in, size_t out);
+  /**
+   *  Add or replace gate name with a copy of terminals
+   *
+   */
+  GateView add(std::string_view name, GateView terms);
+  GateView add(std::string_view name, Gate const& gate);
+  /**
+   *  Append terminal to gate name (moves its terminals)
+   *
+   */
+  GateView addTerminal(std::string_view name, Terminal term);
+  /**
+   *  Remove gate name and its wires
+   *
+   *  bool false if there is no such gate
+   */
+  bool remove(std::string_view name);
+  inline bool contains(std::string_view name) const { return find(name) != gates->end(); }
+  /**
+   *  Gate by name (with checking)
+   *
+   */
+  GateView at(std::string_view name) const;
+  /**
+   *  Wire output terminal out of from to input terminal in of to
+   *
+   */
+  void connect(std::string_view from, size_t out, std::string_view to, size_t in);
+  void disconnect(std::string_view from, size_t out, std::string_view to, size_t in);
+  inline std::pmr::vector<Wire> const& connections() const { return *wires; }
+  /**
+   *  Copy every gate of map into the arena
+   *
+   */
+  void load(GateMap const& map);
+  /**
+   *  Heap-owning copy of every gate
+   *
+   */
+  GateMap toGateMap() const;
+  /**
+   *  Drop all gates and wires at once
+   *
+   */
+  void clear();
+};
@@ -0,0 +1,745 @@
+#include "LogicGateAtpg.hpp"
+#include "LogicGatePipeline.hpp"
+#include "LogicGateSequential.hpp"
+#include "LogicGateStats.hpp"
+#include "LogicGateStimulus.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+constexpr uint32_t Unreachable = 1u << 24;
+
+static unsigned threadCount(unsigned threads, size_t work)
+{
+  unsigned count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+  return unsigned(std::max<size_t>(1, std::min<size_t>(count, work)));
+}
+
+std::vector<Fault> stuckAtFaults(Netlist const& nl)
+{
+  std::vector<bool> observed(nl.nets(), false);
+  for (auto net : nl.outputs())
+    observed[net] = true;
+  for (NetId net = 0; net < nl.nets(); net++)
+    if (nl.fanout(net).size())
+      observed[net] = true;
+  std::vector<bool> source(nl.nets(), false);
+  for (auto net : nl.inputs())
+    source[net] = true;
+  std::vector<Fault> res;
+  for (NetId net = 0; net < nl.nets(); net++)
+    if (observed[net] && (source[net] || nl.driver(net) != NoGate))
+    {
+      res.push_back({net, 0});
+      res.push_back({net, 1});
+    }
+  return res;
+}
+
+PatternSet::PatternSet(size_t inputs) : _inputs(inputs) {}
+
+void PatternSet::add(std::vector<unsigned short> const& vec)
+{
+  if (vec.size() != _inputs)
+    throw std::runtime_error("Wrong number of inputs");
+  if (count % 64 == 0)
+    planes.resize(planes.size() + _inputs, Planes{0, 0});
+  Planes* blk = planes.data() + count / 64 * _inputs;
+  for (size_t i = 0; i < _inputs; i++)
+    blk[i].setLane(count % 64, vec[i]);
+  count++;
+}
+
+std::vector<unsigned short> PatternSet::vector(size_t n) const
+{
+  if (n >= count)
+    throw std::out_of_range("");
+  std::vector<unsigned short> res(_inputs);
+  for (size_t i = 0; i < _inputs; i++)
+    res[i] = block(n / 64)[i].lane(n % 64);
+  return res;
+}
+
+void PatternSet::save(std::string const& name) const
+{
+  std::ofstream file(name);
+  file << "# " << count << " vectors of " << _inputs << " inputs\n";
+  std::string line(_inputs, '0');
+  for (size_t n = 0; n < count; n++)
+  {
+    for (size_t i = 0; i < _inputs; i++)
+      line[i] = "01X"[block(n / 64)[i].lane(n % 64)];
+    file << line << '\n';
+  }
+  if (!file.flush())
+    throw std::runtime_error("Can not write " + name);
+}
+
+PatternSet PatternSet::load(std::string const& name, size_t inputs)
+{
+  std::ifstream file(name);
+  if (!file)
+    throw std::runtime_error("Can not read " + name);
+  PatternSet res(inputs);
+  std::vector<unsigned short> vec(inputs);
+  std::string line;
+  for (uint64_t lineNo = 1; std::getline(file, line); lineNo++)
+    if (parseVectorLine(line, inputs, vec.data(), lineNo))
+      res.add(vec);
+  return res;
+}
+
+/**
+ *  Levelized event-driven re-evaluation of the fanout cone of a net
+ *
+ */
+class ConePropagator
+{
+  Netlist const& nl;
+  std::vector<uint32_t> levels;
+  std::vector<std::vector<uint32_t>> buckets;
+  std::vector<uint32_t> scheduled;
+  uint32_t epoch = 0;
+
+  void schedule(NetId net, uint32_t& low)
+  {
+    for (auto g : nl.fanout(net))
+      if (scheduled[g] != epoch)
+      {
+        scheduled[g] = epoch;
+        buckets[levels[g]].push_back(g);
+        low = std::min(low, levels[g]);
+        LG_STAT_INC(events_scheduled);
+      }
+  }
+
+public:
+  /**
+   *  Nets changed by the last run (the start net first)
+   *
+   */
+  std::vector<NetId> touched;
+
+  explicit ConePropagator(Netlist const& netlist)
+      : nl(netlist), levels(netlist.gates()), buckets(netlist.depth() + 1), scheduled(netlist.gates(), 0)
+  {
+    for (uint32_t g = 0; g < nl.gates(); g++)
+      levels[g] = nl.level(g);
+  }
+  /**
+   *  Re-evaluate everything downstream of a change of values[from]
+   *
+   *  inject net whose lanes in mask are forced to stuck after every write
+   */
+  void run(Planes* values, NetId from, NetId inject = NoNet, uint64_t mask = 0, unsigned short stuck = 0)
+  {
+    LG_STAT_PHASE(Propagate);
+    touched.clear();
+    touched.push_back(from);
+    if (++epoch == 0)
+    {
+      std::fill(scheduled.begin(), scheduled.end(), 0);
+      epoch = 1;
+    }
+    uint32_t low = UINT32_MAX;
+    schedule(from, low);
+    Planes old[GateType::MaxTerminals];
+    for (uint32_t lvl = low; lvl < buckets.size(); lvl++)
+    {
+      auto& bucket = buckets[lvl];
+      // Gates of one level never feed each other, so the bucket is stable
+      for (size_t i = 0; i < bucket.size(); i++)
+      {
+        uint32_t g        = bucket[i];
+        GateType const& t = nl.type(g);
+        for (size_t k = 0; k < t.outputs(); k++)
+          old[k] = values[nl.pin(g, t.outputTerminal(k))];
+        nl.evaluateGate(g, values);
+        for (size_t k = 0; k < t.outputs(); k++)
+        {
+          NetId net = nl.pin(g, t.outputTerminal(k));
+          if (net == inject)
+          {
+            Planes forced = Planes::broadcast(stuck);
+            values[net].val = (values[net].val & ~mask) | (forced.val & mask);
+            values[net].unk &= ~mask;
+          }
+          if (values[net] != old[k])
+          {
+            touched.push_back(net);
+            schedule(net, low);
+          }
+        }
+      }
+      bucket.clear();
+    }
+  }
+};
+
+FaultSimulator::FaultSimulator(Netlist const& netlist) : nl(netlist) { nl.order(); }
+
+size_t FaultSimulator::run(PatternSet const& patterns, std::vector<Fault> const& faults,
+                           std::vector<FaultStatus>& status, std::vector<uint32_t>* first) const
+{
+  if (patterns.inputs() != nl.inputs().size())
+    throw std::runtime_error("Wrong number of inputs");
+  if (status.size() != faults.size())
+    throw std::runtime_error("One status per fault required");
+  std::vector<bool> isOutput(nl.nets(), false);
+  for (auto net : nl.outputs())
+    isOutput[net] = true;
+  std::atomic<size_t> detected{0};
+  unsigned n = threadCount(threads, faults.size());
+  auto work  = [&](unsigned t) {
+    ConePropagator cone(nl);
+    std::vector<Planes> good(nl.nets(), Planes::broadcast(2)), bad;
+    size_t found = 0;
+    for (size_t b = 0; b < patterns.blocks(); b++)
+    {
+      for (size_t i = 0; i < patterns.inputs(); i++)
+        good[nl.inputs()[i]] = patterns.block(b)[i];
+      nl.evaluate(good.data());
+      bad           = good;
+      uint64_t mask = patterns.laneMask(b);
+      for (size_t f = t; f < faults.size(); f += n)
+      {
+        if (status[f] != FaultStatus::Undetected)
+          continue;
+        NetId net = faults[f].net;
+        Planes g = good[net], s = Planes::broadcast(faults[f].stuck);
+        // Not activated on any lane: nothing to propagate
+        if (!((g.val ^ s.val) & ~g.unk & mask))
+          continue;
+        bad[net] = s;
+        cone.run(bad.data(), net);
+        uint64_t diff = 0;
+        for (auto m : cone.touched)
+        {
+          if (isOutput[m])
+            diff |= (good[m].val ^ bad[m].val) & ~good[m].unk & ~bad[m].unk;
+          bad[m] = good[m];
+        }
+        if (diff & mask)
+        {
+          status[f] = FaultStatus::Detected;
+          if (first)
+            (*first)[f] = uint32_t(64 * b + __builtin_ctzll(diff & mask));
+          found++;
+        }
+      }
+    }
+    detected += found;
+  };
+  if (first)
+    first->assign(faults.size(), UINT32_MAX);
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < n; t++)
+    pool.emplace_back(work, t);
+  work(0);
+  for (auto& thr : pool)
+    thr.join();
+  return detected;
+}
+
+Atpg::Atpg(Netlist const& netlist) : nl(netlist)
+{
+  nl.order();
+  size_t nets = nl.nets();
+  inputIndex.assign(nets, -1);
+  for (size_t i = 0; i < nl.inputs().size(); i++)
+    inputIndex[nl.inputs()[i]] = int32_t(i);
+  // SCOAP combinational controllability
+  cc0.assign(nets, Unreachable);
+  cc1.assign(nets, Unreachable);
+  for (auto net : nl.inputs())
+    cc0[net] = cc1[net] = 1;
+  for (auto g : nl.order())
+  {
+    GateType const& t = nl.type(g);
+    uint64_t sum0 = 0, sum1 = 0, sumMin = 0;
+    uint32_t min0 = Unreachable, min1 = Unreachable;
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      NetId in = nl.pin(g, t.inputTerminal(k));
+      sum0 += cc0[in];
+      sum1 += cc1[in];
+      sumMin += std::min(cc0[in], cc1[in]);
+      min0 = std::min(min0, cc0[in]);
+      min1 = std::min(min1, cc1[in]);
+    }
+    uint32_t c0, c1;
+    switch (t.function())
+    {
+    case GateFunction::Buffer:
+    case GateFunction::Not:
+      c0 = uint32_t(std::min<uint64_t>(sum0 + 1, Unreachable));
+      c1 = uint32_t(std::min<uint64_t>(sum1 + 1, Unreachable));
+      break;
+    case GateFunction::And:
+    case GateFunction::Nand:
+      c0 = std::min(min0 + 1, Unreachable);
+      c1 = uint32_t(std::min<uint64_t>(sum1 + 1, Unreachable));
+      break;
+    case GateFunction::Or:
+    case GateFunction::Nor:
+      c0 = uint32_t(std::min<uint64_t>(sum0 + 1, Unreachable));
+      c1 = std::min(min1 + 1, Unreachable);
+      break;
+    default:
+      c0 = c1 = uint32_t(std::min<uint64_t>(sumMin + 1, Unreachable));
+    }
+    bool inv = t.function() == GateFunction::Not || t.function() == GateFunction::Nand ||
+               t.function() == GateFunction::Nor;
+    for (size_t k = 0; k < t.outputs(); k++)
+    {
+      NetId out = nl.pin(g, t.outputTerminal(k));
+      cc0[out]  = inv ? c1 : c0;
+      cc1[out]  = inv ? c0 : c1;
+    }
+  }
+  // Distance to the nearest primary output, outputs first
+  distance.assign(nets, Unreachable);
+  for (auto net : nl.outputs())
+    distance[net] = 0;
+  auto const& order = nl.order();
+  for (auto it = order.rbegin(); it != order.rend(); ++it)
+  {
+    GateType const& t = nl.type(*it);
+    uint32_t d        = Unreachable;
+    for (size_t k = 0; k < t.outputs(); k++)
+      d = std::min(d, distance[nl.pin(*it, t.outputTerminal(k))]);
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      NetId in     = nl.pin(*it, t.inputTerminal(k));
+      distance[in] = std::min(distance[in], d + 1);
+    }
+  }
+}
+
+/**
+ *  State of one PODEM search (reused across faults by a thread)
+ *
+ */
+struct PodemSearch
+{
+  struct Decision
+  {
+    uint32_t input;
+    unsigned short value;
+    bool flipped;
+  };
+  Netlist const& nl;
+  std::vector<uint32_t> const& cc0;
+  std::vector<uint32_t> const& cc1;
+  std::vector<uint32_t> const& distance;
+  std::vector<int32_t> const& inputIndex;
+  ConePropagator cone;
+  /**
+   *  Lane 0 - good circuit, lane 1 - faulty circuit
+   *
+   */
+  std::vector<Planes> values;
+  std::vector<uint32_t> coneGates;
+  std::vector<NetId> coneOutputs;
+  std::vector<uint32_t> seen;
+  uint32_t stamp = 0;
+  std::vector<NetId> stack;
+  std::vector<bool> isOutput;
+  /**
+   *  Gate has an output on an X path to a primary output
+   *
+   */
+  std::vector<bool> xPath;
+  Fault fault;
+
+  PodemSearch(Netlist const& netlist, std::vector<uint32_t> const& c0, std::vector<uint32_t> const& c1,
+              std::vector<uint32_t> const& dist, std::vector<int32_t> const& index)
+      : nl(netlist), cc0(c0), cc1(c1), distance(dist), inputIndex(index), cone(netlist), seen(netlist.nets(), 0),
+        isOutput(netlist.nets(), false), xPath(netlist.gates(), false)
+  {
+    for (auto net : nl.outputs())
+      isOutput[net] = true;
+  }
+
+  inline unsigned short good(NetId net) const { return values[net].lane(0); }
+  inline unsigned short bad(NetId net) const { return values[net].lane(1); }
+  inline bool isD(NetId net) const { return good(net) != 2 && bad(net) != 2 && good(net) != bad(net); }
+
+  uint32_t nextStamp()
+  {
+    if (++stamp == 0)
+    {
+      std::fill(seen.begin(), seen.end(), 0);
+      stamp = 1;
+    }
+    return stamp;
+  }
+
+  void set(NetId net, unsigned short state)
+  {
+    values[net] = Planes::broadcast(state);
+    if (net == fault.net)
+      values[net].setLane(1, fault.stuck);
+    cone.run(values.data(), net, fault.net, 2, fault.stuck);
+  }
+
+  /**
+   *  Gates (highest level first) and primary outputs reachable from the
+   *  fault site
+   *
+   */
+  void collectCone()
+  {
+    coneGates.clear();
+    coneOutputs.clear();
+    uint32_t s = nextStamp();
+    stack.assign(1, fault.net);
+    seen[fault.net] = s;
+    while (!stack.empty())
+    {
+      NetId net = stack.back();
+      stack.pop_back();
+      if (isOutput[net])
+        coneOutputs.push_back(net);
+      for (auto g : nl.fanout(net))
+      {
+        GateType const& t = nl.type(g);
+        bool fresh        = false;
+        for (size_t k = 0; k < t.outputs(); k++)
+        {
+          NetId out = nl.pin(g, t.outputTerminal(k));
+          if (seen[out] != s)
+          {
+            seen[out] = s;
+            stack.push_back(out);
+            fresh = true;
+          }
+        }
+        if (fresh)
+          coneGates.push_back(g);
+      }
+    }
+    std::sort(coneGates.begin(), coneGates.end(),
+              [this](uint32_t x, uint32_t y) { return nl.level(x) > nl.level(y); });
+  }
+
+  bool detected() const
+  {
+    for (auto net : coneOutputs)
+      if (isD(net))
+        return true;
+    return false;
+  }
+
+  /**
+   *  Next objective (net, good value); false if the current assignment
+   *  can no longer detect the fault
+   *
+   */
+  bool objective(NetId& net, unsigned short& value)
+  {
+    unsigned short site = good(fault.net);
+    if (site == fault.stuck)
+      return false;
+    if (site == 2)
+    {
+      net   = fault.net;
+      value = fault.stuck ^ 1;
+      return true;
+    }
+    // D-frontier gate closest to an output that still has an X path to
+    // one; readers come first, so one sweep marks every open gate
+    uint32_t best = NoGate, bestDistance = Unreachable;
+    for (auto g : coneGates)
+    {
+      GateType const& t = nl.type(g);
+      uint32_t d        = Unreachable;
+      xPath[g]          = false;
+      for (size_t k = 0; k < t.outputs(); k++)
+      {
+        NetId out = nl.pin(g, t.outputTerminal(k));
+        if (good(out) != 2 && bad(out) != 2)
+          continue;
+        bool reaches = isOutput[out];
+        for (auto r : nl.fanout(out))
+          reaches = reaches || xPath[r];
+        if (reaches)
+        {
+          xPath[g] = true;
+          d        = std::min(d, distance[out]);
+        }
+      }
+      if (!xPath[g] || d >= bestDistance)
+        continue;
+      for (size_t k = 0; k < t.inputs(); k++)
+        if (isD(nl.pin(g, t.inputTerminal(k))))
+        {
+          best         = g;
+          bestDistance = d;
+          break;
+        }
+    }
+    if (best == NoGate)
+      return false;
+    GateType const& t = nl.type(best);
+    GateFunction fn   = t.function();
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      NetId in = nl.pin(best, t.inputTerminal(k));
+      if (good(in) != 2)
+        continue;
+      net = in;
+      if (fn == GateFunction::And || fn == GateFunction::Nand)
+        value = 1;
+      else if (fn == GateFunction::Or || fn == GateFunction::Nor)
+        value = 0;
+      else
+        value = cc1[in] < cc0[in];
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   *  Walk an objective back to an unassigned primary input
+   *
+   */
+  bool backtrace(NetId net, unsigned short value, uint32_t& input, unsigned short& state) const
+  {
+    while (inputIndex[net] < 0)
+    {
+      uint32_t g = nl.driver(net);
+      if (g == NoGate)
+        return false;
+      GateType const& t = nl.type(g);
+      GateFunction fn   = t.function();
+      if (fn == GateFunction::Not || fn == GateFunction::Nand || fn == GateFunction::Nor || fn == GateFunction::Xnor)
+        value ^= 1;
+      // All inputs must take the value: hardest first; one suffices: easiest
+      bool all = ((fn == GateFunction::And || fn == GateFunction::Nand) && value) ||
+                 ((fn == GateFunction::Or || fn == GateFunction::Nor) && !value);
+      NetId pick = NoNet;
+      uint32_t pickCost = 0;
+      unsigned short parity = 0;
+      for (size_t k = 0; k < t.inputs(); k++)
+      {
+        NetId in = nl.pin(g, t.inputTerminal(k));
+        if (good(in) != 2)
+        {
+          parity ^= good(in) == 1;
+          continue;
+        }
+        uint32_t cost = fn == GateFunction::Xor || fn == GateFunction::Xnor || fn == GateFunction::Lut
+                            ? std::min(cc0[in], cc1[in])
+                            : value ? cc1[in] : cc0[in];
+        if (pick == NoNet || (all ? cost > pickCost : cost < pickCost))
+        {
+          pick     = in;
+          pickCost = cost;
+        }
+      }
+      if (pick == NoNet)
+        return false;
+      if (fn == GateFunction::Xor || fn == GateFunction::Xnor)
+        value ^= parity;
+      else if (fn == GateFunction::Lut)
+        value = cc1[pick] < cc0[pick];
+      net = pick;
+    }
+    input = inputIndex[net];
+    state = value;
+    return true;
+  }
+
+  FaultStatus run(Fault f, size_t limit, std::vector<unsigned short>& cube)
+  {
+    fault = f;
+    if (distance[fault.net] == Unreachable)
+      return FaultStatus::Untestable;
+    collectCone();
+    values.assign(nl.nets(), Planes::broadcast(2));
+    nl.evaluate(values.data());
+    values[fault.net].setLane(1, fault.stuck);
+    cone.run(values.data(), fault.net, fault.net, 2, fault.stuck);
+
+    std::vector<Decision> decisions;
+    size_t backtracks = 0;
+    while (!detected())
+    {
+      NetId net;
+      unsigned short value;
+      uint32_t input;
+      if (objective(net, value) && backtrace(net, value, input, value))
+      {
+        decisions.push_back({input, value, false});
+        set(nl.inputs()[input], value);
+        continue;
+      }
+      while (!decisions.empty() && decisions.back().flipped)
+      {
+        set(nl.inputs()[decisions.back().input], 2);
+        decisions.pop_back();
+      }
+      if (decisions.empty())
+        return FaultStatus::Untestable;
+      if (++backtracks > limit)
+        return FaultStatus::Aborted;
+      decisions.back().flipped = true;
+      decisions.back().value ^= 1;
+      set(nl.inputs()[decisions.back().input], decisions.back().value);
+    }
+    cube.assign(nl.inputs().size(), 2);
+    for (auto const& d : decisions)
+      cube[d.input] = d.value;
+    return FaultStatus::Detected;
+  }
+};
+
+FaultStatus Atpg::generate(Fault fault, std::vector<unsigned short>& cube) const
+{
+  if (fault.net >= nl.nets() || fault.stuck > 1)
+    throw std::out_of_range("");
+  PodemSearch search(nl, cc0, cc1, distance, inputIndex);
+  return search.run(fault, backtrackLimit, cube);
+}
+
+AtpgResult Atpg::run() const { return run(stuckAtFaults(nl)); }
+
+AtpgResult Atpg::run(std::vector<Fault> const& faults) const
+{
+  size_t n = nl.inputs().size();
+  AtpgResult res{PatternSet(n), faults, std::vector<FaultStatus>(faults.size(), FaultStatus::Undetected)};
+  FaultSimulator sim(nl);
+  sim.threads = threads;
+  std::vector<uint32_t> first;
+
+  // Random vectors, keeping those that detect a fault first
+  {
+    StimulusGenerator gen(seed, n);
+    PatternSet random(n);
+    std::vector<Planes> blk(n);
+    std::vector<unsigned short> vec(n);
+    for (uint64_t b = 0; b < randomBlocks; b++)
+    {
+      gen.block(b, blk.data());
+      for (size_t lane = 0; lane < 64; lane++)
+      {
+        for (size_t i = 0; i < n; i++)
+          vec[i] = blk[i].lane(lane);
+        random.add(vec);
+      }
+    }
+    sim.run(random, res.faults, res.status, &first);
+    std::vector<bool> keep(random.size(), false);
+    for (auto p : first)
+      if (p != UINT32_MAX)
+        keep[p] = true;
+    for (size_t p = 0; p < random.size(); p++)
+      if (keep[p])
+        res.patterns.add(random.vector(p));
+  }
+
+  // PODEM rounds over the faults random vectors missed
+  unsigned count = threadCount(threads, faults.size());
+  std::mt19937_64 fill(seed);
+  std::vector<PodemSearch> searches;
+  for (unsigned t = 0; t < count; t++)
+    searches.emplace_back(nl, cc0, cc1, distance, inputIndex);
+  size_t next = 0;
+  while (true)
+  {
+    std::vector<size_t> targets;
+    for (; next < faults.size() && targets.size() < 64 * size_t(count); next++)
+      if (res.status[next] == FaultStatus::Undetected)
+        targets.push_back(next);
+    if (targets.empty())
+      break;
+    std::vector<std::vector<unsigned short>> cubes(targets.size());
+    std::atomic<size_t> claim{0};
+    auto work = [&](unsigned t) {
+      for (size_t i; (i = claim++) < targets.size();)
+      {
+        FaultStatus s = searches[t].run(faults[targets[i]], backtrackLimit, cubes[i]);
+        if (s != FaultStatus::Detected)
+        {
+          res.status[targets[i]] = s;
+          cubes[i].clear();
+        }
+      }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < count; t++)
+      pool.emplace_back(work, t);
+    work(0);
+    for (auto& thr : pool)
+      thr.join();
+
+    // Merge compatible cubes, fill the rest at random
+    std::vector<std::vector<unsigned short>> merged;
+    for (auto const& cube : cubes)
+    {
+      if (cube.empty())
+        continue;
+      auto fits = [&](std::vector<unsigned short> const& m) {
+        for (size_t i = 0; i < n; i++)
+          if (cube[i] != 2 && m[i] != 2 && cube[i] != m[i])
+            return false;
+        return true;
+      };
+      auto it = std::find_if(merged.begin(), merged.end(), fits);
+      if (it == merged.end())
+        merged.push_back(cube);
+      else
+        for (size_t i = 0; i < n; i++)
+          if (cube[i] != 2)
+            (*it)[i] = cube[i];
+    }
+    PatternSet batch(n);
+    for (auto& m : merged)
+    {
+      for (auto& s : m)
+        if (s == 2)
+          s = fill() & 1;
+      batch.add(m);
+    }
+    sim.run(batch, res.faults, res.status);
+    for (size_t p = 0; p < batch.size(); p++)
+      res.patterns.add(batch.vector(p));
+    // Cubes are sound, so this cannot happen; never leave a target behind
+    for (auto f : targets)
+      if (res.status[f] == FaultStatus::Undetected)
+        res.status[f] = FaultStatus::Aborted;
+  }
+
+  // Reverse-order compaction: keep vectors that first detect some fault
+  if (compact && res.patterns.size())
+  {
+    PatternSet reversed(n);
+    for (size_t p = res.patterns.size(); p-- > 0;)
+      reversed.add(res.patterns.vector(p));
+    std::vector<FaultStatus> status(faults.size());
+    for (size_t f = 0; f < faults.size(); f++)
+      status[f] = res.status[f] == FaultStatus::Detected ? FaultStatus::Undetected : res.status[f];
+    sim.run(reversed, res.faults, status, &first);
+    std::vector<bool> keep(reversed.size(), false);
+    for (auto p : first)
+      if (p != UINT32_MAX)
+        keep[p] = true;
+    PatternSet compacted(n);
+    for (size_t p = reversed.size(); p-- > 0;)
+      if (keep[p])
+        compacted.add(reversed.vector(p));
+    res.patterns = std::move(compacted);
+  }
+
+  for (auto s : res.status)
+  {
+    res.detected += s == FaultStatus::Detected;
+    res.untestable += s == FaultStatus::Untestable;
+    res.aborted += s == FaultStatus::Aborted;
+  }
+  return res;
+}
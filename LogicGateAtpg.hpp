@@ -0,0 +1,194 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+/**
+ *  Single stuck-at fault on a net
+ *
+ *  Faults sit on stems: every reader of the net sees the stuck value.
+ */
+struct Fault
+{
+  NetId net;
+  /**
+   *  Stuck value (0 or 1)
+   *
+   */
+  unsigned short stuck;
+};
+enum class FaultStatus : unsigned char
+{
+  Undetected,
+  Detected,
+  /**
+   *  Proven redundant: no input vector detects it
+   *
+   */
+  Untestable,
+  /**
+   *  Search gave up at the backtrack limit
+   *
+   */
+  Aborted
+};
+/**
+ *  Stuck-at-0 and stuck-at-1 of every net that is driven or a primary
+ *  input and is read by a gate or a primary output
+ *
+ */
+std::vector<Fault> stuckAtFaults(Netlist const& nl);
+/**
+ *  Input vectors packed 64 per block
+ *
+ *  Blocks are stored as one Planes per input, block-major, the layout of
+ *  StimulusGenerator::generate, so a block feeds Netlist::evaluate as is.
+ *  Lanes past size() in the last block are Low.
+ */
+class PatternSet
+{
+  size_t _inputs;
+  size_t count = 0;
+  std::vector<Planes> planes;
+
+public:
+  explicit PatternSet(size_t inputs = 0);
+  inline size_t inputs() const { return _inputs; }
+  inline size_t size() const { return count; }
+  inline size_t blocks() const { return (count + 63) / 64; }
+  /**
+   *  Planes of every input for vectors 64*b .. 64*b+63
+   *
+   */
+  inline Planes const* block(size_t b) const { return planes.data() + b * _inputs; }
+  /**
+   *  Lanes of block b holding vectors
+   *
+   */
+  inline uint64_t laneMask(size_t b) const { return count - 64 * b >= 64 ? ~0ULL : (1ULL << (count - 64 * b)) - 1; }
+  /**
+   *  Append vector
+   *
+   *  vec state of every input (0, 1 or 2)
+   */
+  void add(std::vector<unsigned short> const& vec);
+  /**
+   *  Vector n, state of every input
+   *
+   */
+  std::vector<unsigned short> vector(size_t n) const;
+  /**
+   *  Write the vectors to file name as a vector file of StimulusPipeline
+   *
+   *  The file replays through StimulusPipeline::run like any stimulus.
+   */
+  void save(std::string const& name) const;
+  /**
+   *  Read a vector file (as written by save)
+   *
+   *  inputs states per vector line
+   */
+  static PatternSet load(std::string const& name, size_t inputs);
+};
+/**
+ *  Bit-parallel stuck-at fault simulator
+ *
+ *  The good circuit is simulated once per block of 64 vectors; each fault
+ *  is then injected and propagated event-driven through its fanout cone
+ *  only, one level at a time, and compared at the primary outputs. A
+ *  detected fault is dropped from later blocks. Faults are dealt out to
+ *  threads round-robin, each thread running all blocks for its share.
+ */
+class FaultSimulator
+{
+  Netlist const& nl;
+
+public:
+  unsigned threads = 0;
+
+  explicit FaultSimulator(Netlist const& netlist);
+  /**
+   *  Simulate patterns against every fault still Undetected
+   *
+   *  status per fault, detected ones become Detected
+   *  first optional per fault: index of the first vector detecting it
+   *  size_t number of newly detected faults
+   */
+  size_t run(PatternSet const& patterns, std::vector<Fault> const& faults, std::vector<FaultStatus>& status,
+             std::vector<uint32_t>* first = nullptr) const;
+};
+/**
+ *  Outcome of test generation
+ *
+ */
+struct AtpgResult
+{
+  PatternSet patterns;
+  std::vector<Fault> faults;
+  std::vector<FaultStatus> status;
+  size_t detected   = 0;
+  size_t untestable = 0;
+  size_t aborted    = 0;
+  /**
+   *  Detected share of all faults
+   *
+   */
+  inline double coverage() const { return faults.empty() ? 1 : double(detected) / faults.size(); }
+};
+/**
+ *  Automatic test pattern generation for stuck-at faults
+ *
+ *  Random vectors go first and keep only those that detect a new fault.
+ *  PODEM then targets each remaining fault: the values of the good and the
+ *  faulty circuit travel as lanes 0 and 1 of one Planes per net, which is
+ *  the five-valued D-calculus (D = 1/0, D' = 0/1) with X kept per circuit.
+ *  Objectives come from fault activation or the D-frontier gate nearest to
+ *  an output with an X path, and are backtraced to a primary input along
+ *  SCOAP controllability. Faults are searched in parallel, 64 per thread
+ *  per round; the round's test cubes are merged where compatible, the
+ *  remaining X filled at random, and the vectors fault simulated to drop
+ *  every fault they detect. Finally reverse-order fault simulation removes
+ *  vectors whose faults are all detected by later ones.
+ */
+class Atpg
+{
+  Netlist const& nl;
+  std::vector<uint32_t> cc0;
+  std::vector<uint32_t> cc1;
+  /**
+   *  Gates from every net to the nearest primary output
+   *
+   */
+  std::vector<uint32_t> distance;
+  std::vector<int32_t> inputIndex;
+
+public:
+  uint64_t seed         = 1;
+  uint64_t randomBlocks = 16;
+  size_t backtrackLimit = 100;
+  unsigned threads      = 0;
+  bool compact          = true;
+
+  /**
+   *  Construct a new Atpg object (the netlist must not change afterwards)
+   *
+   */
+  explicit Atpg(Netlist const& netlist);
+  /**
+   *  Generate tests for every stuck-at fault of the netlist
+   *
+   */
+  AtpgResult run() const;
+  /**
+   *  Generate tests for the given faults
+   *
+   */
+  AtpgResult run(std::vector<Fault> const& faults) const;
+  /**
+   *  PODEM search for one fault
+   *
+   *  cube test cube on success, state of every input (2 - don't care)
+   *  FaultStatus Detected, Untestable or Aborted
+   */
+  FaultStatus generate(Fault fault, std::vector<unsigned short>& cube) const;
+};
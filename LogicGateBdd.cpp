@@ -0,0 +1,822 @@
+#include "LogicGateBdd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+
+BigCount::BigCount(uint64_t value) : limbs{uint32_t(value), uint32_t(value >> 32)} { trim(); }
+
+void BigCount::trim()
+{
+  while (!limbs.empty() && !limbs.back())
+    limbs.pop_back();
+}
+
+BigCount BigCount::power2(size_t n)
+{
+  BigCount res;
+  res.limbs.assign(n / 32 + 1, 0);
+  res.limbs.back() = 1u << (n % 32);
+  return res;
+}
+
+BigCount& BigCount::operator+=(BigCount const& rhs)
+{
+  if (limbs.size() < rhs.limbs.size())
+    limbs.resize(rhs.limbs.size(), 0);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < limbs.size(); i++)
+  {
+    carry += uint64_t(limbs[i]) + (i < rhs.limbs.size() ? rhs.limbs[i] : 0);
+    limbs[i] = uint32_t(carry);
+    carry >>= 32;
+  }
+  if (carry)
+    limbs.push_back(uint32_t(carry));
+  return *this;
+}
+
+BigCount BigCount::operator-(BigCount const& rhs) const
+{
+  BigCount res    = *this;
+  int64_t borrow  = 0;
+  for (size_t i = 0; i < res.limbs.size(); i++)
+  {
+    int64_t d     = int64_t(res.limbs[i]) - (i < rhs.limbs.size() ? rhs.limbs[i] : 0) - borrow;
+    borrow        = d < 0;
+    res.limbs[i]  = uint32_t(d + (borrow << 32));
+  }
+  res.trim();
+  return res;
+}
+
+BigCount BigCount::operator<<(size_t n) const
+{
+  if (limbs.empty())
+    return *this;
+  BigCount res;
+  res.limbs.assign(limbs.size() + n / 32 + 1, 0);
+  for (size_t i = 0; i < limbs.size(); i++)
+  {
+    uint64_t v = uint64_t(limbs[i]) << (n % 32);
+    res.limbs[i + n / 32] |= uint32_t(v);
+    res.limbs[i + n / 32 + 1] |= uint32_t(v >> 32);
+  }
+  res.trim();
+  return res;
+}
+
+BigCount BigCount::operator>>(size_t n) const
+{
+  BigCount res;
+  if (n / 32 >= limbs.size())
+    return res;
+  res.limbs.assign(limbs.size() - n / 32, 0);
+  for (size_t i = 0; i < res.limbs.size(); i++)
+  {
+    uint64_t v = limbs[i + n / 32];
+    if (i + n / 32 + 1 < limbs.size())
+      v |= uint64_t(limbs[i + n / 32 + 1]) << 32;
+    res.limbs[i] = uint32_t(v >> (n % 32));
+  }
+  res.trim();
+  return res;
+}
+
+double BigCount::toDouble() const
+{
+  double res = 0;
+  for (size_t i = limbs.size(); i-- > 0;)
+    res = res * 4294967296.0 + limbs[i];
+  return res;
+}
+
+std::string BigCount::toString() const
+{
+  if (limbs.empty())
+    return "0";
+  std::vector<uint32_t> digits = limbs;
+  std::string res;
+  while (!digits.empty())
+  {
+    // Divide by 10^9, the remainder gives nine decimal digits
+    uint64_t rem = 0;
+    for (size_t i = digits.size(); i-- > 0;)
+    {
+      uint64_t cur = rem << 32 | digits[i];
+      digits[i]    = uint32_t(cur / 1000000000);
+      rem          = cur % 1000000000;
+    }
+    while (!digits.empty() && !digits.back())
+      digits.pop_back();
+    for (int k = 0; k < 9 && (rem || !digits.empty()); k++, rem /= 10)
+      res.push_back(char('0' + rem % 10));
+  }
+  std::reverse(res.begin(), res.end());
+  return res;
+}
+
+static const uint32_t NoNode  = UINT32_MAX;
+static const uint32_t NoVar   = UINT32_MAX;
+static const uint32_t FreeVar = UINT32_MAX - 1;
+static const uint32_t One = 0, Zero = 1;
+
+enum CacheOp : uint32_t
+{
+  OpAnd = 1,
+  OpXor,
+  OpExists,
+  OpRestrict
+};
+
+static inline size_t mix(uint64_t a, uint64_t b, uint64_t c = 0)
+{
+  uint64_t h = (a * 0x9E3779B97F4A7C15ULL) ^ (b * 0xC2B2AE3D27D4EB4FULL) ^ (c * 0x165667B19E3779F9ULL);
+  return h ^ (h >> 29);
+}
+
+Bdd::Bdd(BddManager* manager, uint32_t edge) : mgr(manager), e(edge) { mgr->ref(e); }
+
+Bdd::Bdd(Bdd const& rhs) : mgr(rhs.mgr), e(rhs.e)
+{
+  if (mgr)
+    mgr->ref(e);
+}
+
+Bdd::Bdd(Bdd&& rhs) noexcept : mgr(rhs.mgr), e(rhs.e) { rhs.mgr = nullptr; }
+
+Bdd& Bdd::operator=(Bdd const& rhs)
+{
+  if (rhs.mgr)
+    rhs.mgr->ref(rhs.e);
+  if (mgr)
+    mgr->deref(e);
+  mgr = rhs.mgr;
+  e   = rhs.e;
+  return *this;
+}
+
+Bdd& Bdd::operator=(Bdd&& rhs) noexcept
+{
+  if (this != &rhs)
+  {
+    if (mgr)
+      mgr->deref(e);
+    mgr     = rhs.mgr;
+    e       = rhs.e;
+    rhs.mgr = nullptr;
+  }
+  return *this;
+}
+
+Bdd::~Bdd()
+{
+  if (mgr)
+    mgr->deref(e);
+}
+
+Bdd Bdd::operator~() const
+{
+  if (!mgr)
+    throw std::runtime_error("Empty BDD");
+  return mgr->wrap(e ^ 1);
+}
+
+Bdd Bdd::operator&(Bdd const& rhs) const
+{
+  if (!mgr)
+    throw std::runtime_error("Empty BDD");
+  mgr->check(rhs);
+  return mgr->wrap(mgr->guarded([&] { return mgr->andRec(e, rhs.e); }));
+}
+
+Bdd Bdd::operator|(Bdd const& rhs) const
+{
+  if (!mgr)
+    throw std::runtime_error("Empty BDD");
+  mgr->check(rhs);
+  return mgr->wrap(mgr->guarded([&] { return mgr->orRec(e, rhs.e); }));
+}
+
+Bdd Bdd::operator^(Bdd const& rhs) const
+{
+  if (!mgr)
+    throw std::runtime_error("Empty BDD");
+  mgr->check(rhs);
+  return mgr->wrap(mgr->guarded([&] { return mgr->xorRec(e, rhs.e); }));
+}
+
+BddManager::BddManager(size_t cacheSize)
+{
+  size_t n = 1;
+  while (n < cacheSize)
+    n <<= 1;
+  cache.assign(n, {0, 0, 0, 0});
+  nodes.push_back({NoVar, One, One, NoNode, 1});
+}
+
+Bdd BddManager::wrap(uint32_t e) { return Bdd(this, e); }
+
+void BddManager::check(Bdd const& f) const
+{
+  if (f.mgr != this)
+    throw std::runtime_error("BDD of another manager");
+}
+
+void BddManager::deref(uint32_t e)
+{
+  if (e >> 1)
+    nodes[e >> 1].ref--;
+}
+
+void BddManager::insert(uint32_t n)
+{
+  SubTable& t = tables[nodes[n].var];
+  if (t.count >= 2 * t.buckets.size())
+  {
+    std::vector<uint32_t> old(t.buckets.size() * 2, NoNode);
+    old.swap(t.buckets);
+    for (auto head : old)
+      for (uint32_t m = head, next; m != NoNode; m = next)
+      {
+        next          = nodes[m].next;
+        size_t h      = mix(nodes[m].hi, nodes[m].lo) & (t.buckets.size() - 1);
+        nodes[m].next = t.buckets[h];
+        t.buckets[h]  = m;
+      }
+  }
+  size_t h      = mix(nodes[n].hi, nodes[n].lo) & (t.buckets.size() - 1);
+  nodes[n].next = t.buckets[h];
+  t.buckets[h]  = n;
+  t.count++;
+}
+
+void BddManager::unlink(uint32_t n)
+{
+  SubTable& t    = tables[nodes[n].var];
+  uint32_t* link = &t.buckets[mix(nodes[n].hi, nodes[n].lo) & (t.buckets.size() - 1)];
+  while (*link != n)
+    link = &nodes[*link].next;
+  *link = nodes[n].next;
+  t.count--;
+}
+
+void BddManager::release(uint32_t n)
+{
+  std::vector<uint32_t> stack{n};
+  while (!stack.empty())
+  {
+    uint32_t m = stack.back();
+    stack.pop_back();
+    unlink(m);
+    nodes[m].var = FreeVar;
+    freeList.push_back(m);
+    for (uint32_t child : {nodes[m].hi >> 1, nodes[m].lo >> 1})
+      if (child && --nodes[child].ref == 0)
+        stack.push_back(child);
+  }
+}
+
+uint32_t BddManager::makeNode(uint32_t var, uint32_t hi, uint32_t lo)
+{
+  if (hi == lo)
+    return hi;
+  // The then-edge is kept regular; the complement moves to the result
+  uint32_t neg = hi & 1;
+  hi ^= neg;
+  lo ^= neg;
+  SubTable const& t = tables[var];
+  for (uint32_t n = t.buckets[mix(hi, lo) & (t.buckets.size() - 1)]; n != NoNode; n = nodes[n].next)
+    if (nodes[n].hi == hi && nodes[n].lo == lo)
+      return n << 1 | neg;
+  if (nodeLimit && size() >= nodeLimit)
+    throw BddOverflow();
+  uint32_t n;
+  if (freeList.empty())
+  {
+    n = nodes.size();
+    nodes.push_back({});
+  }
+  else
+  {
+    n = freeList.back();
+    freeList.pop_back();
+  }
+  nodes[n] = {var, hi, lo, NoNode, 0};
+  ref(hi);
+  ref(lo);
+  insert(n);
+  return n << 1 | neg;
+}
+
+void BddManager::enter()
+{
+  if (size() >= gcThreshold)
+  {
+    gc();
+    gcThreshold = std::max(gcThreshold, size() * 2);
+  }
+  if (autoReorder && size() > reorderThreshold)
+  {
+    reorder();
+    reorderThreshold = std::max(reorderThreshold, size() * 2);
+  }
+}
+
+bool BddManager::lookup(uint32_t op, uint32_t f, uint32_t g, uint32_t& res) const
+{
+  CacheEntry const& entry = cache[mix(op, f, g) & (cache.size() - 1)];
+  if (entry.op != op || entry.f != f || entry.g != g)
+    return false;
+  res = entry.res;
+  return true;
+}
+
+void BddManager::store(uint32_t op, uint32_t f, uint32_t g, uint32_t res)
+{
+  cache[mix(op, f, g) & (cache.size() - 1)] = {op, f, g, res};
+}
+
+uint32_t BddManager::andRec(uint32_t f, uint32_t g)
+{
+  if (f == Zero || g == Zero || f == (g ^ 1))
+    return Zero;
+  if (f == One || f == g)
+    return g;
+  if (g == One)
+    return f;
+  if (f > g)
+    std::swap(f, g);
+  uint32_t res;
+  if (lookup(OpAnd, f, g, res))
+    return res;
+  uint32_t lf = level(f), lg = level(g), top = std::min(lf, lg);
+  uint32_t t = andRec(lf == top ? hiOf(f) : f, lg == top ? hiOf(g) : g);
+  uint32_t e = andRec(lf == top ? loOf(f) : f, lg == top ? loOf(g) : g);
+  res        = makeNode(level2var[top], t, e);
+  store(OpAnd, f, g, res);
+  return res;
+}
+
+uint32_t BddManager::xorRec(uint32_t f, uint32_t g)
+{
+  // Complements factor out: ~a ^ b = ~(a ^ b)
+  uint32_t neg = (f ^ g) & 1;
+  f &= ~1u;
+  g &= ~1u;
+  if (f == g)
+    return Zero ^ neg;
+  if (f == One)
+    return g ^ 1 ^ neg;
+  if (g == One)
+    return f ^ 1 ^ neg;
+  if (f > g)
+    std::swap(f, g);
+  uint32_t res;
+  if (lookup(OpXor, f, g, res))
+    return res ^ neg;
+  uint32_t lf = level(f), lg = level(g), top = std::min(lf, lg);
+  uint32_t t = xorRec(lf == top ? hiOf(f) : f, lg == top ? hiOf(g) : g);
+  uint32_t e = xorRec(lf == top ? loOf(f) : f, lg == top ? loOf(g) : g);
+  res        = makeNode(level2var[top], t, e);
+  store(OpXor, f, g, res);
+  return res ^ neg;
+}
+
+uint32_t BddManager::existsRec(uint32_t f, uint32_t cube)
+{
+  if (f <= Zero)
+    return f;
+  uint32_t lf = level(f);
+  while (cube != One && level(cube) < lf)
+    cube = hiOf(cube);
+  if (cube == One)
+    return f;
+  uint32_t res;
+  if (lookup(OpExists, f, cube, res))
+    return res;
+  if (level(cube) == lf)
+  {
+    uint32_t rest = hiOf(cube);
+    res           = existsRec(hiOf(f), rest);
+    if (res != One)
+      res = orRec(res, existsRec(loOf(f), rest));
+  }
+  else
+    res = makeNode(nodes[f >> 1].var, existsRec(hiOf(f), cube), existsRec(loOf(f), cube));
+  store(OpExists, f, cube, res);
+  return res;
+}
+
+uint32_t BddManager::restrictRec(uint32_t f, uint32_t care)
+{
+  if (care <= Zero || f <= Zero)
+    return f;
+  if (f == care)
+    return One;
+  if (f == (care ^ 1))
+    return Zero;
+  uint32_t res;
+  if (lookup(OpRestrict, f, care, res))
+    return res;
+  uint32_t lf = level(f), lc = level(care);
+  if (lc < lf)
+    // f does not depend on the top care variable: quantify it away
+    res = restrictRec(f, orRec(hiOf(care), loOf(care)));
+  else
+  {
+    uint32_t c1 = lc == lf ? hiOf(care) : care, c0 = lc == lf ? loOf(care) : care;
+    if (c1 == Zero)
+      res = restrictRec(loOf(f), c0);
+    else if (c0 == Zero)
+      res = restrictRec(hiOf(f), c1);
+    else
+      res = makeNode(nodes[f >> 1].var, restrictRec(hiOf(f), c1), restrictRec(loOf(f), c0));
+  }
+  store(OpRestrict, f, care, res);
+  return res;
+}
+
+Bdd BddManager::newVar()
+{
+  uint32_t v = var2level.size();
+  var2level.push_back(v);
+  level2var.push_back(v);
+  tables.emplace_back();
+  tables.back().buckets.assign(16, NoNode);
+  return wrap(makeNode(v, One, Zero));
+}
+
+Bdd BddManager::var(uint32_t v)
+{
+  if (v >= vars())
+    throw std::out_of_range("");
+  return wrap(makeNode(v, One, Zero));
+}
+
+size_t BddManager::size(Bdd const& f) const
+{
+  check(f);
+  std::vector<char> seen(nodes.size(), 0);
+  std::vector<uint32_t> stack{f.e >> 1};
+  size_t res = 0;
+  while (!stack.empty())
+  {
+    uint32_t n = stack.back();
+    stack.pop_back();
+    if (seen[n])
+      continue;
+    seen[n] = 1;
+    res++;
+    if (n)
+    {
+      stack.push_back(nodes[n].hi >> 1);
+      stack.push_back(nodes[n].lo >> 1);
+    }
+  }
+  return res;
+}
+
+Bdd BddManager::ite(Bdd const& f, Bdd const& g, Bdd const& h)
+{
+  check(f);
+  check(g);
+  check(h);
+  return wrap(guarded([&] { return orRec(andRec(f.e, g.e), andRec(f.e ^ 1, h.e)); }));
+}
+
+Bdd BddManager::cube(std::vector<uint32_t> const& vars)
+{
+  for (auto v : vars)
+    if (v >= this->vars())
+      throw std::out_of_range("");
+  return wrap(guarded([&] {
+    uint32_t res = One;
+    for (auto v : vars)
+      res = andRec(res, makeNode(v, One, Zero));
+    return res;
+  }));
+}
+
+Bdd BddManager::exists(Bdd const& f, Bdd const& cube)
+{
+  check(f);
+  check(cube);
+  return wrap(guarded([&] { return existsRec(f.e, cube.e); }));
+}
+
+Bdd BddManager::forall(Bdd const& f, Bdd const& cube)
+{
+  check(f);
+  check(cube);
+  return wrap(guarded([&] { return existsRec(f.e ^ 1, cube.e) ^ 1; }));
+}
+
+Bdd BddManager::restrict(Bdd const& f, Bdd const& care)
+{
+  check(f);
+  check(care);
+  return wrap(guarded([&] { return restrictRec(f.e, care.e); }));
+}
+
+Bdd BddManager::cofactor(Bdd const& f, uint32_t v, bool value)
+{
+  check(f);
+  if (v >= vars())
+    throw std::out_of_range("");
+  // Restricting to a literal is the exact cofactor
+  return wrap(guarded([&] { return restrictRec(f.e, makeNode(v, One, Zero) ^ !value); }));
+}
+
+Bdd BddManager::compose(Bdd const& f, uint32_t v, Bdd const& g)
+{
+  check(f);
+  check(g);
+  if (v >= vars())
+    throw std::out_of_range("");
+  return wrap(guarded([&] {
+    uint32_t x  = makeNode(v, One, Zero);
+    uint32_t f1 = restrictRec(f.e, x), f0 = restrictRec(f.e, x ^ 1);
+    return orRec(andRec(g.e, f1), andRec(g.e ^ 1, f0));
+  }));
+}
+
+std::vector<uint32_t> BddManager::support(Bdd const& f) const
+{
+  check(f);
+  std::vector<char> seen(nodes.size(), 0), used(vars(), 0);
+  std::vector<uint32_t> stack{f.e >> 1};
+  while (!stack.empty())
+  {
+    uint32_t n = stack.back();
+    stack.pop_back();
+    if (!n || seen[n])
+      continue;
+    seen[n]              = 1;
+    used[nodes[n].var]   = 1;
+    stack.push_back(nodes[n].hi >> 1);
+    stack.push_back(nodes[n].lo >> 1);
+  }
+  std::vector<uint32_t> res;
+  for (uint32_t v = 0; v < vars(); v++)
+    if (used[v])
+      res.push_back(v);
+  return res;
+}
+
+BigCount BddManager::satCount(Bdd const& f) const
+{
+  check(f);
+  uint32_t n = vars();
+  auto levelOfEdge = [&](uint32_t e) { return std::min<uint32_t>(level(e), n); };
+  // Count of a regular node over the variables at and below its level
+  std::unordered_map<uint32_t, BigCount> memo;
+  std::function<BigCount(uint32_t)> node;
+  auto edge = [&](uint32_t e) {
+    BigCount c = node(e >> 1);
+    return e & 1 ? BigCount::power2(n - levelOfEdge(e)) - c : c;
+  };
+  node = [&](uint32_t m) -> BigCount {
+    if (!m)
+      return BigCount(1);
+    auto it = memo.find(m);
+    if (it != memo.end())
+      return it->second;
+    uint32_t lvl = var2level[nodes[m].var];
+    uint32_t hi = nodes[m].hi, lo = nodes[m].lo;
+    BigCount res = edge(hi) << (levelOfEdge(hi) - lvl - 1);
+    res += edge(lo) << (levelOfEdge(lo) - lvl - 1);
+    return memo[m] = res;
+  };
+  return edge(f.e) << levelOfEdge(f.e);
+}
+
+BigCount BddManager::satCount(Bdd const& f, size_t n) const
+{
+  if (n > vars())
+    return satCount(f) << (n - vars());
+  return satCount(f) >> (vars() - n);
+}
+
+std::vector<unsigned short> BddManager::pickOne(Bdd const& f) const
+{
+  check(f);
+  if (f.isZero())
+    return {};
+  std::vector<unsigned short> res(vars(), 2);
+  for (uint32_t e = f.e; e > Zero;)
+  {
+    uint32_t v = nodes[e >> 1].var;
+    if (loOf(e) != Zero)
+    {
+      res[v] = 0;
+      e      = loOf(e);
+    }
+    else
+    {
+      res[v] = 1;
+      e      = hiOf(e);
+    }
+  }
+  return res;
+}
+
+Bdd BddManager::gate(GateType const& type, size_t k, std::vector<Bdd> const& inputs)
+{
+  if (inputs.size() != type.inputs() || k >= type.outputs())
+    throw std::runtime_error("Inputs do not match the gate type");
+  for (auto const& in : inputs)
+    check(in);
+  GateFunction fn = type.function();
+  if (fn == GateFunction::Lut)
+  {
+    // Shannon expansion on the highest input over halves of the table
+    std::function<uint32_t(size_t, uint64_t)> lut = [&](size_t n, uint64_t table) -> uint32_t {
+      if (!n)
+        return table & 1 ? One : Zero;
+      size_t half  = size_t(1) << (n - 1);
+      uint32_t x   = inputs[n - 1].e;
+      uint32_t t   = lut(n - 1, table >> half);
+      uint32_t e   = lut(n - 1, table & ((1ULL << half) - 1));
+      return orRec(andRec(x, t), andRec(x ^ 1, e));
+    };
+    uint64_t used = type.inputs() == 6 ? ~0ULL : (1ULL << (1u << type.inputs())) - 1;
+    return wrap(guarded([&] { return lut(type.inputs(), type.table(k) & used); }));
+  }
+  bool isOr  = fn == GateFunction::Or || fn == GateFunction::Nor;
+  bool isXor = fn == GateFunction::Xor || fn == GateFunction::Xnor;
+  bool inv   = fn == GateFunction::Not || fn == GateFunction::Nand || fn == GateFunction::Nor || fn == GateFunction::Xnor;
+  return wrap(guarded([&] {
+    uint32_t res = isOr ? Zero : isXor ? Zero : One;
+    for (auto const& in : inputs)
+      res = isOr ? orRec(res, in.e) : isXor ? xorRec(res, in.e) : andRec(res, in.e);
+    return res ^ inv;
+  }));
+}
+
+size_t BddManager::gc()
+{
+  size_t before = size();
+  for (uint32_t n = 1; n < nodes.size(); n++)
+    if (nodes[n].var != FreeVar && !nodes[n].ref)
+      release(n);
+  std::fill(cache.begin(), cache.end(), CacheEntry{0, 0, 0, 0});
+  return before - size();
+}
+
+void BddManager::swap(uint32_t lvl)
+{
+  uint32_t x = level2var[lvl], y = level2var[lvl + 1];
+  // Nodes of x with a y child are rebuilt in place as y nodes
+  std::vector<uint32_t> moving;
+  SubTable& tx = tables[x];
+  for (auto& head : tx.buckets)
+    for (uint32_t* link = &head; *link != NoNode;)
+    {
+      uint32_t n = *link;
+      if (nodes[nodes[n].hi >> 1].var == y || nodes[nodes[n].lo >> 1].var == y)
+      {
+        *link = nodes[n].next;
+        tx.count--;
+        moving.push_back(n);
+      }
+      else
+        link = &nodes[n].next;
+    }
+  for (auto n : moving)
+  {
+    uint32_t f1 = nodes[n].hi, f0 = nodes[n].lo;
+    bool y1 = nodes[f1 >> 1].var == y, y0 = nodes[f0 >> 1].var == y;
+    uint32_t f11 = y1 ? hiOf(f1) : f1, f10 = y1 ? loOf(f1) : f1;
+    uint32_t f01 = y0 ? hiOf(f0) : f0, f00 = y0 ? loOf(f0) : f0;
+    uint32_t t = makeNode(x, f11, f01);
+    ref(t);
+    uint32_t e = makeNode(x, f10, f00);
+    ref(e);
+    nodes[n].var = y;
+    nodes[n].hi  = t;
+    nodes[n].lo  = e;
+    insert(n);
+    for (uint32_t old : {f1 >> 1, f0 >> 1})
+      if (old && --nodes[old].ref == 0)
+        release(old);
+  }
+  std::swap(level2var[lvl], level2var[lvl + 1]);
+  var2level[x] = lvl + 1;
+  var2level[y] = lvl;
+}
+
+void BddManager::sift(uint32_t var)
+{
+  uint32_t lvl = var2level[var], bestLvl = lvl;
+  size_t best  = size();
+  auto moved   = [&]() {
+    if (size() < best)
+    {
+      best    = size();
+      bestLvl = lvl;
+      return true;
+    }
+    return size() <= best * maxGrowth;
+  };
+  while (lvl + 1 < vars())
+  {
+    swap(lvl++);
+    if (!moved())
+      break;
+  }
+  while (lvl > 0)
+  {
+    swap(--lvl);
+    if (!moved())
+      break;
+  }
+  while (lvl < bestLvl)
+    swap(lvl++);
+  while (lvl > bestLvl)
+    swap(--lvl);
+}
+
+void BddManager::reorder()
+{
+  gc();
+  // Swaps create nodes; the limit must not abort one half way
+  size_t limit = nodeLimit;
+  nodeLimit    = 0;
+  std::vector<uint32_t> order(vars());
+  for (uint32_t v = 0; v < vars(); v++)
+    order[v] = v;
+  std::sort(order.begin(), order.end(),
+            [this](uint32_t a, uint32_t b) { return tables[a].count > tables[b].count; });
+  for (auto v : order)
+    sift(v);
+  nodeLimit = limit;
+  std::fill(cache.begin(), cache.end(), CacheEntry{0, 0, 0, 0});
+}
+
+std::vector<Bdd> coneBdds(BddManager& mgr, Netlist const& nl, std::vector<NetId> const& roots)
+{
+  while (mgr.vars() < nl.inputs().size())
+    mgr.newVar();
+  std::vector<Bdd> values(nl.nets());
+  for (size_t i = 0; i < nl.inputs().size(); i++)
+    values[nl.inputs()[i]] = mgr.var(i);
+
+  // Gates of the cones, and how many of them still read every net
+  std::vector<char> seen(nl.nets(), 0), inCone(nl.gates(), 0), isRoot(nl.nets(), 0);
+  std::vector<uint32_t> readers(nl.nets(), 0);
+  std::vector<NetId> stack;
+  for (auto net : roots)
+  {
+    isRoot.at(net) = 1;
+    stack.push_back(net);
+  }
+  while (!stack.empty())
+  {
+    NetId net = stack.back();
+    stack.pop_back();
+    if (seen[net])
+      continue;
+    seen[net]  = 1;
+    uint32_t g = nl.driver(net);
+    if (g == NoGate)
+    {
+      if (!values[net].manager())
+        values[net] = mgr.newVar();
+      continue;
+    }
+    if (inCone[g])
+      continue;
+    inCone[g]         = 1;
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      readers[nl.pin(g, t.inputTerminal(k))]++;
+      stack.push_back(nl.pin(g, t.inputTerminal(k)));
+    }
+  }
+
+  std::vector<Bdd> in;
+  for (auto g : nl.order())
+  {
+    if (!inCone[g])
+      continue;
+    GateType const& t = nl.type(g);
+    in.clear();
+    for (size_t k = 0; k < t.inputs(); k++)
+      in.push_back(values[nl.pin(g, t.inputTerminal(k))]);
+    for (size_t k = 0; k < t.outputs(); k++)
+      values[nl.pin(g, t.outputTerminal(k))] = mgr.gate(t, k, in);
+    // Drop fanin functions nobody else needs, so their nodes can be collected
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      NetId net = nl.pin(g, t.inputTerminal(k));
+      if (!--readers[net] && !isRoot[net])
+        values[net] = Bdd();
+    }
+  }
+  std::vector<Bdd> res;
+  for (auto net : roots)
+    res.push_back(values[net]);
+  return res;
+}
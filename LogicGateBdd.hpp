@@ -0,0 +1,298 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+/**
+ *  Unsigned integer of any size (exact model counts)
+ *
+ */
+class BigCount
+{
+  /**
+   *  Base 2^32 digits, least significant first, no leading zeros
+   *
+   */
+  std::vector<uint32_t> limbs;
+
+  void trim();
+
+public:
+  BigCount(uint64_t value = 0);
+  static BigCount power2(size_t n);
+  BigCount& operator+=(BigCount const& rhs);
+  /**
+   *  Difference (rhs must not exceed this)
+   *
+   */
+  BigCount operator-(BigCount const& rhs) const;
+  BigCount operator<<(size_t n) const;
+  BigCount operator>>(size_t n) const;
+  inline bool operator==(BigCount const& rhs) const { return limbs == rhs.limbs; }
+  inline bool operator!=(BigCount const& rhs) const { return limbs != rhs.limbs; }
+  double toDouble() const;
+  std::string toString() const;
+};
+/**
+ *  Raised when a BDD operation would exceed the node limit
+ *
+ */
+struct BddOverflow : std::runtime_error
+{
+  BddOverflow() : std::runtime_error("BDD node limit exceeded") {}
+};
+
+class BddManager;
+/**
+ *  Reference to a BDD node of a manager (keeps it alive)
+ *
+ *  Equal functions of one manager have equal edges, so == is an exact
+ *  equivalence test. Handles must not outlive their manager.
+ */
+class Bdd
+{
+  friend class BddManager;
+  BddManager* mgr = nullptr;
+  uint32_t e      = 0;
+
+  Bdd(BddManager* manager, uint32_t edge);
+
+public:
+  Bdd() = default;
+  Bdd(Bdd const& rhs);
+  Bdd(Bdd&& rhs) noexcept;
+  Bdd& operator=(Bdd const& rhs);
+  Bdd& operator=(Bdd&& rhs) noexcept;
+  ~Bdd();
+  inline BddManager* manager() const { return mgr; }
+  /**
+   *  Node index << 1 | complement bit (0 - constant one, 1 - zero)
+   *
+   */
+  inline uint32_t edge() const { return e; }
+  inline bool isOne() const { return e == 0; }
+  inline bool isZero() const { return e == 1; }
+  inline bool isConstant() const { return e <= 1; }
+  inline bool operator==(Bdd const& rhs) const { return mgr == rhs.mgr && e == rhs.e; }
+  inline bool operator!=(Bdd const& rhs) const { return !(*this == rhs); }
+  Bdd operator~() const;
+  Bdd operator&(Bdd const& rhs) const;
+  Bdd operator|(Bdd const& rhs) const;
+  Bdd operator^(Bdd const& rhs) const;
+  inline Bdd& operator&=(Bdd const& rhs) { return *this = *this & rhs; }
+  inline Bdd& operator|=(Bdd const& rhs) { return *this = *this | rhs; }
+  inline Bdd& operator^=(Bdd const& rhs) { return *this = *this ^ rhs; }
+};
+/**
+ *  Reduced ordered binary decision diagrams
+ *
+ *  Nodes are hash-consed in one unique subtable per variable; an edge
+ *  carries a complement bit and the then-edge of a node is never
+ *  complemented, so every function has exactly one edge. Recursive
+ *  operations memoize in a direct-mapped computed table. Nodes are
+ *  reference counted; unreferenced ones stay cached until a garbage
+ *  collection, which runs between top-level operations once enough of
+ *  them pile up. reorder() sifts every variable through all levels by
+ *  swapping adjacent levels in place, so handles stay valid.
+ */
+class BddManager
+{
+  friend class Bdd;
+  struct Node
+  {
+    uint32_t var;
+    uint32_t hi;
+    uint32_t lo;
+    uint32_t next;
+    uint32_t ref;
+  };
+  struct SubTable
+  {
+    std::vector<uint32_t> buckets;
+    size_t count = 0;
+  };
+  struct CacheEntry
+  {
+    uint32_t op;
+    uint32_t f;
+    uint32_t g;
+    uint32_t res;
+  };
+  std::vector<Node> nodes;
+  std::vector<uint32_t> freeList;
+  std::vector<SubTable> tables;
+  std::vector<uint32_t> var2level;
+  std::vector<uint32_t> level2var;
+  std::vector<CacheEntry> cache;
+  size_t gcThreshold = 1 << 16;
+
+  inline uint32_t level(uint32_t e) const
+  {
+    uint32_t v = nodes[e >> 1].var;
+    return v < var2level.size() ? var2level[v] : UINT32_MAX;
+  }
+  inline uint32_t hiOf(uint32_t e) const { return nodes[e >> 1].hi ^ (e & 1); }
+  inline uint32_t loOf(uint32_t e) const { return nodes[e >> 1].lo ^ (e & 1); }
+  inline void ref(uint32_t e) { nodes[e >> 1].ref++; }
+  void deref(uint32_t e);
+  uint32_t makeNode(uint32_t var, uint32_t hi, uint32_t lo);
+  void insert(uint32_t n);
+  void unlink(uint32_t n);
+  void release(uint32_t n);
+  void enter();
+  /**
+   *  Run an operation; if it hits nodeLimit while dead nodes are waiting
+   *  for gc(), collect them and run it once more
+   *
+   */
+  template <class Op> uint32_t guarded(Op op)
+  {
+    enter();
+    try
+    {
+      return op();
+    }
+    catch (BddOverflow const&)
+    {
+      if (!gc())
+        throw;
+      return op();
+    }
+  }
+  bool lookup(uint32_t op, uint32_t f, uint32_t g, uint32_t& res) const;
+  void store(uint32_t op, uint32_t f, uint32_t g, uint32_t res);
+  uint32_t andRec(uint32_t f, uint32_t g);
+  uint32_t xorRec(uint32_t f, uint32_t g);
+  uint32_t existsRec(uint32_t f, uint32_t cube);
+  uint32_t restrictRec(uint32_t f, uint32_t care);
+  inline uint32_t orRec(uint32_t f, uint32_t g) { return andRec(f ^ 1, g ^ 1) ^ 1; }
+  void swap(uint32_t lvl);
+  void sift(uint32_t var);
+  Bdd wrap(uint32_t e);
+  void check(Bdd const& f) const;
+
+public:
+  /**
+   *  Live node limit (0 - unlimited); exceeding it throws BddOverflow
+   *
+   */
+  size_t nodeLimit = 0;
+  /**
+   *  Reorder between operations once the live nodes exceed the threshold
+   *
+   */
+  bool autoReorder        = false;
+  size_t reorderThreshold = 1 << 12;
+  /**
+   *  Sifting gives up a direction once size exceeds best by this factor
+   *
+   */
+  double maxGrowth = 1.2;
+
+  /**
+   *  Construct an empty manager
+   *
+   *  cacheSize computed table entries (rounded up to a power of two)
+   */
+  explicit BddManager(size_t cacheSize = 1 << 18);
+  BddManager(BddManager const&) = delete;
+  BddManager& operator=(BddManager const&) = delete;
+  inline Bdd one() { return wrap(0); }
+  inline Bdd zero() { return wrap(1); }
+  /**
+   *  Add variable at the bottom level
+   *
+   *  Bdd its projection function
+   */
+  Bdd newVar();
+  /**
+   *  Projection function of variable v
+   *
+   */
+  Bdd var(uint32_t v);
+  inline size_t vars() const { return var2level.size(); }
+  inline uint32_t levelOf(uint32_t v) const { return var2level.at(v); }
+  inline uint32_t varAt(uint32_t lvl) const { return level2var.at(lvl); }
+  /**
+   *  Nodes currently allocated (including unreferenced ones not yet collected)
+   *
+   */
+  inline size_t size() const { return nodes.size() - freeList.size() - 1; }
+  /**
+   *  Nodes of the diagram of f
+   *
+   */
+  size_t size(Bdd const& f) const;
+  Bdd ite(Bdd const& f, Bdd const& g, Bdd const& h);
+  /**
+   *  Conjunction of the positive literals of vars
+   *
+   */
+  Bdd cube(std::vector<uint32_t> const& vars);
+  /**
+   *  Existential / universal quantification of the variables of cube
+   *
+   */
+  Bdd exists(Bdd const& f, Bdd const& cube);
+  Bdd forall(Bdd const& f, Bdd const& cube);
+  /**
+   *  Generalized cofactor: a function equal to f wherever care holds, with
+   *  the rest used as don't cares to shrink the diagram (Coudert-Madre)
+   *
+   */
+  Bdd restrict(Bdd const& f, Bdd const& care);
+  Bdd cofactor(Bdd const& f, uint32_t v, bool value);
+  /**
+   *  f with variable v replaced by g
+   *
+   */
+  Bdd compose(Bdd const& f, uint32_t v, Bdd const& g);
+  /**
+   *  Variables f depends on, ascending
+   *
+   */
+  std::vector<uint32_t> support(Bdd const& f) const;
+  /**
+   *  Satisfying assignments of f over all variables of the manager
+   *
+   */
+  BigCount satCount(Bdd const& f) const;
+  /**
+   *  Satisfying assignments of f over n variables (n >= support size)
+   *
+   */
+  BigCount satCount(Bdd const& f, size_t n) const;
+  /**
+   *  One satisfying assignment: state of every variable (2 - don't care),
+   *  empty if f is zero
+   *
+   */
+  std::vector<unsigned short> pickOne(Bdd const& f) const;
+  /**
+   *  Function of output k of a gate type over the given inputs (packed order)
+   *
+   */
+  Bdd gate(GateType const& type, size_t k, std::vector<Bdd> const& inputs);
+  /**
+   *  Free unreferenced nodes and flush the computed table
+   *
+   *  size_t nodes freed
+   */
+  size_t gc();
+  /**
+   *  Sift every variable to a locally best level
+   *
+   */
+  void reorder();
+};
+/**
+ *  BDDs of nets of a netlist
+ *
+ *  Primary input i is variable i; every other undriven net in the cones
+ *  gets a new variable. Only the gates in the cones of roots are built.
+ *
+ *  std::vector<Bdd> function of every root
+ */
+std::vector<Bdd> coneBdds(BddManager& mgr, Netlist const& nl, std::vector<NetId> const& roots);
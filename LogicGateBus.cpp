@@ -0,0 +1,407 @@
+#include "LogicGateBus.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+Bus::Bus(size_t width, unsigned short state) : _width(width), _words((width + 63) / 64, Planes::broadcast(state))
+{
+  if (!width)
+    throw std::runtime_error("Bus width must be positive");
+  trim();
+}
+
+Bus Bus::value(size_t width, uint64_t value)
+{
+  Bus res(width, 0);
+  res._words[0].val = value;
+  res.trim();
+  return res;
+}
+
+static uint64_t topMask(size_t width) { return width % 64 ? (1ULL << (width % 64)) - 1 : ~0ULL; }
+
+void Bus::trim()
+{
+  _words.back().val &= topMask(_width);
+  _words.back().unk &= topMask(_width);
+}
+
+bool Bus::known() const
+{
+  for (auto const& w : _words)
+    if (w.unk)
+      return false;
+  return true;
+}
+
+unsigned short Bus::at(size_t n) const
+{
+  if (n >= _width)
+    throw std::out_of_range("");
+  return _words[n / 64].lane(n % 64);
+}
+
+void Bus::set(size_t n, unsigned short state)
+{
+  if (n >= _width)
+    throw std::out_of_range("");
+  _words[n / 64].setLane(n % 64, state);
+}
+
+/**
+ *  64 bits of words starting at bit lsb
+ *
+ */
+static Planes extract(std::vector<Planes> const& words, size_t lsb)
+{
+  size_t w = lsb / 64, s = lsb % 64;
+  Planes res{words[w].val >> s, words[w].unk >> s};
+  if (s && w + 1 < words.size())
+  {
+    res.val |= words[w + 1].val << (64 - s);
+    res.unk |= words[w + 1].unk << (64 - s);
+  }
+  return res;
+}
+
+Bus Bus::slice(size_t lsb, size_t width) const
+{
+  if (!width || lsb + width > _width)
+    throw std::out_of_range("");
+  Bus res(width);
+  for (size_t n = 0; n < res._words.size(); n++)
+    res._words[n] = extract(_words, lsb + n * 64);
+  res.trim();
+  return res;
+}
+
+void Bus::assign(size_t lsb, Bus const& part)
+{
+  if (lsb + part._width > _width)
+    throw std::out_of_range("");
+  for (size_t done = 0; done < part._width;)
+  {
+    size_t bit = lsb + done, w = bit / 64, s = bit % 64;
+    size_t n      = std::min<size_t>(64 - s, part._width - done);
+    Planes src    = extract(part._words, done);
+    uint64_t mask = (n == 64 ? ~0ULL : (1ULL << n) - 1) << s;
+    _words[w].val = (_words[w].val & ~mask) | (src.val << s & mask);
+    _words[w].unk = (_words[w].unk & ~mask) | (src.unk << s & mask);
+    done += n;
+  }
+}
+
+bool Bus::operator==(Bus const& rhs) const { return _width == rhs._width && _words == rhs._words; }
+
+std::ostream& operator<<(std::ostream& stream, Bus const& bus)
+{
+  for (size_t n = bus._width; n-- > 0;)
+    stream << "01X"[bus.at(n)];
+  return stream;
+}
+
+BusView::BusView(Bus& target, size_t low, size_t width) : bus(target), lsb(low), _width(width)
+{
+  if (!width || low + width > target.width())
+    throw std::out_of_range("");
+}
+
+BusView& BusView::operator=(Bus const& part)
+{
+  if (part.width() != _width)
+    throw std::runtime_error("Bus widths differ");
+  bus.assign(lsb, part);
+  return *this;
+}
+
+unsigned short BusView::at(size_t n) const
+{
+  if (n >= _width)
+    throw std::out_of_range("");
+  return bus.at(lsb + n);
+}
+
+void BusView::set(size_t n, unsigned short state)
+{
+  if (n >= _width)
+    throw std::out_of_range("");
+  bus.set(lsb + n, state);
+}
+
+Bus concat(std::initializer_list<Bus> parts)
+{
+  size_t width = 0;
+  for (auto const& part : parts)
+    width += part.width();
+  Bus res(width);
+  for (auto const& part : parts)
+    res.assign(width -= part.width(), part);
+  return res;
+}
+
+static void checkWidths(Bus const& a, Bus const& b)
+{
+  if (a.width() != b.width())
+    throw std::runtime_error("Bus widths differ");
+}
+
+/**
+ *  Per-word three-valued combination from the known-one and known-zero
+ *  masks of the result
+ *
+ */
+template <typename F>
+static Bus combine(Bus const& a, Bus const& b, F f)
+{
+  checkWidths(a, b);
+  Bus res(a.width());
+  for (size_t n = 0; n < a.words(); n++)
+  {
+    Planes const &x = a.word(n), &y = b.word(n);
+    uint64_t one, zero;
+    f(x.val & ~x.unk, ~x.val & ~x.unk, y.val & ~y.unk, ~y.val & ~y.unk, one, zero);
+    res.word(n) = {one, ~(one | zero)};
+  }
+  // Bits above the width must stay 0 in both planes
+  res.word(a.words() - 1).val &= topMask(a.width());
+  res.word(a.words() - 1).unk &= topMask(a.width());
+  return res;
+}
+
+Bus operator&(Bus const& a, Bus const& b)
+{
+  return combine(a, b, [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t& one, uint64_t& zero) {
+    one  = a1 & b1;
+    zero = a0 | b0;
+  });
+}
+
+Bus operator|(Bus const& a, Bus const& b)
+{
+  return combine(a, b, [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t& one, uint64_t& zero) {
+    one  = a1 | b1;
+    zero = a0 & b0;
+  });
+}
+
+Bus operator^(Bus const& a, Bus const& b)
+{
+  return combine(a, b, [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t& one, uint64_t& zero) {
+    one  = (a1 & b0) | (a0 & b1);
+    zero = (a1 & b1) | (a0 & b0);
+  });
+}
+
+Bus operator~(Bus const& a)
+{
+  return combine(a, a, [](uint64_t a1, uint64_t a0, uint64_t, uint64_t, uint64_t& one, uint64_t& zero) {
+    one  = a0;
+    zero = a1;
+  });
+}
+
+Bus add(Bus const& a, Bus const& b, unsigned short carry)
+{
+  checkWidths(a, b);
+  Bus res(a.width(), 0);
+  // Lowest bit any X operand can reach
+  size_t firstX = carry > 1 ? 0 : a.width();
+  for (size_t n = 0; n < a.words() && firstX == a.width(); n++)
+  {
+    uint64_t unk = a.word(n).unk | b.word(n).unk;
+    if (unk)
+      firstX = n * 64 + __builtin_ctzll(unk);
+  }
+  uint64_t c = carry == 1;
+  for (size_t n = 0; n < a.words(); n++)
+  {
+    uint64_t x = a.word(n).val, y = b.word(n).val;
+    uint64_t s = x + y;
+    uint64_t o = s < x;
+    s += c;
+    o |= s < c;
+    res.word(n).val = s;
+    c               = o;
+  }
+  for (size_t n = firstX / 64; n < a.words(); n++)
+  {
+    size_t low    = n * 64;
+    uint64_t mask = firstX <= low ? ~0ULL : ~((1ULL << (firstX - low)) - 1);
+    res.word(n).val &= ~mask;
+    res.word(n).unk |= mask;
+  }
+  res.word(a.words() - 1).val &= topMask(a.width());
+  res.word(a.words() - 1).unk &= topMask(a.width());
+  return res;
+}
+
+Bus sub(Bus const& a, Bus const& b) { return add(a, ~b, 1); }
+
+unsigned short eq(Bus const& a, Bus const& b)
+{
+  checkWidths(a, b);
+  bool unknown = false;
+  for (size_t n = 0; n < a.words(); n++)
+  {
+    Planes const &x = a.word(n), &y = b.word(n);
+    if ((x.val ^ y.val) & ~x.unk & ~y.unk)
+      return 0;
+    unknown = unknown || x.unk || y.unk;
+  }
+  return unknown ? 2 : 1;
+}
+
+unsigned short lt(Bus const& a, Bus const& b)
+{
+  checkWidths(a, b);
+  if (!a.known() || !b.known())
+    return 2;
+  for (size_t n = a.words(); n-- > 0;)
+    if (a.word(n).val != b.word(n).val)
+      return a.word(n).val < b.word(n).val;
+  return 0;
+}
+
+Bus mux(unsigned short sel, Bus const& a, Bus const& b)
+{
+  checkWidths(a, b);
+  if (sel == 0)
+    return a;
+  if (sel == 1)
+    return b;
+  return combine(a, b, [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t& one, uint64_t& zero) {
+    one  = a1 & b1;
+    zero = a0 & b0;
+  });
+}
+
+uint32_t Datapath::addBus(size_t width)
+{
+  if (!width)
+    throw std::runtime_error("Bus width must be positive");
+  widths.push_back(width);
+  driven.push_back(0);
+  read.push_back(0);
+  return widths.size() - 1;
+}
+
+void Datapath::addOp(BusOp op, std::vector<uint32_t> args, uint32_t out, size_t param)
+{
+  if (out >= widths.size())
+    throw std::out_of_range("");
+  for (auto arg : args)
+    if (arg >= widths.size())
+      throw std::out_of_range("");
+  if (driven[out])
+    throw std::runtime_error("Net has two drivers");
+  size_t w = widths[out];
+  auto same = [&](size_t from) {
+    for (size_t i = from; i < args.size(); i++)
+      if (widths[args[i]] != w)
+        return false;
+    return true;
+  };
+  bool ok = false;
+  switch (op)
+  {
+  case BusOp::Not:
+    ok = args.size() == 1 && same(0);
+    break;
+  case BusOp::And:
+  case BusOp::Or:
+  case BusOp::Xor:
+  case BusOp::Add:
+  case BusOp::Sub:
+    ok = args.size() == 2 && same(0);
+    break;
+  case BusOp::Eq:
+  case BusOp::Lt:
+    ok = args.size() == 2 && w == 1 && widths[args[0]] == widths[args[1]];
+    break;
+  case BusOp::Mux:
+    ok = args.size() == 3 && widths[args[0]] == 1 && same(1);
+    break;
+  case BusOp::Slice:
+    ok = args.size() == 1 && param + w <= widths[args[0]];
+    break;
+  case BusOp::Concat:
+  {
+    size_t sum = 0;
+    for (auto arg : args)
+      sum += widths[arg];
+    ok = !args.empty() && sum == w;
+    break;
+  }
+  }
+  if (!ok)
+    throw std::runtime_error("Operands do not fit the operation");
+  // A net read before it is driven would see a stale value; with the
+  // self-loop check below this rules out every combinational loop
+  if (read[out])
+    throw std::runtime_error("Net is read before it is driven");
+  if (std::find(args.begin(), args.end(), out) != args.end())
+    throw std::runtime_error("Operation reads its own output");
+  for (auto arg : args)
+    read[arg] = 1;
+  driven[out] = 1;
+  nodes.push_back({op, std::move(args), out, param});
+}
+
+std::vector<Bus> Datapath::values() const
+{
+  std::vector<Bus> res;
+  res.reserve(widths.size());
+  for (auto w : widths)
+    res.emplace_back(w);
+  return res;
+}
+
+void Datapath::evaluate(std::vector<Bus>& values) const
+{
+  if (values.size() != widths.size())
+    throw std::runtime_error("Wrong number of buses");
+  for (auto const& node : nodes)
+  {
+    auto arg = [&](size_t i) -> Bus const& { return values[node.args[i]]; };
+    Bus& out = values[node.out];
+    switch (node.op)
+    {
+    case BusOp::And:
+      out = arg(0) & arg(1);
+      break;
+    case BusOp::Or:
+      out = arg(0) | arg(1);
+      break;
+    case BusOp::Xor:
+      out = arg(0) ^ arg(1);
+      break;
+    case BusOp::Not:
+      out = ~arg(0);
+      break;
+    case BusOp::Add:
+      out = add(arg(0), arg(1));
+      break;
+    case BusOp::Sub:
+      out = sub(arg(0), arg(1));
+      break;
+    case BusOp::Eq:
+      out = Bus(1, eq(arg(0), arg(1)));
+      break;
+    case BusOp::Lt:
+      out = Bus(1, lt(arg(0), arg(1)));
+      break;
+    case BusOp::Mux:
+      out = mux(arg(0).at(0), arg(1), arg(2));
+      break;
+    case BusOp::Slice:
+      out = arg(0).slice(node.param, out.width());
+      break;
+    case BusOp::Concat:
+    {
+      size_t pos = out.width();
+      for (size_t i = 0; i < node.args.size(); i++)
+        out.assign(pos -= arg(i).width(), arg(i));
+      break;
+    }
+    }
+  }
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include "LogicGateType.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+/**
+ *  Multi-bit terminal value of width W
+ *
+ *  Bits are stored 64 per word as (value, X) planes, bit 0 in the least
+ *  significant position; bits above the width are kept 0.
+ */
+class Bus
+{
+  size_t _width;
+  std::vector<Planes> _words;
+
+  void trim();
+
+public:
+  /**
+   *  Construct a bus with every bit in state (0, 1 or 2)
+   *
+   */
+  explicit Bus(size_t width = 1, unsigned short state = 2);
+  /**
+   *  Construct a fully known bus from the low bits of value
+   *
+   */
+  static Bus value(size_t width, uint64_t value);
+  inline size_t width() const { return _width; }
+  inline size_t words() const { return _words.size(); }
+  inline Planes const& word(size_t n) const { return _words[n]; }
+  inline Planes& word(size_t n) { return _words[n]; }
+  /**
+   *  true if no bit is X
+   *
+   */
+  bool known() const;
+  /**
+   *  Low 64 bits (bits above are ignored, X reads as 0)
+   *
+   */
+  inline uint64_t toUint() const { return _words[0].val; }
+  /**
+   *  State of bit n (with boundary checking)
+   *
+   */
+  unsigned short at(size_t n) const;
+  /**
+   *  Set state of bit n (with boundary checking)
+   *
+   */
+  void set(size_t n, unsigned short state);
+  /**
+   *  Copy of bits [lsb, lsb + width)
+   *
+   */
+  Bus slice(size_t lsb, size_t width) const;
+  /**
+   *  Overwrite bits [lsb, lsb + part.width()) with part
+   *
+   */
+  void assign(size_t lsb, Bus const& part);
+  bool operator==(Bus const& rhs) const;
+  inline bool operator!=(Bus const& rhs) const { return !(*this == rhs); }
+  /**
+   *  Bits as characters, most significant first
+   *
+   */
+  friend std::ostream& operator<<(std::ostream& stream, Bus const& bus);
+};
+/**
+ *  Writable view of bits [lsb, lsb + width) of a bus
+ *
+ */
+class BusView
+{
+  Bus& bus;
+  size_t lsb;
+  size_t _width;
+
+public:
+  BusView(Bus& target, size_t low, size_t width);
+  inline size_t width() const { return _width; }
+  inline operator Bus() const { return bus.slice(lsb, _width); }
+  BusView& operator=(Bus const& part);
+  unsigned short at(size_t n) const;
+  void set(size_t n, unsigned short state);
+};
+/**
+ *  Concatenate buses, first part most significant (Verilog {a, b})
+ *
+ */
+Bus concat(std::initializer_list<Bus> parts);
+// Word-wide operations (operands of equal width, X propagated per bit)
+Bus operator&(Bus const& a, Bus const& b);
+Bus operator|(Bus const& a, Bus const& b);
+Bus operator^(Bus const& a, Bus const& b);
+Bus operator~(Bus const& a);
+/**
+ *  a + b + carry modulo 2^width; bits at and above the lowest X operand
+ *  bit are X
+ *
+ */
+Bus add(Bus const& a, Bus const& b, unsigned short carry = 0);
+/**
+ *  a - b modulo 2^width (X as for add)
+ *
+ */
+Bus sub(Bus const& a, Bus const& b);
+/**
+ *  Equality: 0 if some known bits differ, 2 if undecided, 1 otherwise
+ *
+ */
+unsigned short eq(Bus const& a, Bus const& b);
+/**
+ *  Unsigned a < b (0, 1 or 2 if any operand bit is X)
+ *
+ */
+unsigned short lt(Bus const& a, Bus const& b);
+/**
+ *  sel ? b : a; an X select keeps bits where a and b agree
+ *
+ */
+Bus mux(unsigned short sel, Bus const& a, Bus const& b);
+/**
+ *  Word-level operation of a datapath node
+ *
+ */
+enum class BusOp
+{
+  And,
+  Or,
+  Xor,
+  Not,
+  Add,
+  Sub,
+  Eq,
+  Lt,
+  /**
+   *  Operands: select (bit 0), then a, b
+   *
+   */
+  Mux,
+  /**
+   *  Operand bits [param, param + output width)
+   *
+   */
+  Slice,
+  Concat
+};
+/**
+ *  Netlist of bus nets and word-level operations
+ *
+ *  Nodes are evaluated in the order they are added, so every operand must
+ *  be an input or the output of an earlier node.
+ */
+class Datapath
+{
+  struct Node
+  {
+    BusOp op;
+    std::vector<uint32_t> args;
+    uint32_t out;
+    size_t param;
+  };
+  std::vector<size_t> widths;
+  std::vector<char> driven;
+  std::vector<char> read;
+  std::vector<Node> nodes;
+
+public:
+  /**
+   *  Add bus net of width
+   *
+   *  uint32_t net id
+   */
+  uint32_t addBus(size_t width);
+  inline size_t buses() const { return widths.size(); }
+  inline size_t width(uint32_t bus) const { return widths.at(bus); }
+  /**
+   *  Add operation writing out (widths are checked)
+   *
+   */
+  void addOp(BusOp op, std::vector<uint32_t> args, uint32_t out, size_t param = 0);
+  /**
+   *  Initial value of every net (X of its width)
+   *
+   */
+  std::vector<Bus> values() const;
+  /**
+   *  Evaluate all nodes (input nets set by caller)
+   *
+   */
+  void evaluate(std::vector<Bus>& values) const;
+};
@@ -0,0 +1,361 @@
+#include "LogicGateConcurrent.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ *  Releases reader slot of a thread on exit
+ *
+ */
+struct EpochSlotOwner
+{
+  EpochDomain* domain = nullptr;
+  size_t index        = EpochDomain::MaxReaders;
+  size_t depth        = 0;
+  ~EpochSlotOwner()
+  {
+    if (domain && index < EpochDomain::MaxReaders)
+      domain->slots[index].used.store(false, std::memory_order_release);
+  }
+};
+
+static thread_local EpochSlotOwner slot_owner;
+
+EpochDomain& EpochDomain::global()
+{
+  static EpochDomain domain;
+  return domain;
+}
+
+EpochDomain::~EpochDomain()
+{
+  for (auto& r : retired)
+    r.deleter();
+}
+
+size_t EpochDomain::slotIndex()
+{
+  if (slot_owner.index < MaxReaders)
+    return slot_owner.index;
+  for (size_t i = 0; i < MaxReaders; i++)
+  {
+    bool expected = false;
+    if (slots[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+    {
+      slot_owner.domain = this;
+      slot_owner.index  = i;
+      return i;
+    }
+  }
+  throw std::runtime_error("Too many reader threads");
+}
+
+void EpochDomain::pin()
+{
+  if (slot_owner.depth++ == 0)
+    slots[slotIndex()].epoch.store(epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+}
+
+void EpochDomain::unpin()
+{
+  if (--slot_owner.depth == 0)
+    slots[slot_owner.index].epoch.store(0, std::memory_order_release);
+}
+
+bool EpochDomain::readersActive() const
+{
+  for (auto const& slot : slots)
+    if (slot.epoch.load(std::memory_order_seq_cst) != 0)
+      return true;
+  return false;
+}
+
+void EpochDomain::retire(std::function<void()> deleter)
+{
+  if (!readersActive())
+  {
+    deleter();
+    return;
+  }
+  retired.push_back({epoch.fetch_add(1, std::memory_order_seq_cst), std::move(deleter)});
+  // Scan only once the list doubled, so long readers do not make retiring quadratic
+  if (retired.size() >= collectAt)
+  {
+    collect();
+    collectAt = std::max<size_t>(64, 2 * retired.size());
+  }
+}
+
+void EpochDomain::collect()
+{
+  uint64_t oldest = UINT64_MAX;
+  for (auto const& slot : slots)
+  {
+    uint64_t e = slot.epoch.load(std::memory_order_seq_cst);
+    if (e != 0 && e < oldest)
+      oldest = e;
+  }
+  size_t kept = 0;
+  for (auto& r : retired)
+  {
+    if (r.epoch < oldest)
+      r.deleter();
+    else
+      retired[kept++] = std::move(r);
+  }
+  retired.resize(kept);
+}
+
+ConcurrentGateMap::Node::Node(std::vector<Terminal> terms)
+    : layout(std::move(terms)), states(new std::atomic<unsigned short>[layout.size()])
+{
+  for (size_t i = 0; i < layout.size(); i++)
+    states[i].store(layout[i].state, std::memory_order_relaxed);
+}
+
+static std::vector<Terminal> layoutOf(Gate const& gate)
+{
+  std::vector<Terminal> terms;
+  for (size_t i = 0; i < gate.size(); i++)
+    terms.push_back(gate.terminal(i));
+  return terms;
+}
+
+ConcurrentGateMap::Table::Table(size_t size) : mask(size - 1), buckets(new std::atomic<Bucket const*>[size])
+{
+  for (size_t i = 0; i < size; i++)
+    buckets[i].store(nullptr, std::memory_order_relaxed);
+}
+
+ConcurrentGateMap::Table::~Table()
+{
+  for (size_t i = 0; i <= mask; i++)
+    delete buckets[i].load(std::memory_order_relaxed);
+}
+
+ConcurrentGateMap::ConcurrentGateMap() : table(new Table(16)) {}
+
+ConcurrentGateMap::ConcurrentGateMap(GateMap const& gates) : table(nullptr)
+{
+  size_t size = 16;
+  while (size < gates.size())
+    size *= 2;
+  std::vector<Bucket> fill(size);
+  auto* tab = new Table(size);
+  for (auto const& keyval : gates)
+    fill[std::hash<std::string>()(keyval.first) & tab->mask].emplace_back(keyval.first, new Node(layoutOf(keyval.second)));
+  for (size_t i = 0; i < size; i++)
+    if (!fill[i].empty())
+      tab->buckets[i].store(new Bucket(std::move(fill[i])), std::memory_order_relaxed);
+  count = gates.size();
+  table.store(tab, std::memory_order_release);
+}
+
+ConcurrentGateMap::~ConcurrentGateMap()
+{
+  Table* tab = table.load(std::memory_order_relaxed);
+  EpochDomain::global().retire([tab] {
+    for (size_t i = 0; i <= tab->mask; i++)
+      if (Bucket const* bucket = tab->buckets[i].load(std::memory_order_relaxed))
+        for (auto const& keyval : *bucket)
+          delete keyval.second;
+    delete tab;
+  });
+}
+
+ConcurrentGateMap::Node* ConcurrentGateMap::find(Table const* tab, std::string const& name)
+{
+  Bucket const* bucket = tab->bucket(name).load(std::memory_order_seq_cst);
+  if (bucket)
+    for (auto const& keyval : *bucket)
+      if (keyval.first == name)
+        return keyval.second;
+  return nullptr;
+}
+
+ConcurrentGateMap::Node* ConcurrentGateMap::writerNode(std::string const& name) const
+{
+  Node* node = find(table.load(std::memory_order_relaxed), name);
+  if (!node)
+    throw std::out_of_range(name);
+  return node;
+}
+
+ConcurrentGateMap::Node* ConcurrentGateMap::replace(std::string const& name, Node* node)
+{
+  auto& slot         = table.load(std::memory_order_relaxed)->bucket(name);
+  Bucket const* prev = slot.load(std::memory_order_relaxed);
+  Node* old          = nullptr;
+  auto* next         = new Bucket;
+  if (prev)
+    for (auto const& keyval : *prev)
+    {
+      if (keyval.first == name)
+        old = keyval.second;
+      else
+        next->push_back(keyval);
+    }
+  if (node)
+    next->emplace_back(name, node);
+  if (next->empty())
+  {
+    delete next;
+    next = nullptr;
+  }
+  slot.exchange(next, std::memory_order_seq_cst);
+  if (prev)
+    EpochDomain::global().retire([prev] { delete prev; });
+  count = count + (node != nullptr) - (old != nullptr);
+  if (count > 2 * (table.load(std::memory_order_relaxed)->mask + 1))
+    grow();
+  return old;
+}
+
+void ConcurrentGateMap::grow()
+{
+  Table* prev = table.load(std::memory_order_relaxed);
+  size_t size = 2 * (prev->mask + 1);
+  std::vector<Bucket> fill(size);
+  auto* next = new Table(size);
+  for (size_t i = 0; i <= prev->mask; i++)
+    if (Bucket const* bucket = prev->buckets[i].load(std::memory_order_relaxed))
+      for (auto const& keyval : *bucket)
+        fill[std::hash<std::string>()(keyval.first) & next->mask].push_back(keyval);
+  for (size_t i = 0; i < size; i++)
+    if (!fill[i].empty())
+      next->buckets[i].store(new Bucket(std::move(fill[i])), std::memory_order_relaxed);
+  table.exchange(next, std::memory_order_seq_cst);
+  EpochDomain::global().retire([prev] { delete prev; });
+}
+
+ConcurrentGateMap::View::View(ConcurrentGateMap const& map, std::string const& name)
+    : node(find(map.table.load(std::memory_order_seq_cst), name))
+{
+  if (!node)
+    throw std::out_of_range(name);
+}
+
+unsigned short ConcurrentGateMap::View::operator[](size_t n) const { return node->states[n].load(std::memory_order_acquire); }
+
+unsigned short ConcurrentGateMap::View::getTerminalState(size_t n) const
+{
+  if (n >= node->size())
+    throw std::out_of_range("");
+  return (*this)[n];
+}
+
+std::vector<unsigned short> ConcurrentGateMap::View::snapshot() const
+{
+  std::vector<unsigned short> vals(node->size());
+  uint32_t before, after;
+  do
+  {
+    before = node->seq.load(std::memory_order_acquire);
+    if (before & 1)
+      continue;
+    for (size_t i = 0; i < vals.size(); i++)
+      vals[i] = node->states[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = node->seq.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+  return vals;
+}
+
+Gate ConcurrentGateMap::View::toGate() const
+{
+  std::vector<Terminal> terms = node->layout;
+  std::vector<unsigned short> vals = snapshot();
+  for (size_t i = 0; i < terms.size(); i++)
+    terms[i].state = vals[i];
+  return Gate(std::move(terms));
+}
+
+unsigned short ConcurrentGateMap::getTerminalState(std::string const& name, size_t n) const
+{
+  return View(*this, name).getTerminalState(n);
+}
+
+std::vector<std::string> ConcurrentGateMap::names() const
+{
+  EpochGuard guard;
+  std::vector<std::string> res;
+  Table const* tab = table.load(std::memory_order_seq_cst);
+  for (size_t i = 0; i <= tab->mask; i++)
+    if (Bucket const* bucket = tab->buckets[i].load(std::memory_order_seq_cst))
+      for (auto const& keyval : *bucket)
+        res.push_back(keyval.first);
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+void ConcurrentGateMap::insert(std::string const& name, Gate const& gate)
+{
+  Node* prev = replace(name, new Node(layoutOf(gate)));
+  if (prev)
+    EpochDomain::global().retire([prev] { delete prev; });
+}
+
+bool ConcurrentGateMap::erase(std::string const& name)
+{
+  if (!find(table.load(std::memory_order_relaxed), name))
+    return false;
+  Node* prev = replace(name, nullptr);
+  EpochDomain::global().retire([prev] { delete prev; });
+  return true;
+}
+
+void ConcurrentGateMap::addTerminal(std::string const& name, Terminal const& term)
+{
+  Node* prev                  = writerNode(name);
+  std::vector<Terminal> terms = prev->layout;
+  for (size_t i = 0; i < terms.size(); i++)
+    terms[i].state = prev->states[i].load(std::memory_order_relaxed);
+  terms.push_back(term);
+  replace(name, new Node(std::move(terms)));
+  EpochDomain::global().retire([prev] { delete prev; });
+}
+
+void ConcurrentGateMap::setTerminalState(std::string const& name, size_t n, unsigned short val)
+{
+  Node* node = writerNode(name);
+  if (n >= node->size())
+    throw std::out_of_range("");
+  uint32_t seq = node->seq.load(std::memory_order_relaxed);
+  node->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  node->states[n].store(val, std::memory_order_relaxed);
+  node->seq.store(seq + 2, std::memory_order_release);
+}
+
+void ConcurrentGateMap::setTerminalStates(std::string const& name, std::vector<unsigned short> const& vals)
+{
+  Node* node = writerNode(name);
+  if (vals.size() > node->size())
+    throw std::out_of_range("");
+  uint32_t seq = node->seq.load(std::memory_order_relaxed);
+  node->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < vals.size(); i++)
+    node->states[i].store(vals[i], std::memory_order_relaxed);
+  node->seq.store(seq + 2, std::memory_order_release);
+}
+
+GateMap ConcurrentGateMap::toGateMap() const
+{
+  EpochGuard guard;
+  GateMap res;
+  Table const* tab = table.load(std::memory_order_seq_cst);
+  for (size_t b = 0; b <= tab->mask; b++)
+  {
+    Bucket const* bucket = tab->buckets[b].load(std::memory_order_seq_cst);
+    if (!bucket)
+      continue;
+    for (auto const& keyval : *bucket)
+    {
+      std::vector<Terminal> terms = keyval.second->layout;
+      for (size_t i = 0; i < terms.size(); i++)
+        terms[i].state = keyval.second->states[i].load(std::memory_order_relaxed);
+      res[keyval.first] = Gate(std::move(terms));
+    }
+  }
+  return res;
+}
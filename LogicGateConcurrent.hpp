@@ -0,0 +1,261 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+/**
+ *  Epoch-based reclamation of objects unlinked by the writer
+ *
+ *  Readers announce the epoch they entered in a per-thread slot and never
+ *  wait; the writer frees a retired object once every announced epoch is
+ *  newer than the one it was retired in.
+ */
+class EpochDomain
+{
+public:
+  static constexpr size_t MaxReaders = 64;
+
+  /**
+   *  Process-wide domain
+   *
+   *  EpochDomain&
+   */
+  static EpochDomain& global();
+  /**
+   *  Enter read-side critical section (reentrant)
+   *
+   */
+  void pin();
+  /**
+   *  Leave read-side critical section
+   *
+   */
+  void unpin();
+  /**
+   *  Schedule deleter to run when no reader can observe the object
+   *
+   *  deleter frees the object
+   */
+  void retire(std::function<void()> deleter);
+  /**
+   *  Run deleters of objects no reader can observe
+   *
+   */
+  void collect();
+  /**
+   *  true if some thread is inside a read-side critical section
+   *
+   */
+  bool readersActive() const;
+  ~EpochDomain();
+
+private:
+  struct alignas(64) Slot
+  {
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> used{false};
+  };
+  struct Retired
+  {
+    uint64_t epoch;
+    std::function<void()> deleter;
+  };
+  std::atomic<uint64_t> epoch{1};
+  Slot slots[MaxReaders];
+  std::vector<Retired> retired;
+  /**
+   *  Size of retired that triggers the next collect()
+   *
+   */
+  size_t collectAt = 64;
+
+  size_t slotIndex();
+  friend struct EpochSlotOwner;
+};
+/**
+ *  RAII read-side critical section
+ *
+ */
+class EpochGuard
+{
+public:
+  EpochGuard() { EpochDomain::global().pin(); }
+  ~EpochGuard() { EpochDomain::global().unpin(); }
+  EpochGuard(EpochGuard const&) = delete;
+  EpochGuard& operator=(EpochGuard const&) = delete;
+};
+/**
+ *  GateMap for one writer thread and any number of non-blocking readers
+ *
+ *  Terminal states are guarded per gate by a seqlock so a reader always sees
+ *  a consistent snapshot of one gate. Gates are indexed by a hash table of
+ *  immutable buckets: structural changes (new/removed gates, added
+ *  terminals) publish a new copy of one bucket and retire the old one
+ *  through EpochDomain, and the bucket array is rehashed into a new one as
+ *  the map grows. Writer methods must be called from a single thread.
+ */
+class ConcurrentGateMap
+{
+  /**
+   *  Gate with seqlock-protected states (layout is immutable)
+   *
+   */
+  struct Node
+  {
+    std::atomic<uint32_t> seq{0};
+    std::vector<Terminal> layout;
+    std::unique_ptr<std::atomic<unsigned short>[]> states;
+
+    explicit Node(std::vector<Terminal> terms);
+    size_t size() const { return layout.size(); }
+  };
+  typedef std::vector<std::pair<std::string, Node*>> Bucket;
+  /**
+   *  Bucket array (power of two size, owns its buckets)
+   *
+   */
+  struct Table
+  {
+    size_t mask;
+    std::unique_ptr<std::atomic<Bucket const*>[]> buckets;
+
+    explicit Table(size_t size);
+    ~Table();
+    inline std::atomic<Bucket const*>& bucket(std::string const& name) const
+    {
+      return buckets[std::hash<std::string>()(name) & mask];
+    }
+  };
+
+  std::atomic<Table*> table;
+  size_t count = 0;
+
+  static Node* find(Table const* tab, std::string const& name);
+  Node* writerNode(std::string const& name) const;
+  /**
+   *  Bind name to node (nullptr - unbind), returning the previous node
+   *
+   */
+  Node* replace(std::string const& name, Node* node);
+  void grow();
+
+public:
+  /**
+   *  Consistent read access to one gate
+   *
+   *  Keeps the gate alive while the view exists.
+   */
+  class View
+  {
+    EpochGuard guard;
+    Node const* node;
+
+  public:
+    explicit View(ConcurrentGateMap const& map, std::string const& name);
+    inline size_t size() const { return node->size(); }
+    /**
+     *  Get terminal's state by index n (without boundary checks)
+     *
+     *  n index
+     *  unsigned short
+     */
+    unsigned short operator[](size_t n) const;
+    /**
+     *  Get terminal's state by index n (with boundary checking)
+     *
+     *  n index
+     *  unsigned short
+     */
+    unsigned short getTerminalState(size_t n) const;
+    /**
+     *  States of all terminals as of one instant
+     *
+     *  std::vector<unsigned short>
+     */
+    std::vector<unsigned short> snapshot() const;
+    /**
+     *  Copy of the gate with a consistent set of states
+     *
+     *  Gate
+     */
+    Gate toGate() const;
+  };
+
+  ConcurrentGateMap();
+  /**
+   *  Construct from an interactive session
+   *
+   *  gates gates to be copied
+   */
+  explicit ConcurrentGateMap(GateMap const& gates);
+  ~ConcurrentGateMap();
+  ConcurrentGateMap(ConcurrentGateMap const&) = delete;
+  ConcurrentGateMap& operator=(ConcurrentGateMap const&) = delete;
+
+  /**
+   *  Read terminal state of named gate (reader side, never blocks)
+   *
+   *  name gate name
+   *  n terminal index
+   *  unsigned short
+   */
+  unsigned short getTerminalState(std::string const& name, size_t n) const;
+  /**
+   *  Read access to named gate (reader side, never blocks)
+   *
+   *  name gate name
+   *  View
+   */
+  View operator[](std::string const& name) const { return View(*this, name); }
+  /**
+   *  Names of all gates
+   *
+   *  std::vector<std::string>
+   */
+  std::vector<std::string> names() const;
+
+  /**
+   *  Insert or replace gate (writer side)
+   *
+   *  name gate name
+   *  gate gate to be copied
+   */
+  void insert(std::string const& name, Gate const& gate);
+  /**
+   *  Remove gate (writer side)
+   *
+   *  name gate name
+   *  true if gate was removed
+   */
+  bool erase(std::string const& name);
+  /**
+   *  Add terminal to named gate (writer side)
+   *
+   *  name gate name
+   *  term terminal to be added
+   */
+  void addTerminal(std::string const& name, Terminal const& term);
+  /**
+   *  Set terminal's state (writer side)
+   *
+   *  name gate name
+   *  n terminal index
+   *  val value to be set
+   */
+  void setTerminalState(std::string const& name, size_t n, unsigned short val);
+  /**
+   *  Set several states of one gate atomically for readers (writer side)
+   *
+   *  name gate name
+   *  vals states in terminal order
+   */
+  void setTerminalStates(std::string const& name, std::vector<unsigned short> const& vals);
+  /**
+   *  Copy contents back into an interactive session
+   *
+   *  GateMap
+   */
+  GateMap toGateMap() const;
+};
@@ -0,0 +1,139 @@
+#include "LogicGateDemand.hpp"
+#include "LogicGateStats.hpp"
+#include <stdexcept>
+
+/**
+ *  Whether value forces the output of fn on every lane
+ *
+ */
+static bool controls(GateFunction fn, Planes const& value)
+{
+  switch (fn)
+  {
+  case GateFunction::And:
+  case GateFunction::Nand:
+    return (~value.val & ~value.unk) == ~0ULL;
+  case GateFunction::Or:
+  case GateFunction::Nor:
+    return (value.val & ~value.unk) == ~0ULL;
+  default:
+    return false;
+  }
+}
+
+DemandEvaluator::DemandEvaluator(Netlist const& netlist)
+    : nl(netlist), values(nl.nets(), Planes::broadcast(2)), changed(nl.nets(), 0), computed(nl.gates(), 0),
+      verified(nl.gates(), 0), used(nl.gates(), 0)
+{
+  // Reject combinational loops up front
+  nl.order();
+}
+
+void DemandEvaluator::setInput(size_t i, Planes value)
+{
+  NetId net = nl.inputs().at(i);
+  if (values[net] == value)
+    return;
+  values[net]  = value;
+  changed[net] = ++_epoch;
+}
+
+void DemandEvaluator::setInputs(std::vector<unsigned short> const& states)
+{
+  if (states.size() != nl.inputs().size())
+    throw std::runtime_error("Wrong number of inputs");
+  for (size_t i = 0; i < states.size(); i++)
+    setInput(i, states[i]);
+}
+
+Planes const& DemandEvaluator::value(NetId net)
+{
+  if (net >= nl.nets())
+    throw std::out_of_range("");
+  if (nl.driver(net) != NoGate)
+    pull(nl.driver(net));
+  return values[net];
+}
+
+void DemandEvaluator::pull(uint32_t root)
+{
+  if (verified[root] == _epoch)
+    return;
+  LG_STAT_PHASE(Propagate);
+  stack.push_back({root, 0, computed[root] == 0});
+  LG_STAT_INC(events_scheduled);
+  while (!stack.empty())
+  {
+    Frame& f          = stack.back();
+    uint32_t g        = f.gate;
+    GateType const& t = nl.type(g);
+    size_t limit      = f.dirty ? t.inputs() : used[g];
+    bool cut = false, descend = false;
+    while (f.next < limit)
+    {
+      NetId net  = nl.pin(g, t.inputTerminal(f.next));
+      uint32_t d = nl.driver(net);
+      if (d != NoGate && verified[d] != _epoch)
+      {
+        descend = true;
+        break;
+      }
+      if (!f.dirty && changed[net] > computed[g])
+      {
+        // Re-read fanins from the start: an earlier one may now control
+        f.dirty = true;
+        f.next  = 0;
+        limit   = t.inputs();
+        continue;
+      }
+      if (f.dirty && controls(t.function(), values[net]))
+      {
+        cut = true;
+        break;
+      }
+      f.next++;
+    }
+    if (descend)
+    {
+      uint32_t d = nl.driver(nl.pin(g, t.inputTerminal(f.next)));
+      stack.push_back({d, 0, computed[d] == 0});
+      LG_STAT_INC(events_scheduled);
+      continue;
+    }
+    if (f.dirty)
+    {
+      Planes out[GateType::MaxTerminals];
+      if (cut)
+      {
+        GateFunction fn = t.function();
+        Planes forced   = Planes::broadcast(fn == GateFunction::Nand || fn == GateFunction::Or);
+        for (size_t k = 0; k < t.outputs(); k++)
+          out[k] = forced;
+        used[g] = f.next + 1;
+      }
+      else
+      {
+        Planes in[GateType::MaxTerminals];
+        for (size_t k = 0; k < t.inputs(); k++)
+          in[k] = values[nl.pin(g, t.inputTerminal(k))];
+        for (size_t k = 0; k < t.outputs(); k++)
+          out[k] = t.evaluate(in, k);
+        used[g] = t.inputs();
+      }
+      for (size_t k = 0; k < t.outputs(); k++)
+      {
+        NetId net = nl.pin(g, t.outputTerminal(k));
+        if (values[net] != out[k] || !computed[g])
+        {
+          values[net]  = out[k];
+          changed[net] = _epoch;
+        }
+      }
+      computed[g] = _epoch;
+      _evaluated++;
+      LG_STAT_INC(evaluations);
+    }
+    verified[g] = _epoch;
+    stack.pop_back();
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <vector>
+/**
+ *  Demand-driven evaluation of single nets
+ *
+ *  A query evaluates only the transitive fanin cone of the requested net.
+ *  Results are memoised per gate with epoch stamps: every input change
+ *  starts a new epoch, and a later query first re-verifies the cone
+ *  (visiting each gate at most once per epoch) and re-evaluates only gates
+ *  whose fanins changed since they were computed. AND/NAND with a known 0
+ *  and OR/NOR with a known 1 on all lanes stop reading further fanins; the
+ *  fanins that were read are remembered so verification stays exact.
+ */
+class DemandEvaluator
+{
+  Netlist const& nl;
+  uint64_t _epoch = 1;
+  std::vector<Planes> values;
+  /**
+   *  Epoch in which the value of each net last changed
+   *
+   */
+  std::vector<uint64_t> changed;
+  std::vector<uint64_t> computed;
+  std::vector<uint64_t> verified;
+  /**
+   *  Fanins read by the last evaluation of each gate
+   *
+   */
+  std::vector<uint8_t> used;
+  struct Frame
+  {
+    uint32_t gate;
+    uint8_t next;
+    bool dirty;
+  };
+  std::vector<Frame> stack;
+  uint64_t _evaluated = 0;
+
+  void pull(uint32_t root);
+
+public:
+  explicit DemandEvaluator(Netlist const& netlist);
+  /**
+   *  Set primary input i (starts a new epoch if the value changes)
+   *
+   */
+  void setInput(size_t i, Planes value);
+  inline void setInput(size_t i, unsigned short state) { setInput(i, Planes::broadcast(state)); }
+  void setInputs(std::vector<unsigned short> const& states);
+  /**
+   *  Value of net, evaluating its fanin cone as needed
+   *
+   */
+  Planes const& value(NetId net);
+  inline unsigned short state(NetId net) { return value(net).lane(0); }
+  /**
+   *  State of terminal n of gate g
+   *
+   */
+  inline unsigned short state(uint32_t g, size_t n) { return state(nl.pin(g, n)); }
+  inline uint64_t epoch() const { return _epoch; }
+  /**
+   *  Gate evaluations performed so far
+   *
+   */
+  inline uint64_t evaluated() const { return _evaluated; }
+};
@@ -1,4 +1,6 @@
 #include "LogicGateDynamic.hpp"
+#include "LogicGateStats.hpp"
+#include <algorithm>
 
 Terminal::Terminal(bool isout, unsigned short conns, unsigned short _state) : isOutput{isout}, conn_num{conns}, state{_state} {}
 
@@ -46,6 +48,7 @@ std::istream& operator>>(std::istream& stream, Terminal& term)
 
 Gate::Gate() : _size(2)
 {
+  LG_STAT_INC(allocations);
   terminals.reset(new Terminal[_size]);
   terminals[0] = {false, 0, 0};
   terminals[1] = {true, 0, 1};
@@ -53,6 +56,7 @@ Gate::Gate() : _size(2)
 
 Gate::Gate(size_t in, size_t out) : _size(in + out)
 {
+  LG_STAT_INC(allocations);
   terminals.reset(new Terminal[_size]);
   for (size_t i = 0; i < in; i++)
     terminals[i] = {false, 0, 0};
@@ -60,16 +64,24 @@ Gate::Gate(size_t in, size_t out) : _size(in + out)
     terminals[i] = {true, 0, 0};
 }
 
-Gate::Gate(std::vector<Terminal> terms) : _size(terms.size())
+Gate::Gate(std::vector<Terminal> const& terms) : _size(terms.size())
 {
+  LG_STAT_INC(allocations);
   terminals.reset(new Terminal[_size]);
-  for (size_t i = 0; i < _size; i++)
-    terminals[i] = terms[i];
-};
+  std::copy(terms.begin(), terms.end(), terminals.get());
+}
+
+Gate::Gate(GateView view) : _size(view.size())
+{
+  LG_STAT_INC(allocations);
+  terminals.reset(new Terminal[_size]);
+  std::copy(view.begin(), view.end(), terminals.get());
+}
 
 Gate::Gate(Gate const& gt)
 {
   _size = gt._size;
+  LG_STAT_INC(allocations);
   terminals.reset(new Terminal[gt._size]);
   for (size_t i = 0; i < _size; i++)
     terminals[i] = gt.terminals[i];
@@ -84,6 +96,7 @@ Gate::Gate(Gate&& gt)
 Gate& Gate::operator=(Gate const& gt)
 {
   _size = gt._size;
+  LG_STAT_INC(allocations);
   terminals.reset(new Terminal[gt._size]);
   for (size_t i = 0; i < _size; i++)
     terminals[i] = gt.terminals[i];
@@ -94,6 +107,8 @@ unsigned short const& Gate::operator()(size_t n, unsigned short val)
 {
   if (n >= _size)
     throw std::out_of_range("");
+  if (terminals[n].state != val)
+    LG_STAT_INC(state_changes);
   return terminals[n].state = val;
 }
 
@@ -106,11 +121,19 @@ unsigned short const& Gate::at(size_t n)
   return terminals[n].state;
 }
 
+Terminal const& Gate::terminal(size_t n) const
+{
+  if (n >= _size)
+    throw std::out_of_range("");
+  return terminals[n];
+}
+
 void Gate::connect(size_t n)
 {
   if (n >= _size)
     throw std::out_of_range("");
   terminals[n].connect();
+  LG_STAT_INC(connects);
 }
 
 void Gate::disconnect(size_t n)
@@ -118,28 +141,90 @@ void Gate::disconnect(size_t n)
   if (n >= _size)
     throw std::out_of_range("");
   terminals[n].disconnect();
+  LG_STAT_INC(disconnects);
 }
 
 Gate& Gate::operator+=(Terminal&& term)
 {
-  terminals.reset((Terminal*)std::realloc(terminals.release(), _size + 1));
+  LG_STAT_INC(allocations);
+  Terminal* grown = new Terminal[_size + 1];
+  for (size_t i = 0; i < _size; i++)
+    grown[i] = terminals[i];
+  terminals.reset(grown);
   terminals[_size++] = term;
   return *this;
 }
 
-std::istream& operator>>(std::istream& stream, Gate& gate)
+std::istream& operator>>(std::istream& stream, Gate& gate) { return stream >> gate.view(); }
+
+std::ostream& operator<<(std::ostream& stream, Gate& gate) { return stream << gate.view(); }
+
+GateView GateView::slice(size_t first, size_t count) const
+{
+  if (first > _size || count > _size - first)
+    throw std::out_of_range("");
+  return GateView(terminals + first, count);
+}
+
+unsigned short const& GateView::operator()(size_t n, unsigned short val) const
+{
+  if (n >= _size)
+    throw std::out_of_range("");
+  if (terminals[n].state != val)
+    LG_STAT_INC(state_changes);
+  return terminals[n].state = val;
+}
+
+unsigned short const& GateView::at(size_t n) const
 {
+  if (n >= _size)
+    throw std::out_of_range("");
+  return terminals[n].state;
+}
+
+Terminal const& GateView::terminal(size_t n) const
+{
+  if (n >= _size)
+    throw std::out_of_range("");
+  return terminals[n];
+}
+
+void GateView::connect(size_t n) const
+{
+  if (n >= _size)
+    throw std::out_of_range("");
+  terminals[n].connect();
+  LG_STAT_INC(connects);
+}
+
+void GateView::disconnect(size_t n) const
+{
+  if (n >= _size)
+    throw std::out_of_range("");
+  terminals[n].disconnect();
+  LG_STAT_INC(disconnects);
+}
+
+std::ostream& GateView::output(std::ostream& stream) const { return stream << *this; }
+
+std::istream& operator>>(std::istream& stream, GateView const& gate)
+{
+  LG_STAT_PHASE(Input);
   for (size_t i = 0; i < gate._size; i++)
   {
     if (&stream == &std::cin)
       std::cout << "Enter state for terminal#" << i + 1 << (gate.terminals[i].isOutput ? " (Output)>" : " (Input)>");
+    unsigned short prev = gate.terminals[i].state;
     stream >> gate.terminals[i];
+    if (gate.terminals[i].state != prev)
+      LG_STAT_INC(state_changes);
   }
   return stream;
 }
 
-std::ostream& operator<<(std::ostream& stream, Gate& gate)
+std::ostream& operator<<(std::ostream& stream, GateView const& gate)
 {
+  LG_STAT_PHASE(Output);
   stream << "Inputs:  ";
   for (size_t i = 0; i < gate._size; i++)
     if (!gate.terminals[i].isOutput)
@@ -149,4 +234,4 @@ std::ostream& operator<<(std::ostream& stream, Gate& gate)
     if (gate.terminals[i].isOutput)
       stream << (((gate.terminals[i].state == 2) ? "  X   " : (gate.terminals[i].state ? " High " : " Low  ")));
   return stream;
-}
\ No newline at end of file
+}
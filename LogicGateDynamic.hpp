@@ -1,7 +1,10 @@
+#pragma once
 #include <iostream>
+#include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 /**
  *  Gate's terminal
@@ -53,6 +56,85 @@ struct Terminal
    */
   friend std::istream& operator>>(std::istream& stream, Terminal& term);
 };
+static_assert(std::is_trivially_copyable<Terminal>::value, "Terminal buffers are shared and mapped as raw bytes");
+/**
+ *  Non-owning view of a gate over caller-owned terminal storage
+ *
+ *  Exposes the accessor API of Gate directly on an external buffer (an
+ *  imported or mmap'd terminal array, or the terminals of a Gate), so
+ *  large circuits can be inspected and simulated without copying. The
+ *  storage must outlive the view; copying a view never copies terminals.
+ */
+class GateView
+{
+  Terminal* terminals;
+  size_t _size;
+
+public:
+  /**
+   *  Construct a view of n terminals starting at terms
+   *
+   */
+  GateView(Terminal* terms, size_t n) : terminals(terms), _size(n) {}
+  inline size_t size() const { return _size; }
+  inline Terminal* data() const { return terminals; }
+  inline Terminal* begin() const { return terminals; }
+  inline Terminal* end() const { return terminals + _size; }
+  /**
+   *  View of count terminals starting at first (with boundary checking)
+   *
+   */
+  GateView slice(size_t first, size_t count) const;
+  /**
+   *  Set terminal's state by index n
+   *
+   *  n index
+   *  val value to be set
+   *  unsigned short const&
+   */
+  unsigned short const& operator()(size_t n, unsigned short val) const;
+  /**
+   *  Get terminal's state by index n (without boundary checks)
+   *
+   */
+  inline unsigned short const& operator[](size_t n) const { return terminals[n].state; }
+  /**
+   *  Get terminal's state by index n (with boundary cheking)
+   *
+   */
+  unsigned short const& at(size_t n) const;
+  /**
+   *  Same as at (name of the static edition)
+   *
+   */
+  inline unsigned short const& getTerminalState(size_t n) const { return at(n); }
+  /**
+   *  Get terminal by index n (with boundary cheking)
+   *
+   */
+  Terminal const& terminal(size_t n) const;
+  /**
+   *  Increase number of connections of terminal by index n
+   *
+   */
+  void connect(size_t n) const;
+  /**
+   *  Decrease number of connections of terminal by index n
+   *
+   */
+  void disconnect(size_t n) const;
+  /**
+   *  Formatted output of gate (as operator<<)
+   *
+   */
+  std::ostream& output(std::ostream& stream = std::cout) const;
+  /**
+   *  Input states of terminals from stream
+   *
+   */
+  friend std::istream& operator>>(std::istream& stream, GateView const& gate);
+  friend std::ostream& operator<<(std::ostream& stream, GateView const& gate);
+};
 /**
  *  Logical Gate
  *
@@ -74,7 +156,7 @@ class Gate
    *
    */
 public:
-  inline size_t size() { return _size; }
+  inline size_t size() const { return _size; }
   Gate();
   /**
    *  Construct a new Gate object
@@ -88,7 +170,13 @@ public:
    *
    *  terms vector of terminals
    */
-  Gate(std::vector<Terminal> terms);
+  Gate(std::vector<Terminal> const& terms);
+  /**
+   *  Construct a new Gate object owning a copy of viewed terminals
+   *
+   *  view terminals to copy
+   */
+  explicit Gate(GateView view);
   /**
    *  Copy-construct a new Gate object
    *
@@ -130,6 +218,13 @@ public:
    *  unsigned short const&
    */
   unsigned short const& at(size_t n);
+  /**
+   *  Get terminal by index n (with boundary cheking)
+   *
+   *  n index
+   *  Terminal const&
+   */
+  Terminal const& terminal(size_t n) const;
   /**
    *  Increase number of connections of terminal by index n
    *
@@ -149,6 +244,12 @@ public:
    *  Gate&
    */
   Gate& operator+=(Terminal&& term);
+  /**
+   *  View of own terminals (invalidated by assignment and operator+=)
+   *
+   *  GateView
+   */
+  inline GateView view() { return GateView(terminals.get(), _size); }
 
   /**
    *  Input states of terminals from stream
@@ -168,3 +269,8 @@ public:
    */
   friend std::ostream& operator<<(std::ostream& stream, Gate& gate);
 };
+/**
+ *  Named gates of an interactive session
+ *
+ */
+typedef std::map<std::string, Gate> GateMap;
\ No newline at end of file
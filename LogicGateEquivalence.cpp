@@ -0,0 +1,542 @@
+#include "LogicGateEquivalence.hpp"
+#include "LogicGateBdd.hpp"
+#include "LogicGateSat.hpp"
+#include "LogicGateStimulus.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+EquivalenceChecker::EquivalenceChecker(Netlist const& first, Netlist const& second) : a(first), b(second)
+{
+  if (a.inputs().size() != b.inputs().size() || a.outputs().size() != b.outputs().size())
+    throw std::runtime_error("Circuits have different interfaces");
+  // Build levelization caches now so worker threads only read
+  a.order();
+  b.order();
+}
+
+bool EquivalenceChecker::differs(std::vector<unsigned short> const& vec, size_t& output) const
+{
+  auto ra = a.evaluate(vec), rb = b.evaluate(vec);
+  for (size_t o = 0; o < ra.size(); o++)
+    if (ra[o] != 2 && rb[o] != 2 && ra[o] != rb[o])
+    {
+      output = o;
+      return true;
+    }
+  return false;
+}
+
+bool EquivalenceChecker::simulate(Planes const* inputs, std::vector<Planes>& va, std::vector<Planes>& vb,
+                                  size_t& lane) const
+{
+  for (size_t i = 0; i < a.inputs().size(); i++)
+  {
+    va[a.inputs()[i]] = inputs[i];
+    vb[b.inputs()[i]] = inputs[i];
+  }
+  a.evaluate(va.data());
+  b.evaluate(vb.data());
+  uint64_t diff = 0;
+  for (size_t o = 0; o < a.outputs().size(); o++)
+  {
+    Planes pa = va[a.outputs()[o]], pb = vb[b.outputs()[o]];
+    diff |= (pa.val ^ pb.val) & ~pa.unk & ~pb.unk;
+  }
+  if (!diff)
+    return false;
+  lane = __builtin_ctzll(diff);
+  return true;
+}
+
+EquivalenceResult EquivalenceChecker::found(std::string method, std::vector<unsigned short> vec) const
+{
+  EquivalenceResult res{false, std::move(method), minimize(vec), 0};
+  if (!differs(res.counterexample, res.output))
+    throw std::logic_error("Counterexample of " + res.method + " shows no difference");
+  return res;
+}
+
+std::vector<unsigned short> EquivalenceChecker::minimize(std::vector<unsigned short> vec) const
+{
+  size_t output;
+  if (!differs(vec, output))
+    return vec;
+  for (size_t i = 0; i < vec.size(); i++)
+  {
+    unsigned short keep = vec[i];
+    vec[i]              = 2;
+    if (!differs(vec, output))
+      vec[i] = keep;
+  }
+  return vec;
+}
+
+static std::vector<unsigned short> laneOf(std::vector<Planes> const& inputs, size_t lane)
+{
+  std::vector<unsigned short> vec;
+  for (auto const& p : inputs)
+    vec.push_back(p.lane(lane));
+  return vec;
+}
+
+EquivalenceResult EquivalenceChecker::random() const
+{
+  size_t n = a.inputs().size();
+  StimulusGenerator gen(seed, n);
+  std::vector<Planes> in(n), va(a.nets(), Planes::broadcast(2)), vb(b.nets(), Planes::broadcast(2));
+  for (uint64_t blk = 0; blk < randomBlocks; blk++)
+  {
+    gen.block(blk, in.data());
+    size_t lane;
+    if (simulate(in.data(), va, vb, lane))
+      return found("random", laneOf(in, lane));
+  }
+  return {true, "random", {}, 0};
+}
+
+EquivalenceResult EquivalenceChecker::exhaustive() const
+{
+  static const uint64_t pattern[6] = {0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+                                      0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL};
+  size_t n        = a.inputs().size();
+  uint64_t blocks = n > 6 ? uint64_t(1) << (n - 6) : 1;
+  unsigned count  = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+  count           = unsigned(std::min<uint64_t>(count, blocks));
+
+  std::atomic<bool> stop{false};
+  std::mutex lock;
+  std::vector<unsigned short> cex;
+  auto work = [&](unsigned t) {
+    std::vector<Planes> in(n), va(a.nets(), Planes::broadcast(2)), vb(b.nets(), Planes::broadcast(2));
+    for (size_t i = 0; i < n && i < 6; i++)
+      in[i] = {pattern[i], 0};
+    for (uint64_t blk = blocks * t / count; blk < blocks * (t + 1) / count && !stop; blk++)
+    {
+      for (size_t i = 6; i < n; i++)
+        in[i] = Planes::broadcast((blk >> (i - 6)) & 1);
+      size_t lane;
+      if (simulate(in.data(), va, vb, lane))
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!stop.exchange(true))
+          cex = laneOf(in, lane);
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < count; t++)
+    pool.emplace_back(work, t);
+  work(0);
+  for (auto& thr : pool)
+    thr.join();
+  if (stop)
+    return found("exhaustive", cex);
+  return {true, "exhaustive", {}, 0};
+}
+
+/**
+ *  Ternary value of a net as two rails: known 1, known 0 (neither - X)
+ *
+ */
+template <class Value> struct Rail
+{
+  Value one, zero;
+};
+
+/**
+ *  Rails of output k of gate type t, exactly as GateType::evaluate
+ *
+ */
+template <class Ops>
+static Rail<typename Ops::Value> ternary(Ops& ops, GateType const& t, size_t k,
+                                         std::vector<Rail<typename Ops::Value>> const& in)
+{
+  typedef typename Ops::Value Value;
+  Rail<Value> r{ops.falsity(), ops.falsity()};
+  GateFunction f = t.function();
+  switch (f)
+  {
+  case GateFunction::Buffer:
+  case GateFunction::Not:
+    r = in[0];
+    break;
+  case GateFunction::And:
+  case GateFunction::Nand:
+    r.one = ops.truth();
+    for (auto const& x : in)
+    {
+      r.one  = ops.conj(r.one, x.one);
+      r.zero = ops.disj(r.zero, x.zero);
+    }
+    break;
+  case GateFunction::Or:
+  case GateFunction::Nor:
+    r.zero = ops.truth();
+    for (auto const& x : in)
+    {
+      r.one  = ops.disj(r.one, x.one);
+      r.zero = ops.conj(r.zero, x.zero);
+    }
+    break;
+  case GateFunction::Xor:
+  case GateFunction::Xnor:
+  {
+    Value known = ops.truth(), val = ops.falsity();
+    for (auto const& x : in)
+    {
+      known = ops.conj(known, ops.disj(x.one, x.zero));
+      val   = ops.parity(val, x.one);
+    }
+    r = {ops.conj(known, val), ops.conj(known, ops.neg(val))};
+    break;
+  }
+  case GateFunction::Lut:
+  {
+    // A completion of the X inputs can hit minterm m unless an input is known opposite
+    Value can1 = ops.falsity(), can0 = ops.falsity();
+    for (size_t m = 0; m < (size_t(1) << in.size()); m++)
+    {
+      Value term = ops.truth();
+      for (size_t i = 0; i < in.size(); i++)
+        term = ops.conj(term, ops.neg(((m >> i) & 1) ? in[i].zero : in[i].one));
+      if ((t.table(k) >> m) & 1)
+        can1 = ops.disj(can1, term);
+      else
+        can0 = ops.disj(can0, term);
+    }
+    r = {ops.conj(can1, ops.neg(can0)), ops.conj(can0, ops.neg(can1))};
+    break;
+  }
+  }
+  if (f == GateFunction::Not || f == GateFunction::Nand || f == GateFunction::Nor || f == GateFunction::Xnor)
+    std::swap(r.one, r.zero);
+  return r;
+}
+
+/**
+ *  Gates on SAT literals, folding constants
+ *
+ */
+struct SatOps
+{
+  typedef SatSolver::Lit Value;
+  SatSolver& sat;
+  Value top;
+
+  explicit SatOps(SatSolver& solver) : sat(solver), top(SatSolver::lit(solver.newVar()))
+  {
+    sat.addClause({top});
+  }
+  inline Value truth() const { return top; }
+  inline Value falsity() const { return top ^ 1; }
+  inline Value neg(Value x) const { return x ^ 1; }
+  Value conj(Value x, Value y)
+  {
+    if (x == falsity() || y == falsity() || x == (y ^ 1))
+      return falsity();
+    if (x == top || x == y)
+      return y;
+    if (y == top)
+      return x;
+    Value z = SatSolver::lit(sat.newVar());
+    sat.addClause({z ^ 1, x});
+    sat.addClause({z ^ 1, y});
+    sat.addClause({z, x ^ 1, y ^ 1});
+    return z;
+  }
+  inline Value disj(Value x, Value y) { return conj(x ^ 1, y ^ 1) ^ 1; }
+  Value parity(Value x, Value y)
+  {
+    if (x == falsity())
+      return y;
+    if (y == falsity())
+      return x;
+    if (x == top)
+      return y ^ 1;
+    if (y == top)
+      return x ^ 1;
+    Value z = SatSolver::lit(sat.newVar());
+    sat.addClause({x ^ 1, y ^ 1, z ^ 1});
+    sat.addClause({x, y, z ^ 1});
+    sat.addClause({x ^ 1, y, z});
+    sat.addClause({x, y ^ 1, z});
+    return z;
+  }
+};
+
+/**
+ *  Gates on BDDs
+ *
+ */
+struct BddOps
+{
+  typedef Bdd Value;
+  BddManager& mgr;
+
+  inline Value truth() { return mgr.one(); }
+  inline Value falsity() { return mgr.zero(); }
+  inline Value neg(Value const& x) { return ~x; }
+  inline Value conj(Value const& x, Value const& y) { return x & y; }
+  inline Value disj(Value const& x, Value const& y) { return x | y; }
+  inline Value parity(Value const& x, Value const& y) { return x ^ y; }
+};
+
+/**
+ *  Tseitin encoding of a netlist into SAT literals (undriven nets X)
+ *
+ *  Nets X cannot reach get one variable; the others get both rails.
+ */
+static void encode(SatOps& ops, Netlist const& nl, std::vector<Rail<SatSolver::Lit>>& rails)
+{
+  typedef SatSolver::Lit Lit;
+  SatSolver& sat = ops.sat;
+  std::vector<Rail<Lit>> rin;
+  for (auto g : nl.order())
+  {
+    GateType const& t = nl.type(g);
+    rin.clear();
+    bool binary = true;
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      rin.push_back(rails[nl.pin(g, t.inputTerminal(k))]);
+      binary &= rin.back().zero == (rin.back().one ^ 1);
+    }
+    for (size_t k = 0; k < t.outputs(); k++)
+    {
+      NetId net = nl.pin(g, t.outputTerminal(k));
+      if (!binary)
+      {
+        rails[net] = ternary(ops, t, k, rin);
+        continue;
+      }
+      std::vector<Lit> in;
+      for (auto const& x : rin)
+        in.push_back(x.one);
+      int out        = sat.newVar();
+      rails[net]     = {SatSolver::lit(out), SatSolver::lit(out, true)};
+      GateFunction f = t.function();
+      bool inv       = f == GateFunction::Not || f == GateFunction::Nand || f == GateFunction::Nor || f == GateFunction::Xnor;
+      Lit y          = SatSolver::lit(out, inv);
+      switch (f)
+      {
+      case GateFunction::Buffer:
+      case GateFunction::Not:
+        sat.addClause({in[0] ^ 1, y});
+        sat.addClause({in[0], y ^ 1});
+        break;
+      case GateFunction::And:
+      case GateFunction::Nand:
+      {
+        std::vector<Lit> big{y};
+        for (auto x : in)
+        {
+          sat.addClause({x, y ^ 1});
+          big.push_back(x ^ 1);
+        }
+        sat.addClause(big);
+        break;
+      }
+      case GateFunction::Or:
+      case GateFunction::Nor:
+      {
+        std::vector<Lit> big{y ^ 1};
+        for (auto x : in)
+        {
+          sat.addClause({x ^ 1, y});
+          big.push_back(x);
+        }
+        sat.addClause(big);
+        break;
+      }
+      case GateFunction::Xor:
+      case GateFunction::Xnor:
+      {
+        Lit acc = in.empty() ? -1 : in[0];
+        for (size_t i = 1; i < in.size(); i++)
+        {
+          Lit z = i + 1 == in.size() ? y : SatSolver::lit(sat.newVar());
+          sat.addClause({acc ^ 1, in[i] ^ 1, z ^ 1});
+          sat.addClause({acc, in[i], z ^ 1});
+          sat.addClause({acc ^ 1, in[i], z});
+          sat.addClause({acc, in[i] ^ 1, z});
+          acc = z;
+        }
+        if (in.size() == 1)
+        {
+          sat.addClause({acc ^ 1, y});
+          sat.addClause({acc, y ^ 1});
+        }
+        else if (in.empty())
+          sat.addClause({y ^ 1});
+        break;
+      }
+      case GateFunction::Lut:
+        for (size_t m = 0; m < (size_t(1) << in.size()); m++)
+        {
+          std::vector<Lit> clause;
+          for (size_t i = 0; i < in.size(); i++)
+            clause.push_back(in[i] ^ ((m >> i) & 1));
+          clause.push_back(((t.table(k) >> m) & 1) ? y : y ^ 1);
+          sat.addClause(clause);
+        }
+        break;
+      }
+    }
+  }
+}
+
+EquivalenceResult EquivalenceChecker::sat() const
+{
+  typedef SatSolver::Lit Lit;
+  SatSolver sat;
+  SatOps ops(sat);
+  Rail<Lit> x{ops.falsity(), ops.falsity()};
+  std::vector<Rail<Lit>> ra(a.nets(), x), rb(b.nets(), x);
+  std::vector<int> vars;
+  for (size_t i = 0; i < a.inputs().size(); i++)
+  {
+    vars.push_back(sat.newVar());
+    ra[a.inputs()[i]] = rb[b.inputs()[i]] = {SatSolver::lit(vars.back()), SatSolver::lit(vars.back(), true)};
+  }
+  encode(ops, a, ra);
+  encode(ops, b, rb);
+  // Miter: at least one output pair is known on both sides and differs
+  std::vector<Lit> any;
+  for (size_t o = 0; o < a.outputs().size(); o++)
+  {
+    Rail<Lit> pa = ra[a.outputs()[o]], pb = rb[b.outputs()[o]];
+    Lit d = ops.disj(ops.conj(pa.one, pb.zero), ops.conj(pa.zero, pb.one));
+    if (d != ops.falsity())
+      any.push_back(d);
+  }
+  if (any.empty() || !sat.addClause(any) || !sat.solve())
+    return {true, "sat", {}, 0};
+  std::vector<unsigned short> vec;
+  for (auto v : vars)
+    vec.push_back(sat.model(v));
+  return found("sat", vec);
+}
+
+/**
+ *  Rails of the outputs of a netlist as BDDs over its inputs (undriven nets X)
+ *
+ */
+static std::vector<Rail<Bdd>> coneRails(BddOps& ops, Netlist const& nl)
+{
+  BddManager& mgr = ops.mgr;
+  while (mgr.vars() < nl.inputs().size())
+    mgr.newVar();
+  std::vector<Rail<Bdd>> rails(nl.nets(), Rail<Bdd>{mgr.zero(), mgr.zero()});
+  for (size_t i = 0; i < nl.inputs().size(); i++)
+    rails[nl.inputs()[i]] = {mgr.var(i), ~mgr.var(i)};
+
+  // Gates of the output cones, and how many of them still read every net
+  std::vector<char> seen(nl.nets(), 0), inCone(nl.gates(), 0), isRoot(nl.nets(), 0);
+  std::vector<uint32_t> readers(nl.nets(), 0);
+  std::vector<NetId> stack;
+  for (auto net : nl.outputs())
+  {
+    isRoot[net] = 1;
+    stack.push_back(net);
+  }
+  while (!stack.empty())
+  {
+    NetId net = stack.back();
+    stack.pop_back();
+    if (seen[net])
+      continue;
+    seen[net]  = 1;
+    uint32_t g = nl.driver(net);
+    if (g == NoGate || inCone[g])
+      continue;
+    inCone[g]         = 1;
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      readers[nl.pin(g, t.inputTerminal(k))]++;
+      stack.push_back(nl.pin(g, t.inputTerminal(k)));
+    }
+  }
+
+  std::vector<Rail<Bdd>> rin;
+  std::vector<Bdd> in;
+  for (auto g : nl.order())
+  {
+    if (!inCone[g])
+      continue;
+    GateType const& t = nl.type(g);
+    rin.clear();
+    in.clear();
+    bool binary = true;
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      rin.push_back(rails[nl.pin(g, t.inputTerminal(k))]);
+      in.push_back(rin.back().one);
+      binary &= rin.back().zero == ~rin.back().one;
+    }
+    for (size_t k = 0; k < t.outputs(); k++)
+    {
+      Rail<Bdd>& r = rails[nl.pin(g, t.outputTerminal(k))];
+      if (binary)
+      {
+        r.one  = mgr.gate(t, k, in);
+        r.zero = ~r.one;
+      }
+      else
+        r = ternary(ops, t, k, rin);
+    }
+    // Drop fanin functions nobody else needs, so their nodes can be collected
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      NetId net = nl.pin(g, t.inputTerminal(k));
+      if (!--readers[net] && !isRoot[net])
+        rails[net] = {Bdd(), Bdd()};
+    }
+  }
+  std::vector<Rail<Bdd>> res;
+  for (auto net : nl.outputs())
+    res.push_back(rails[net]);
+  return res;
+}
+
+EquivalenceResult EquivalenceChecker::bdd() const
+{
+  BddManager mgr;
+  mgr.nodeLimit   = bddNodeLimit;
+  mgr.autoReorder = true;
+  BddOps ops{mgr};
+  std::vector<Rail<Bdd>> ra = coneRails(ops, a), rb = coneRails(ops, b);
+  for (size_t o = 0; o < ra.size(); o++)
+  {
+    Bdd diff = (ra[o].one & rb[o].zero) | (ra[o].zero & rb[o].one);
+    if (diff == mgr.zero())
+      continue;
+    std::vector<unsigned short> vec = mgr.pickOne(diff);
+    vec.resize(a.inputs().size());
+    for (auto& s : vec)
+      s = s == 2 ? 0 : s;
+    return found("bdd", vec);
+  }
+  return {true, "bdd", {}, 0};
+}
+
+EquivalenceResult EquivalenceChecker::check() const
+{
+  EquivalenceResult res = random();
+  if (!res.equivalent)
+    return res;
+  if (a.inputs().size() <= std::min(exhaustiveLimit, MaxExhaustive))
+    return exhaustive();
+  if (bddNodeLimit)
+    try
+    {
+      return bdd();
+    }
+    catch (BddOverflow const&)
+    {
+    }
+  return sat();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <string>
+#include <vector>
+/**
+ *  Outcome of an equivalence check
+ *
+ */
+struct EquivalenceResult
+{
+  bool equivalent;
+  /**
+   *  Engine that decided: "random", "exhaustive", "bdd" or "sat"
+   *
+   */
+  std::string method;
+  /**
+   *  Input states showing a difference (2 - don't care), empty if equivalent
+   *
+   */
+  std::vector<unsigned short> counterexample;
+  /**
+   *  First output that differs under the counterexample
+   *
+   */
+  size_t output = 0;
+};
+/**
+ *  Combinational equivalence checker for two netlists
+ *
+ *  Inputs and outputs are matched by position. Random bit-parallel
+ *  simulation runs first; if it finds nothing, designs with at most
+ *  exhaustiveLimit inputs are enumerated on all threads, larger ones are
+ *  compared as BDDs (equal functions give equal nodes) and fall back to a
+ *  SAT miter when the diagrams outgrow bddNodeLimit. Counterexamples are
+ *  reduced to a 1-minimal set of specified inputs (others X): dropping any
+ *  single one of them no longer forces a difference.
+ *
+ *  All engines share the ternary semantics of GateType::evaluate: nets
+ *  without a driver are X, and an output pair differs only where both
+ *  sides are known and unequal. BDDs and SAT track X as two rails (known
+ *  1, known 0) on the nets it can reach. Every reported counterexample is
+ *  confirmed by simulation.
+ */
+class EquivalenceChecker
+{
+  Netlist const& a;
+  Netlist const& b;
+
+  bool differs(std::vector<unsigned short> const& vec, size_t& output) const;
+  bool simulate(Planes const* inputs, std::vector<Planes>& va, std::vector<Planes>& vb, size_t& lane) const;
+  EquivalenceResult random() const;
+  EquivalenceResult exhaustive() const;
+  EquivalenceResult bdd() const;
+  EquivalenceResult sat() const;
+  EquivalenceResult found(std::string method, std::vector<unsigned short> vec) const;
+
+public:
+  uint64_t seed          = 1;
+  /**
+   *  Largest exhaustiveLimit honoured (2^38 vectors)
+   *
+   */
+  static constexpr size_t MaxExhaustive = 38;
+
+  uint64_t randomBlocks  = 1024;
+  size_t exhaustiveLimit = 32;
+  unsigned threads       = 0;
+  /**
+   *  BDD node limit before falling back to SAT (0 - skip BDDs)
+   *
+   */
+  size_t bddNodeLimit = 1 << 20;
+
+  EquivalenceChecker(Netlist const& first, Netlist const& second);
+  /**
+   *  Decide equivalence
+   *
+   *  EquivalenceResult
+   */
+  EquivalenceResult check() const;
+  /**
+   *  Drop inputs from a counterexample while it still shows a difference
+   *
+   *  vec full 0/1 counterexample
+   *  std::vector<unsigned short> counterexample with don't cares (2)
+   */
+  std::vector<unsigned short> minimize(std::vector<unsigned short> vec) const;
+};
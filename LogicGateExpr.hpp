@@ -0,0 +1,324 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include "LogicGateType.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+/**
+ *  Compile-time circuit description
+ *
+ *  auto c = dsl::out(dsl::nand(dsl::in<0>, dsl::in<1>));
+ *
+ *  Every node is a distinct type holding its operands by value, so a
+ *  circuit is an expression template the compiler flattens into straight-
+ *  line bitwise code: no graph, allocation or dispatch at run time. Values
+ *  may be bool, uint64_t (64 two-valued lanes) or Planes (64 three-valued
+ *  lanes), and every evaluation is constexpr.
+ */
+namespace dsl
+{
+/**
+ *  Base of all expression nodes
+ *
+ */
+struct Expr
+{
+};
+template <typename T>
+constexpr bool isExpr = std::is_base_of<Expr, T>::value;
+
+// Operations per value kind; Planes follow the three-valued rules of Bus
+constexpr bool notOf(bool a) { return !a; }
+constexpr bool andOf(bool a, bool b) { return a && b; }
+constexpr bool orOf(bool a, bool b) { return a || b; }
+constexpr bool xorOf(bool a, bool b) { return a != b; }
+constexpr uint64_t notOf(uint64_t a) { return ~a; }
+constexpr uint64_t andOf(uint64_t a, uint64_t b) { return a & b; }
+constexpr uint64_t orOf(uint64_t a, uint64_t b) { return a | b; }
+constexpr uint64_t xorOf(uint64_t a, uint64_t b) { return a ^ b; }
+constexpr Planes notOf(Planes a) { return {~a.val & ~a.unk, a.unk}; }
+constexpr Planes andOf(Planes a, Planes b)
+{
+  uint64_t one  = a.val & ~a.unk & b.val & ~b.unk;
+  uint64_t zero = (~a.val & ~a.unk) | (~b.val & ~b.unk);
+  return {one, ~(one | zero)};
+}
+constexpr Planes orOf(Planes a, Planes b)
+{
+  uint64_t one  = (a.val & ~a.unk) | (b.val & ~b.unk);
+  uint64_t zero = ~a.val & ~a.unk & ~b.val & ~b.unk;
+  return {one, ~(one | zero)};
+}
+constexpr Planes xorOf(Planes a, Planes b) { return {(a.val ^ b.val) & ~(a.unk | b.unk), a.unk | b.unk}; }
+
+template <typename V>
+constexpr V constant(bool high)
+{
+  if constexpr (std::is_same<V, Planes>::value)
+    return {high ? ~0ULL : 0, 0};
+  else if constexpr (std::is_same<V, bool>::value)
+    return high;
+  else
+    return high ? ~V(0) : V(0);
+}
+/**
+ *  Primary input N
+ *
+ */
+template <size_t N>
+struct Input : Expr
+{
+  static constexpr size_t arity = N + 1;
+  template <typename V>
+  constexpr V operator()(V const* in) const
+  {
+    return in[N];
+  }
+};
+template <size_t N>
+constexpr Input<N> in{};
+/**
+ *  Constant Low (false) or High (true)
+ *
+ */
+template <bool High>
+struct Const : Expr
+{
+  static constexpr size_t arity = 0;
+  template <typename V>
+  constexpr V operator()(V const*) const
+  {
+    return constant<V>(High);
+  }
+};
+constexpr Const<false> lo{};
+constexpr Const<true> hi{};
+
+template <typename A>
+struct Not : Expr
+{
+  A a;
+  static constexpr size_t arity = A::arity;
+  template <typename V>
+  constexpr V operator()(V const* in) const
+  {
+    return notOf(a(in));
+  }
+};
+
+enum class Op
+{
+  And,
+  Or,
+  Xor
+};
+
+template <Op O, typename A, typename B>
+struct Binary : Expr
+{
+  A a;
+  B b;
+  static constexpr size_t arity = A::arity > B::arity ? A::arity : B::arity;
+  template <typename V>
+  constexpr V operator()(V const* in) const
+  {
+    if constexpr (O == Op::And)
+      return andOf(a(in), b(in));
+    else if constexpr (O == Op::Or)
+      return orOf(a(in), b(in));
+    else
+      return xorOf(a(in), b(in));
+  }
+};
+
+template <typename A, typename = std::enable_if_t<isExpr<A>>>
+constexpr Not<A> operator~(A a)
+{
+  return {{}, a};
+}
+template <typename A, typename B, typename = std::enable_if_t<isExpr<A> && isExpr<B>>>
+constexpr Binary<Op::And, A, B> operator&(A a, B b)
+{
+  return {{}, a, b};
+}
+template <typename A, typename B, typename = std::enable_if_t<isExpr<A> && isExpr<B>>>
+constexpr Binary<Op::Or, A, B> operator|(A a, B b)
+{
+  return {{}, a, b};
+}
+template <typename A, typename B, typename = std::enable_if_t<isExpr<A> && isExpr<B>>>
+constexpr Binary<Op::Xor, A, B> operator^(A a, B b)
+{
+  return {{}, a, b};
+}
+// Gate functions of any number of operands (not/and/or/xor are keywords)
+template <typename A>
+constexpr auto not_(A a)
+{
+  return ~a;
+}
+template <typename A, typename... R>
+constexpr auto and_(A a, R... r)
+{
+  return (a & ... & r);
+}
+template <typename A, typename... R>
+constexpr auto or_(A a, R... r)
+{
+  return (a | ... | r);
+}
+template <typename A, typename... R>
+constexpr auto xor_(A a, R... r)
+{
+  return (a ^ ... ^ r);
+}
+template <typename A, typename... R>
+constexpr auto nand(A a, R... r)
+{
+  return ~and_(a, r...);
+}
+template <typename A, typename... R>
+constexpr auto nor(A a, R... r)
+{
+  return ~or_(a, r...);
+}
+template <typename A, typename... R>
+constexpr auto xnor(A a, R... r)
+{
+  return ~xor_(a, r...);
+}
+/**
+ *  sel ? b : a
+ *
+ */
+template <typename S, typename A, typename B>
+constexpr auto mux(S sel, A a, B b)
+{
+  return (~sel & a) | (sel & b);
+}
+/**
+ *  Circuit with one output per expression
+ *
+ */
+template <typename... E>
+struct Circuit
+{
+  std::tuple<E...> exprs;
+
+  static constexpr size_t inputs = [] {
+    size_t res = 0;
+    for (size_t a : {size_t(0), E::arity...})
+      res = a > res ? a : res;
+    return res;
+  }();
+  static constexpr size_t outputs = sizeof...(E);
+
+  /**
+   *  Output K for input values in[0 .. inputs)
+   *
+   */
+  template <size_t K, typename V>
+  constexpr V output(V const* in) const
+  {
+    return std::get<K>(exprs)(in);
+  }
+  /**
+   *  All outputs for input values in[0 .. inputs)
+   *
+   */
+  template <typename V>
+  constexpr void evaluate(V const* in, V* res) const
+  {
+    evaluate(in, res, std::index_sequence_for<E...>{});
+  }
+  /**
+   *  Truth table of output K (bit m - value for input minterm m)
+   *
+   */
+  template <size_t K = 0>
+  constexpr uint64_t table() const
+  {
+    static_assert(inputs <= GateType::MaxLutInputs, "Truth tables cover at most 6 inputs");
+    // Lane m of input i holds bit i of m
+    const uint64_t lanes[6] = {0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+                               0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL};
+    uint64_t used = inputs == 6 ? ~0ULL : (1ULL << (1u << inputs)) - 1;
+    return output<K>(lanes) & used;
+  }
+  /**
+   *  Lookup-table gate type of the circuit (inputs first)
+   *
+   */
+  GateType type(std::string name) const
+  {
+    return GateType(std::move(name), directions(), tables(std::index_sequence_for<E...>{}));
+  }
+  /**
+   *  New gate (inputs first) with all inputs Low and outputs evaluated
+   *
+   */
+  Gate gate() const
+  {
+    Gate res(inputs, outputs);
+    evaluate(res.view());
+    return res;
+  }
+  /**
+   *  Read input terminals of gate, write its output terminals
+   *
+   *  Inputs and outputs are taken in terminal order; the gate must have
+   *  exactly inputs and outputs terminals of each direction.
+   */
+  void evaluate(GateView gate) const
+  {
+    Planes in[inputs ? inputs : 1], res[outputs ? outputs : 1];
+    size_t i = 0, o = 0;
+    for (auto const& term : gate)
+      if (term.isOutput)
+        o++;
+      else if (i < inputs)
+        in[i++] = {term.state == 1 ? ~0ULL : 0, term.state == 2 ? ~0ULL : 0};
+      else
+        i++;
+    if (i != inputs || o != outputs)
+      throw std::runtime_error("Gate does not match the circuit");
+    evaluate(in, res);
+    o = 0;
+    for (size_t n = 0; n < gate.size(); n++)
+      if (gate.terminal(n).isOutput)
+        gate(n, res[o++].lane(0));
+  }
+
+private:
+  template <typename V, size_t... K>
+  constexpr void evaluate(V const* in, V* res, std::index_sequence<K...>) const
+  {
+    ((res[K] = output<K>(in)), ...);
+  }
+  template <size_t... K>
+  std::vector<uint64_t> tables(std::index_sequence<K...>) const
+  {
+    return {table<K>()...};
+  }
+  static std::vector<bool> directions()
+  {
+    std::vector<bool> res(inputs, false);
+    res.resize(inputs + outputs, true);
+    return res;
+  }
+};
+/**
+ *  Circuit computing one output per expression
+ *
+ */
+template <typename... E>
+constexpr Circuit<E...> out(E... e)
+{
+  static_assert((isExpr<E> && ...), "Outputs must be circuit expressions");
+  return {std::tuple<E...>(e...)};
+}
+} // namespace dsl
@@ -0,0 +1,410 @@
+#include "LogicGateJournal.hpp"
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+static const char JournalMagic[]  = "LGJRNL1\n";
+static const char SnapshotMagic[] = "LGSNAP1\n";
+constexpr size_t HeaderSize       = 16;
+
+static uint32_t crc32(char const* data, size_t size)
+{
+  static const auto table = [] {
+    std::array<uint32_t, 256> res;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++)
+        c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      res[i] = c;
+    }
+    return res;
+  }();
+  uint32_t c = ~0u;
+  for (size_t i = 0; i < size; i++)
+    c = table[(c ^ uint8_t(data[i])) & 0xff] ^ (c >> 8);
+  return ~c;
+}
+
+static void writeAll(int fd, char const* data, size_t size)
+{
+  while (size)
+  {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      throw std::system_error(errno, std::generic_category(), "write");
+    }
+    data += n;
+    size -= n;
+  }
+}
+
+static bool readFile(std::string const& name, std::string& out)
+{
+  out.clear();
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    if (errno == ENOENT)
+      return false;
+    throw std::system_error(errno, std::generic_category(), name);
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0)
+    out.resize(st.st_size);
+  size_t done = 0;
+  while (done < out.size())
+  {
+    ssize_t n = ::read(fd, &out[done], out.size() - done);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    done += n;
+  }
+  out.resize(done);
+  close(fd);
+  return true;
+}
+
+template <typename T>
+static void put(std::string& out, T value)
+{
+  out.append(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+static void putTerminal(std::string& out, Terminal const& term)
+{
+  put<uint8_t>(out, term.isOutput);
+  put<uint16_t>(out, term.conn_num);
+  put<uint16_t>(out, term.state);
+}
+
+namespace
+{
+struct Reader
+{
+  char const* pos;
+  char const* end;
+
+  template <typename T>
+  bool get(T& value)
+  {
+    if (size_t(end - pos) < sizeof(value))
+      return false;
+    std::memcpy(&value, pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+  }
+  bool get(Terminal& term)
+  {
+    uint8_t out;
+    if (!get(out) || !get(term.conn_num) || !get(term.state))
+      return false;
+    term.isOutput = out;
+    return true;
+  }
+};
+} // namespace
+
+size_t Journal::restore(std::string& data)
+{
+  if (readFile(path + ".snap", data))
+  {
+    existed = true;
+    if (data.size() < HeaderSize || std::memcmp(data.data(), SnapshotMagic, 8))
+      throw std::runtime_error("Corrupt snapshot");
+    std::memcpy(&generation, data.data() + 8, 8);
+    size_t good;
+    restored = apply(data, good);
+    if (good != data.size())
+      throw std::runtime_error("Corrupt snapshot");
+  }
+  bool found = readFile(path, data);
+  size_t good = 0;
+  if (found && data.size() >= HeaderSize)
+  {
+    existed = true;
+    if (std::memcmp(data.data(), JournalMagic, 8))
+      throw std::runtime_error("Not a journal: " + path);
+    uint64_t gen;
+    std::memcpy(&gen, data.data() + 8, 8);
+    if (gen > generation)
+      throw std::runtime_error("Journal is newer than its snapshot");
+    // An older generation is already contained in the snapshot
+    if (gen == generation)
+    {
+      logged = apply(data, good);
+      restored += logged;
+    }
+  }
+  return good;
+}
+
+Journal::Journal(std::string file, GateMap& gates) : path(std::move(file)), map(gates)
+{
+  std::string data;
+  size_t good = restore(data);
+  fd          = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), path);
+  if (good < HeaderSize)
+  {
+    if (ftruncate(fd, 0) < 0)
+      throw std::system_error(errno, std::generic_category(), "ftruncate");
+    writeHeader(fd, JournalMagic, generation);
+  }
+  else if (good < data.size() && ftruncate(fd, good) < 0)
+    throw std::system_error(errno, std::generic_category(), "ftruncate");
+  lseek(fd, 0, SEEK_END);
+}
+
+Journal::Journal(std::string file, GateMap& gates, ReadOnly) : path(std::move(file)), map(gates)
+{
+  std::string data;
+  restore(data);
+  if (!existed)
+    throw std::runtime_error("No journal or snapshot: " + path);
+  // Nothing is pending, and commit() must not compact a file it does not own
+  logged = 0;
+}
+
+size_t Journal::load(std::string const& file, GateMap& gates)
+{
+  Journal reader(file, gates, ReadOnly{});
+  return reader.restored;
+}
+
+Journal::~Journal()
+{
+  try
+  {
+    commit();
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  if (fd >= 0)
+    close(fd);
+}
+
+void Journal::writeHeader(int file, char const* magic, uint64_t gen)
+{
+  char header[HeaderSize];
+  std::memcpy(header, magic, 8);
+  std::memcpy(header + 8, &gen, 8);
+  lseek(file, 0, SEEK_SET);
+  writeAll(file, header, HeaderSize);
+}
+
+void Journal::encode(std::string& out, Op op, std::string const& name, uint32_t pos) const
+{
+  size_t start = out.size();
+  put<uint64_t>(out, 0);
+  put<uint8_t>(out, op);
+  put<uint32_t>(out, name.size());
+  out += name;
+  switch (op)
+  {
+  case PutGate:
+  {
+    Gate const& gate = map.at(name);
+    put<uint32_t>(out, gate.size());
+    for (size_t i = 0; i < gate.size(); i++)
+      putTerminal(out, gate.terminal(i));
+    break;
+  }
+  case AddTerminal:
+  {
+    Gate const& gate = map.at(name);
+    putTerminal(out, gate.terminal(gate.size() - 1));
+    break;
+  }
+  case SetState:
+    put<uint32_t>(out, pos);
+    put<uint16_t>(out, map.at(name).terminal(pos).state);
+    break;
+  case Connect:
+  case Disconnect:
+    put<uint32_t>(out, pos);
+    break;
+  case RemoveGate:
+    break;
+  }
+  uint32_t size = out.size() - start - 8;
+  uint32_t crc  = crc32(&out[start + 8], size);
+  std::memcpy(&out[start], &size, 4);
+  std::memcpy(&out[start + 4], &crc, 4);
+}
+
+void Journal::record(Op op, std::string const& name, uint32_t pos)
+{
+  encode(pending, op, name, pos);
+  logged++;
+  if (++grouped >= groupSize)
+    commit();
+}
+
+size_t Journal::apply(std::string const& data, size_t& good)
+{
+  size_t count = 0;
+  good         = HeaderSize;
+  std::string name;
+  std::vector<Terminal> terms;
+  // Consecutive edits mostly hit the same gate
+  GateMap::iterator last = map.end();
+  while (data.size() - good >= 8)
+  {
+    uint32_t size, crc;
+    std::memcpy(&size, &data[good], 4);
+    std::memcpy(&crc, &data[good + 4], 4);
+    if (data.size() - good - 8 < size)
+      break;
+    char const* payload = &data[good + 8];
+    if (crc32(payload, size) != crc)
+      break;
+    Reader in{payload, payload + size};
+    uint8_t op;
+    uint32_t len, pos;
+    if (!in.get(op) || !in.get(len) || size_t(in.end - in.pos) < len)
+      break;
+    if (last == map.end() || last->first.size() != len || last->first.compare(0, len, in.pos, len))
+    {
+      name.assign(in.pos, len);
+      last = map.find(name);
+    }
+    in.pos += len;
+    try
+    {
+      bool ok = true;
+      if (op == PutGate)
+      {
+        ok = in.get(len) && len <= size_t(in.end - in.pos) / 5;
+        terms.resize(ok ? len : 0);
+        for (auto& term : terms)
+          ok = ok && in.get(term);
+        if (ok && last != map.end())
+          last->second = Gate(terms);
+        else if (ok)
+          last = map.emplace(name, Gate(terms)).first;
+      }
+      else if (op == RemoveGate)
+      {
+        if (last != map.end())
+          map.erase(last);
+        last = map.end();
+      }
+      else
+      {
+        if (last == map.end())
+          last = map.emplace(name, Gate{}).first;
+        Terminal term;
+        uint16_t state;
+        switch (op)
+        {
+        case AddTerminal:
+          if ((ok = in.get(term)))
+            last->second += std::move(term);
+          break;
+        case SetState:
+          if ((ok = in.get(pos) && in.get(state)))
+            last->second(pos, state);
+          break;
+        case Connect:
+          if ((ok = in.get(pos)))
+            last->second.connect(pos);
+          break;
+        case Disconnect:
+          if ((ok = in.get(pos)))
+            last->second.disconnect(pos);
+          break;
+        default:
+          ok = false;
+        }
+      }
+      if (!ok || in.pos != in.end)
+        break;
+    }
+    catch (std::exception&)
+    {
+      break;
+    }
+    good += 8 + size;
+    count++;
+  }
+  return count;
+}
+
+void Journal::putGate(std::string const& name) { record(PutGate, name); }
+void Journal::removeGate(std::string const& name) { record(RemoveGate, name); }
+void Journal::addTerminal(std::string const& name) { record(AddTerminal, name); }
+void Journal::setState(std::string const& name, uint32_t pos) { record(SetState, name, pos); }
+void Journal::connect(std::string const& name, uint32_t pos) { record(Connect, name, pos); }
+void Journal::disconnect(std::string const& name, uint32_t pos) { record(Disconnect, name, pos); }
+
+void Journal::commit()
+{
+  if (!pending.empty())
+  {
+    writeAll(fd, pending.data(), pending.size());
+    pending.clear();
+    if (durable && fdatasync(fd) < 0)
+      throw std::system_error(errno, std::generic_category(), "fdatasync");
+  }
+  grouped = 0;
+  if (logged >= compactEvery)
+    compact();
+}
+
+void Journal::compact()
+{
+  // The snapshot covers everything still pending
+  pending.clear();
+  grouped = 0;
+  std::string snap = path + ".snap", tmp = snap + ".tmp", data;
+  for (auto const& keyval : map)
+    encode(data, PutGate, keyval.first, 0);
+  int sfd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (sfd < 0)
+    throw std::system_error(errno, std::generic_category(), tmp);
+  try
+  {
+    writeHeader(sfd, SnapshotMagic, generation + 1);
+    writeAll(sfd, data.data(), data.size());
+    if (fsync(sfd) < 0)
+      throw std::system_error(errno, std::generic_category(), "fsync");
+  }
+  catch (...)
+  {
+    close(sfd);
+    throw;
+  }
+  close(sfd);
+  if (std::rename(tmp.c_str(), snap.c_str()) < 0)
+    throw std::system_error(errno, std::generic_category(), "rename");
+  size_t slash    = path.rfind('/');
+  std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+  int dfd         = open(dir.c_str(), O_RDONLY);
+  if (dfd >= 0)
+  {
+    fsync(dfd);
+    close(dfd);
+  }
+  // From here the old journal generation is ignored on replay
+  generation++;
+  if (ftruncate(fd, 0) < 0)
+    throw std::system_error(errno, std::generic_category(), "ftruncate");
+  writeHeader(fd, JournalMagic, generation);
+  if (durable)
+    fdatasync(fd);
+  logged = 0;
+}
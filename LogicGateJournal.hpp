@@ -0,0 +1,134 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include <cstdint>
+#include <string>
+/**
+ *  Append-only journal of interactive session edits
+ *
+ *  Files: <path> holds a header and checksummed records, <path>.snap holds
+ *  a compacted snapshot (one PutGate record per gate). Both headers carry a
+ *  generation number; journal records only apply on top of the snapshot of
+ *  the same generation, so a crash during compaction never replays an edit
+ *  twice. A torn or corrupt tail is cut off at the last good record.
+ *
+ *  Record: u32 payload size, u32 CRC-32 of payload, payload (op, name,
+ *  arguments) in host byte order.
+ */
+class Journal
+{
+  enum Op : uint8_t
+  {
+    PutGate = 1,
+    RemoveGate,
+    AddTerminal,
+    SetState,
+    Connect,
+    Disconnect
+  };
+
+  std::string path;
+  GateMap& map;
+  int fd = -1;
+  uint64_t generation = 0;
+  /**
+   *  Encoded records of the current group
+   *
+   */
+  std::string pending;
+  size_t grouped  = 0;
+  size_t logged   = 0;
+  size_t restored = 0;
+  bool existed    = false;
+
+  void encode(std::string& out, Op op, std::string const& name, uint32_t pos) const;
+  void record(Op op, std::string const& name, uint32_t pos = 0);
+  void writeHeader(int file, char const* magic, uint64_t gen);
+  size_t apply(std::string const& data, size_t& good);
+  /**
+   *  Read snapshot and journal into the map
+   *
+   *  size_t length of the good journal prefix
+   */
+  size_t restore(std::string& data);
+  struct ReadOnly
+  {
+  };
+  Journal(std::string file, GateMap& gates, ReadOnly);
+
+public:
+  /**
+   *  Records per group before an implicit commit
+   *
+   */
+  size_t groupSize = 4096;
+  /**
+   *  Journal records after which commit() compacts
+   *
+   */
+  size_t compactEvery = 1 << 20;
+  /**
+   *  Flush every group to stable storage
+   *
+   */
+  bool durable = true;
+
+  /**
+   *  Open (or create) the journal and restore the session into gates
+   *
+   *  file journal path
+   *  gates session map mirrored by the journal
+   */
+  Journal(std::string file, GateMap& gates);
+  /**
+   *  Restore a saved session into gates without opening it for writing
+   *
+   *  size_t records restored (throws if neither file exists)
+   */
+  static size_t load(std::string const& file, GateMap& gates);
+  Journal(Journal const&) = delete;
+  Journal& operator=(Journal const&) = delete;
+  ~Journal();
+  /**
+   *  Records restored by the constructor
+   *
+   */
+  inline size_t replayed() const { return restored; }
+  /**
+   *  Whether neither journal nor snapshot existed before
+   *
+   */
+  inline bool fresh() const { return !existed; }
+  /**
+   *  Journal records since the last snapshot
+   *
+   */
+  inline size_t size() const { return logged; }
+  /**
+   *  Record gate name as currently stored in the map (new or replaced)
+   *
+   */
+  void putGate(std::string const& name);
+  void removeGate(std::string const& name);
+  /**
+   *  Record the last terminal of gate name
+   *
+   */
+  void addTerminal(std::string const& name);
+  /**
+   *  Record the current state of terminal pos of gate name
+   *
+   */
+  void setState(std::string const& name, uint32_t pos);
+  void connect(std::string const& name, uint32_t pos);
+  void disconnect(std::string const& name, uint32_t pos);
+  /**
+   *  Write the current group with one write (and sync), compact if due
+   *
+   */
+  void commit();
+  /**
+   *  Snapshot the map and start an empty journal generation
+   *
+   */
+  void compact();
+};
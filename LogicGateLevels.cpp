@@ -0,0 +1,251 @@
+#include "LogicGateLevels.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+IncrementalLevels::IncrementalLevels(Netlist& netlist) : nl(netlist)
+{
+  size_t n = nl.gates();
+  levels.resize(n);
+  slots.resize(n);
+  marks.assign(n, 0);
+  readers.resize(nl.nets());
+  for (uint32_t g = 0; g < n; g++)
+  {
+    levels[g] = nl.level(g);
+    if (levels[g] >= buckets.size())
+      buckets.resize(levels[g] + 1);
+    slots[g] = buckets[levels[g]].size();
+    buckets[levels[g]].push_back(g);
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+      readers[nl.pin(g, t.inputTerminal(k))].push_back(g);
+  }
+}
+
+void IncrementalLevels::sync()
+{
+  if (nl.gates() != levels.size())
+    throw std::runtime_error("Netlist edited behind IncrementalLevels");
+  readers.resize(nl.nets());
+}
+
+uint32_t IncrementalLevels::nextEpoch()
+{
+  if (++epoch == 0)
+  {
+    std::fill(marks.begin(), marks.end(), 0);
+    epoch = 1;
+  }
+  return epoch;
+}
+
+uint32_t IncrementalLevels::fanin(uint32_t g) const
+{
+  GateType const& t = nl.type(g);
+  uint32_t res      = 0;
+  for (size_t k = 0; k < t.inputs(); k++)
+  {
+    uint32_t d = nl.driver(nl.pin(g, t.inputTerminal(k)));
+    if (d != NoGate)
+      res = std::max(res, levels[d] + 1);
+  }
+  return res;
+}
+
+void IncrementalLevels::place(uint32_t g, uint32_t level)
+{
+  if (slots[g] != UINT32_MAX)
+  {
+    auto& from       = buckets[levels[g]];
+    uint32_t moved   = from.back();
+    from[slots[g]]   = moved;
+    slots[moved]     = slots[g];
+    from.pop_back();
+  }
+  if (level >= buckets.size())
+    buckets.resize(level + 1);
+  levels[g] = level;
+  slots[g]  = buckets[level].size();
+  buckets[level].push_back(g);
+  while (!buckets.empty() && buckets.back().empty())
+    buckets.pop_back();
+}
+
+bool IncrementalLevels::reaches(std::vector<uint32_t> const& starts, std::vector<uint32_t> const& targets)
+{
+  uint32_t limit = 0;
+  uint32_t hit   = nextEpoch();
+  for (auto g : targets)
+  {
+    marks[g] = hit;
+    limit    = std::max(limit, levels[g]);
+  }
+  uint32_t seen = nextEpoch();
+  stack.assign(starts.begin(), starts.end());
+  while (!stack.empty())
+  {
+    uint32_t g = stack.back();
+    stack.pop_back();
+    if (marks[g] == hit)
+      return true;
+    // Paths climb strictly in level, so none passes above the targets
+    if (marks[g] == seen || levels[g] > limit)
+      continue;
+    marks[g]          = seen;
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.outputs(); k++)
+      for (auto r : readers[nl.pin(g, t.outputTerminal(k))])
+        stack.push_back(r);
+  }
+  return false;
+}
+
+void IncrementalLevels::repair(std::vector<uint32_t> const& changed)
+{
+  typedef std::pair<uint32_t, uint32_t> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  uint32_t queued = nextEpoch();
+  for (auto g : changed)
+    if (marks[g] != queued)
+    {
+      marks[g] = queued;
+      queue.push({levels[g], g});
+    }
+  while (!queue.empty())
+  {
+    uint32_t g = queue.top().second;
+    queue.pop();
+    marks[g]       = 0;
+    uint32_t level = fanin(g);
+    if (level == levels[g])
+      continue;
+    place(g, level);
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.outputs(); k++)
+      for (auto r : readers[nl.pin(g, t.outputTerminal(k))])
+        if (marks[r] != queued)
+        {
+          marks[r] = queued;
+          queue.push({levels[r], r});
+        }
+  }
+}
+
+void IncrementalLevels::unread(NetId net, uint32_t g)
+{
+  auto& list = readers[net];
+  auto it    = std::find(list.begin(), list.end(), g);
+  *it        = list.back();
+  list.pop_back();
+}
+
+NetId IncrementalLevels::floatingNet()
+{
+  if (floating == UINT32_MAX)
+  {
+    floating = nl.addNet();
+    readers.resize(nl.nets());
+  }
+  return floating;
+}
+
+uint32_t IncrementalLevels::addGate(uint32_t type, std::vector<NetId> const& pins)
+{
+  sync();
+  if (type >= nl.library().size())
+    throw std::out_of_range("");
+  GateType const& t = nl.library()[type];
+  if (pins.size() != t.size())
+    throw std::runtime_error("Pins do not match gate type");
+  for (auto net : pins)
+    if (net >= nl.nets())
+      throw std::out_of_range("");
+  std::vector<uint32_t> fanins, fanouts;
+  for (size_t k = 0; k < t.inputs(); k++)
+  {
+    uint32_t d = nl.driver(pins[t.inputTerminal(k)]);
+    if (d != NoGate)
+      fanins.push_back(d);
+  }
+  for (size_t k = 0; k < t.outputs(); k++)
+  {
+    NetId out = pins[t.outputTerminal(k)];
+    for (size_t i = 0; i < t.inputs(); i++)
+      if (pins[t.inputTerminal(i)] == out)
+        throw std::runtime_error("Combinational loop");
+    fanouts.insert(fanouts.end(), readers[out].begin(), readers[out].end());
+  }
+  if (!fanins.empty() && !fanouts.empty() && reaches(fanouts, fanins))
+    throw std::runtime_error("Combinational loop");
+
+  uint32_t g = nl.addGate(type, pins);
+  levels.push_back(0);
+  slots.push_back(UINT32_MAX);
+  marks.push_back(0);
+  for (size_t k = 0; k < t.inputs(); k++)
+    readers[pins[t.inputTerminal(k)]].push_back(g);
+  place(g, fanin(g));
+  repair(fanouts);
+  return g;
+}
+
+void IncrementalLevels::connect(uint32_t g, size_t n, NetId net)
+{
+  sync();
+  if (g >= nl.gates() || n >= nl.type(g).size() || net >= nl.nets())
+    throw std::out_of_range("");
+  NetId old = nl.pin(g, n);
+  if (old == net)
+    return;
+  if (!nl.type(g).isOutput(n))
+  {
+    uint32_t d = nl.driver(net);
+    if (d != NoGate && reaches({g}, {d}))
+      throw std::runtime_error("Combinational loop");
+    nl.reconnect(g, n, net);
+    unread(old, g);
+    readers[net].push_back(g);
+    repair({g});
+    return;
+  }
+  // g takes over driving net: its readers become fanout of g
+  if (!readers[net].empty() && reaches(readers[net], {g}))
+    throw std::runtime_error("Combinational loop");
+  nl.reconnect(g, n, net);
+  std::vector<uint32_t> changed = readers[old];
+  changed.insert(changed.end(), readers[net].begin(), readers[net].end());
+  repair(changed);
+}
+
+void IncrementalLevels::disconnect(uint32_t g, size_t n)
+{
+  sync();
+  if (g >= nl.gates() || n >= nl.type(g).size())
+    throw std::out_of_range("");
+  if (nl.type(g).isOutput(n))
+  {
+    NetId net = nl.addNet();
+    readers.resize(nl.nets());
+    connect(g, n, net);
+  }
+  else
+    connect(g, n, floatingNet());
+}
+
+void IncrementalLevels::removeGate(uint32_t g)
+{
+  sync();
+  if (g >= nl.gates())
+    throw std::out_of_range("");
+  for (size_t n = 0; n < nl.type(g).size(); n++)
+    disconnect(g, n);
+}
+
+void IncrementalLevels::evaluate(Planes* values) const
+{
+  for (auto const& bucket : buckets)
+    for (auto g : bucket)
+      nl.evaluateGate(g, values);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <vector>
+/**
+ *  Levels of a netlist kept up to date across edits
+ *
+ *  Levels are longest-path depths as in Netlist::level. Edits made here
+ *  are applied to the netlist and then repaired locally: a new connection
+ *  u -> v is first checked for a path v ~> u, searched only among gates
+ *  below the level of u (no path can climb above it), so a loop is
+ *  rejected before anything changes. Afterwards only gates whose fanin
+ *  level moved are recomputed, lowest level first, stopping wherever a
+ *  level stays the same. Gates are kept in per-level buckets, so a
+ *  levelized sweep never sorts.
+ *
+ *  Gate removal isolates the gate instead of renumbering: its inputs move
+ *  to a shared floating net and its outputs to fresh undriven nets. The
+ *  netlist must only be edited through this object while it is in use.
+ */
+class IncrementalLevels
+{
+  Netlist& nl;
+  std::vector<uint32_t> levels;
+  /**
+   *  Position of every gate in its level bucket
+   *
+   */
+  std::vector<uint32_t> slots;
+  std::vector<std::vector<uint32_t>> buckets;
+  /**
+   *  Gates reading every net (once per input terminal)
+   *
+   */
+  std::vector<std::vector<uint32_t>> readers;
+  NetId floating = UINT32_MAX;
+  /**
+   *  Scratch for searches and repairs
+   *
+   */
+  std::vector<uint32_t> marks;
+  uint32_t epoch = 0;
+  std::vector<uint32_t> stack;
+
+  void sync();
+  uint32_t nextEpoch();
+  uint32_t fanin(uint32_t g) const;
+  void place(uint32_t g, uint32_t level);
+  /**
+   *  Some gate of targets is reachable from a gate of starts
+   *
+   */
+  bool reaches(std::vector<uint32_t> const& starts, std::vector<uint32_t> const& targets);
+  /**
+   *  Recompute levels downstream of the given gates
+   *
+   */
+  void repair(std::vector<uint32_t> const& changed);
+  void unread(NetId net, uint32_t g);
+  NetId floatingNet();
+
+public:
+  /**
+   *  Levelize netlist once (throws on a combinational loop)
+   *
+   */
+  explicit IncrementalLevels(Netlist& netlist);
+  inline Netlist const& netlist() const { return nl; }
+  inline uint32_t level(uint32_t g) const { return levels.at(g); }
+  inline size_t depth() const { return buckets.size(); }
+  /**
+   *  Gates of one level (any order)
+   *
+   */
+  inline std::vector<uint32_t> const& gatesAt(size_t level) const { return buckets.at(level); }
+  inline std::vector<uint32_t> const& readersOf(NetId net) const { return readers.at(net); }
+  /**
+   *  Add gate (as Netlist::addGate)
+   *
+   *  uint32_t gate index
+   */
+  uint32_t addGate(uint32_t type, std::vector<NetId> const& pins);
+  /**
+   *  Rebind terminal n of gate g to net
+   *
+   *  Throws and leaves everything unchanged if this closes a loop.
+   */
+  void connect(uint32_t g, size_t n, NetId net);
+  /**
+   *  Unbind terminal n of gate g (inputs float, outputs drive a new net)
+   *
+   */
+  void disconnect(uint32_t g, size_t n);
+  /**
+   *  Isolate gate g from the circuit
+   *
+   */
+  void removeGate(uint32_t g);
+  /**
+   *  Evaluate all gates level by level
+   *
+   *  values value of every net (primary inputs set by caller)
+   */
+  void evaluate(Planes* values) const;
+};
@@ -0,0 +1,152 @@
+#include "LogicGateModule.hpp"
+#include <stdexcept>
+
+Design::Design(GateTypeLibrary const& library) : lib(library) {}
+
+Module& Design::editable(uint32_t mod)
+{
+  if (mod >= modules.size())
+    throw std::out_of_range("");
+  flat.clear();
+  gateCounts.clear();
+  return modules[mod];
+}
+
+uint32_t Design::addModule(std::string const& name, std::vector<bool> const& ports)
+{
+  if (byName.count(name))
+    throw std::runtime_error("Module '" + name + "' already exists");
+  modules.push_back({name, ports, uint32_t(ports.size()), {}});
+  return byName[name] = modules.size() - 1;
+}
+
+uint32_t Design::addModule(std::string const& name, Gate const& shape)
+{
+  std::vector<bool> ports;
+  for (size_t i = 0; i < shape.size(); i++)
+    ports.push_back(shape.terminal(i).isOutput);
+  return addModule(name, ports);
+}
+
+uint32_t Design::module(std::string const& name) const
+{
+  auto it = byName.find(name);
+  if (it == byName.end())
+    throw std::out_of_range(name);
+  return it->second;
+}
+
+Gate Design::shape(uint32_t mod) const
+{
+  std::vector<Terminal> terms;
+  for (bool isOutput : modules.at(mod).ports)
+    terms.push_back(Terminal(isOutput));
+  return Gate(std::move(terms));
+}
+
+uint32_t Design::addNet(uint32_t mod) { return editable(mod).nets++; }
+
+size_t Design::addGate(uint32_t mod, uint32_t type, std::vector<uint32_t> const& pins)
+{
+  if (type >= lib.size())
+    throw std::out_of_range("");
+  Module& m = editable(mod);
+  if (pins.size() != lib[type].size())
+    throw std::runtime_error("Pins do not match gate type");
+  for (auto net : pins)
+    if (net >= m.nets)
+      throw std::out_of_range("");
+  m.cells.push_back({false, type, pins});
+  return m.cells.size() - 1;
+}
+
+size_t Design::addInstance(uint32_t mod, uint32_t child, std::vector<uint32_t> const& pins)
+{
+  if (child >= mod)
+    throw std::runtime_error("Module can only instantiate modules defined before it");
+  Module& m = editable(mod);
+  if (pins.size() != modules[child].ports.size())
+    throw std::runtime_error("Pins do not match module ports");
+  for (auto net : pins)
+    if (net >= m.nets)
+      throw std::out_of_range("");
+  m.cells.push_back({true, child, pins});
+  return m.cells.size() - 1;
+}
+
+void Design::removeCell(uint32_t mod, size_t cell)
+{
+  Module& m = editable(mod);
+  if (cell >= m.cells.size())
+    throw std::out_of_range("");
+  m.cells.erase(m.cells.begin() + cell);
+}
+
+uint64_t Design::flatGates(uint32_t mod) const
+{
+  if (mod >= modules.size())
+    throw std::out_of_range("");
+  // Children are always defined before parents, so one forward pass fills the memo
+  for (size_t id = gateCounts.size(); id < modules.size(); id++)
+  {
+    uint64_t count = 0;
+    for (auto const& cell : modules[id].cells)
+      count += cell.isModule ? gateCounts[cell.ref] : 1;
+    gateCounts.push_back(count);
+  }
+  return gateCounts[mod];
+}
+
+size_t Design::bytes() const
+{
+  size_t res = modules.capacity() * sizeof(Module);
+  for (auto const& m : modules)
+  {
+    res += m.name.capacity() + m.ports.capacity() / 8 + m.cells.capacity() * sizeof(Cell);
+    for (auto const& cell : m.cells)
+      res += cell.pins.capacity() * sizeof(uint32_t);
+  }
+  return res;
+}
+
+void Design::expand(Netlist& out, uint32_t mod, std::vector<NetId> const& bind) const
+{
+  Module const& m = modules[mod];
+  std::vector<NetId> local(bind);
+  for (uint32_t i = m.ports.size(); i < m.nets; i++)
+    local.push_back(out.addNet());
+  std::vector<NetId> pins;
+  for (auto const& cell : m.cells)
+  {
+    pins.clear();
+    for (auto net : cell.pins)
+      pins.push_back(local[net]);
+    if (cell.isModule)
+      expand(out, cell.ref, pins);
+    else
+      out.addGate(cell.ref, pins);
+  }
+}
+
+std::shared_ptr<Netlist const> Design::flatten(uint32_t top) const
+{
+  if (top >= modules.size())
+    throw std::out_of_range("");
+  auto it = flat.find(top);
+  if (it != flat.end())
+    return it->second;
+  auto res = std::make_shared<Netlist>(lib);
+  Module const& m = modules[top];
+  std::vector<NetId> ports;
+  for (size_t i = 0; i < m.ports.size(); i++)
+  {
+    ports.push_back(res->addNet());
+    if (!m.ports[i])
+      res->addInput(ports.back());
+  }
+  for (size_t i = 0; i < m.ports.size(); i++)
+    if (m.ports[i])
+      res->addOutput(ports[i]);
+  expand(*res, top, ports);
+  return flat[top] = std::move(res);
+}
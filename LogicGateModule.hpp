@@ -0,0 +1,146 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+/**
+ *  Element of a module: library gate or instance of another module
+ *
+ */
+struct Cell
+{
+  /**
+   *  Determines whether ref is a module id or a gate type id
+   *
+   */
+  bool isModule;
+  uint32_t ref;
+  /**
+   *  Local net of every terminal/port of the cell
+   *
+   */
+  std::vector<uint32_t> pins;
+};
+/**
+ *  Named sub-netlist
+ *
+ *  Local nets 0..ports.size()-1 are the ports, in terminal order.
+ */
+struct Module
+{
+  std::string name;
+  /**
+   *  isOutput flag of every port
+   *
+   */
+  std::vector<bool> ports;
+  /**
+   *  Number of local nets (ports included)
+   *
+   */
+  uint32_t nets;
+  std::vector<Cell> cells;
+};
+/**
+ *  Hierarchical design
+ *
+ *  Stores every module once however often it is instantiated; a flat
+ *  Netlist is built on first use and cached until the next edit. Netlists
+ *  are shared, so one handed out before an edit stays valid as a snapshot
+ *  of the design at that time.
+ */
+class Design
+{
+  GateTypeLibrary const& lib;
+  std::vector<Module> modules;
+  std::map<std::string, uint32_t> byName;
+
+  mutable std::map<uint32_t, std::shared_ptr<Netlist const>> flat;
+  mutable std::vector<uint64_t> gateCounts;
+
+  Module& editable(uint32_t mod);
+  void expand(Netlist& out, uint32_t mod, std::vector<NetId> const& bind) const;
+
+public:
+  explicit Design(GateTypeLibrary const& library);
+  inline GateTypeLibrary const& library() const { return lib; }
+  inline size_t size() const { return modules.size(); }
+  inline Module const& operator[](uint32_t mod) const { return modules.at(mod); }
+
+  /**
+   *  Define empty module
+   *
+   *  name unique module name
+   *  ports isOutput flag of every port
+   *  uint32_t module id
+   */
+  uint32_t addModule(std::string const& name, std::vector<bool> const& ports);
+  /**
+   *  Define empty module with ports shaped like the gate's terminals
+   *
+   *  name unique module name
+   *  shape gate whose terminals become ports
+   *  uint32_t module id
+   */
+  uint32_t addModule(std::string const& name, Gate const& shape);
+  /**
+   *  Find module by name
+   *
+   */
+  uint32_t module(std::string const& name) const;
+  /**
+   *  Gate with a terminal for every port of module
+   *
+   */
+  Gate shape(uint32_t mod) const;
+
+  /**
+   *  Add internal net to module
+   *
+   *  uint32_t local net
+   */
+  uint32_t addNet(uint32_t mod);
+  /**
+   *  Add library gate to module
+   *
+   *  mod module id
+   *  type gate type id
+   *  pins local net of every terminal
+   *  size_t cell index
+   */
+  size_t addGate(uint32_t mod, uint32_t type, std::vector<uint32_t> const& pins);
+  /**
+   *  Instantiate previously defined module inside module
+   *
+   *  mod module id
+   *  child module to instantiate (defined before mod)
+   *  pins local net of every port of child
+   *  size_t cell index
+   */
+  size_t addInstance(uint32_t mod, uint32_t child, std::vector<uint32_t> const& pins);
+  /**
+   *  Remove cell from module
+   *
+   */
+  void removeCell(uint32_t mod, size_t cell);
+
+  /**
+   *  Number of gates after flattening (computed per module, not per instance)
+   *
+   */
+  uint64_t flatGates(uint32_t mod) const;
+  /**
+   *  Heap bytes held by module definitions
+   *
+   */
+  size_t bytes() const;
+  /**
+   *  Flat netlist of module (built on first use)
+   *
+   *  Ports become primary inputs and outputs in port order. Later edits
+   *  build a new netlist on the next call and leave this one unchanged;
+   *  holders keep it alive as long as they need it.
+   */
+  std::shared_ptr<Netlist const> flatten(uint32_t top) const;
+};
@@ -0,0 +1,375 @@
+#include "LogicGateMultiProcess.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <map>
+#include <new>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+
+static size_t align64(size_t n) { return (n + 63) & ~size_t(63); }
+
+/**
+ *  Futex event count in the shared segment
+ *
+ */
+struct alignas(64) Doorbell
+{
+  std::atomic<uint32_t> seq{0};
+  std::atomic<uint32_t> sleepers{0};
+};
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be a plain 32-bit word");
+
+/**
+ *  Polls of a not-ready ring before sleeping
+ *
+ */
+constexpr unsigned SpinRounds = 64;
+/**
+ *  Longest sleep, bounding how late a dead peer is noticed
+ *
+ */
+constexpr long SleepNanos = 100 * 1000 * 1000;
+
+static void ring(Doorbell& bell)
+{
+  bell.seq.fetch_add(1);
+  if (bell.sleepers.load())
+    syscall(SYS_futex, &bell.seq, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ *  Sleep until the bell rings or the timeout passes, unless ready
+ *
+ */
+template <typename F>
+static void sleepOn(Doorbell& bell, F ready)
+{
+  bell.sleepers.fetch_add(1);
+  uint32_t seq = bell.seq.load();
+  // Anyone making us ready after this point sees a sleeper and wakes us
+  if (!ready())
+  {
+    timespec timeout{0, SleepNanos};
+    syscall(SYS_futex, &bell.seq, FUTEX_WAIT, seq, &timeout, nullptr, 0);
+  }
+  bell.sleepers.fetch_sub(1);
+}
+
+MultiProcessSimulator::MultiProcessSimulator(Netlist const& netlist, size_t processes, size_t ringBlocks)
+    : nl(netlist), parts(processes)
+{
+  if (!parts || !ringBlocks)
+    throw std::runtime_error("Need at least one process and one block per ring");
+  if (nl.inputs().empty())
+    throw std::runtime_error("Netlist has no inputs");
+
+  // Contiguous slices of the topological order: boundary nets only flow forward
+  std::vector<uint32_t> const& order = nl.order();
+  std::vector<size_t> owner(nl.gates());
+  slices.resize(parts);
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    size_t part = i * parts / order.size();
+    slices[part].push_back(order[i]);
+    owner[order[i]] = part + 1;
+  }
+  auto source = [&](NetId net) { return nl.driver(net) == NoGate ? 0 : owner[nl.driver(net)]; };
+
+  std::map<std::pair<size_t, size_t>, std::vector<NetId>> cross;
+  std::vector<size_t> mark(nl.nets(), 0);
+  for (size_t q = 1; q <= parts; q++)
+  {
+    for (auto g : slices[q - 1])
+    {
+      GateType const& t = nl.type(g);
+      for (size_t k = 0; k < t.inputs(); k++)
+      {
+        NetId net  = nl.pin(g, t.inputTerminal(k));
+        size_t src = source(net);
+        if (src != q && mark[net] != q)
+        {
+          mark[net] = q;
+          cross[{src, q}].push_back(net);
+        }
+      }
+    }
+    // Every worker is clocked by the parent so all of them advance in lockstep
+    bool fed = false;
+    for (auto const& keyval : cross)
+      fed = fed || keyval.first.second == q;
+    if (!fed)
+      cross[{0, q}].push_back(nl.inputs()[0]);
+  }
+  std::fill(mark.begin(), mark.end(), 0);
+  for (auto net : nl.outputs())
+    if (source(net) && !mark[net])
+    {
+      mark[net] = 1;
+      cross[{source(net), 0}].push_back(net);
+    }
+
+  // One segment: stop flag, doorbells, then each ring followed by its slots
+  shmSize = 64 + (parts + 1) * sizeof(Doorbell);
+  for (auto& keyval : cross)
+    shmSize += align64(sizeof(SpscRing<Planes>)) + align64(keyval.second.size() * ringBlocks * sizeof(Planes));
+  static int segments = 0;
+  std::string name = "/logicgate-" + std::to_string(getpid()) + "-" + std::to_string(segments++);
+  int fd           = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), "shm_open");
+  if (ftruncate(fd, shmSize) < 0)
+  {
+    int err = errno;
+    close(fd);
+    shm_unlink(name.c_str());
+    throw std::system_error(err, std::generic_category(), "ftruncate");
+  }
+  shm = mmap(nullptr, shmSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int err = errno;
+  close(fd);
+  // The mapping stays valid for us and the forked workers; no name to leak
+  shm_unlink(name.c_str());
+  if (shm == MAP_FAILED)
+  {
+    shm = nullptr;
+    throw std::system_error(err, std::generic_category(), "mmap");
+  }
+  char* base = static_cast<char*>(shm);
+  stop       = new (base) std::atomic<int>(0);
+  bells      = reinterpret_cast<Doorbell*>(base + 64);
+  for (size_t part = 0; part <= parts; part++)
+    new (bells + part) Doorbell;
+  size_t off = 64 + (parts + 1) * sizeof(Doorbell);
+  for (auto& keyval : cross)
+  {
+    size_t capacity = keyval.second.size() * ringBlocks;
+    auto slots      = reinterpret_cast<Planes*>(base + off + align64(sizeof(SpscRing<Planes>)));
+    auto ring       = new (base + off) SpscRing<Planes>(slots, capacity);
+    links.push_back({keyval.first.first, keyval.first.second, std::move(keyval.second), ring});
+    off += align64(sizeof(SpscRing<Planes>)) + align64(capacity * sizeof(Planes));
+  }
+
+  for (size_t part = 0; part < parts; part++)
+  {
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      err = errno;
+      shutdown();
+      throw std::system_error(err, std::generic_category(), "fork");
+    }
+    if (!pid)
+    {
+      try
+      {
+        work(part);
+      }
+      catch (...)
+      {
+        _exit(1);
+      }
+      _exit(0);
+    }
+    workers.push_back(pid);
+  }
+}
+
+MultiProcessSimulator::~MultiProcessSimulator() { shutdown(); }
+
+void MultiProcessSimulator::shutdown()
+{
+  if (stop)
+  {
+    stop->store(1, std::memory_order_release);
+    for (size_t part = 0; part <= parts; part++)
+      ring(bells[part]);
+  }
+  for (auto pid : workers)
+    waitpid(pid, nullptr, 0);
+  workers.clear();
+  if (shm)
+    munmap(shm, shmSize);
+  shm   = nullptr;
+  stop  = nullptr;
+  bells = nullptr;
+}
+
+size_t MultiProcessSimulator::boundaryNets() const
+{
+  size_t res = 0;
+  for (auto const& link : links)
+    res += link.nets.size();
+  return res;
+}
+
+void MultiProcessSimulator::work(size_t part) const
+{
+  std::vector<Link const*> in, out;
+  for (auto const& link : links)
+  {
+    if (link.to == part + 1)
+      in.push_back(&link);
+    if (link.from == part + 1)
+      out.push_back(&link);
+  }
+  std::vector<Planes> values(nl.nets(), Planes::broadcast(2)), buf;
+  pid_t parent = getppid();
+  auto stopped = [&] { return stop->load(std::memory_order_acquire) || getppid() != parent; };
+  // Wait for a ring condition, giving up when the parent shuts down or dies
+  auto wait = [&](auto ready) {
+    for (unsigned spin = 0; !ready(); spin++)
+    {
+      if (stopped())
+        return false;
+      if (spin < SpinRounds)
+        sched_yield();
+      else
+        sleepOn(bells[part + 1], [&] { return ready() || stop->load(std::memory_order_acquire); });
+    }
+    return true;
+  };
+  for (;;)
+  {
+    for (auto link : in)
+    {
+      size_t n = link->nets.size();
+      if (!wait([&] { return link->ring->available() >= n; }))
+        return;
+      buf.resize(n);
+      link->ring->read(buf.data(), n);
+      ring(bells[link->from]);
+      for (size_t i = 0; i < n; i++)
+        values[link->nets[i]] = buf[i];
+    }
+    for (auto g : slices[part])
+      nl.evaluateGate(g, values.data());
+    for (auto link : out)
+    {
+      size_t n = link->nets.size();
+      buf.resize(n);
+      for (size_t i = 0; i < n; i++)
+        buf[i] = values[link->nets[i]];
+      if (!wait([&] { return link->ring->space() >= n; }))
+        return;
+      link->ring->write(buf.data(), n);
+      ring(bells[link->to]);
+    }
+  }
+}
+
+std::vector<Planes> MultiProcessSimulator::run(std::vector<Planes> const& inputs)
+{
+  if (!usable())
+    throw std::runtime_error("Simulator is unusable after a worker died");
+  size_t ni = nl.inputs().size(), no = nl.outputs().size();
+  if (inputs.size() % ni)
+    throw std::runtime_error("Wrong number of inputs");
+  size_t blocks = inputs.size() / ni;
+  std::vector<Planes> res(blocks * no);
+
+  std::vector<Link const*> feed, collect;
+  for (auto const& link : links)
+  {
+    if (link.from == 0)
+      feed.push_back(&link);
+    if (link.to == 0)
+      collect.push_back(&link);
+  }
+  // Output positions of every collected net
+  std::multimap<NetId, size_t> positions;
+  for (size_t j = 0; j < no; j++)
+    positions.insert({nl.outputs()[j], j});
+  std::vector<Planes> values(nl.nets(), Planes::broadcast(2)), buf;
+  std::vector<size_t> received(collect.size(), 0);
+  size_t sent = 0, idle = 0;
+  auto pending = [&] {
+    for (auto count : received)
+      if (count < blocks)
+        return true;
+    return false;
+  };
+  auto room = [&] {
+    bool res = sent < blocks;
+    for (auto link : feed)
+      res = res && link->ring->space() >= link->nets.size();
+    return res;
+  };
+  auto arrived = [&] {
+    for (size_t r = 0; r < collect.size(); r++)
+      if (received[r] < blocks && collect[r]->ring->available() >= collect[r]->nets.size())
+        return true;
+    return false;
+  };
+  while (sent < blocks || pending())
+  {
+    bool progress = false;
+    if (room())
+    {
+      for (size_t i = 0; i < ni; i++)
+        values[nl.inputs()[i]] = inputs[sent * ni + i];
+      // Outputs tied to inputs or left undriven never leave the parent
+      for (size_t j = 0; j < no; j++)
+        if (nl.driver(nl.outputs()[j]) == NoGate)
+          res[sent * no + j] = values[nl.outputs()[j]];
+      for (auto link : feed)
+      {
+        buf.resize(link->nets.size());
+        for (size_t i = 0; i < buf.size(); i++)
+          buf[i] = values[link->nets[i]];
+        link->ring->write(buf.data(), buf.size());
+        ring(bells[link->to]);
+      }
+      sent++;
+      progress = true;
+    }
+    for (size_t r = 0; r < collect.size(); r++)
+    {
+      Link const* link = collect[r];
+      size_t n         = link->nets.size();
+      while (received[r] < blocks && link->ring->available() >= n)
+      {
+        buf.resize(n);
+        link->ring->read(buf.data(), n);
+        ring(bells[link->from]);
+        for (size_t i = 0; i < n; i++)
+        {
+          auto range = positions.equal_range(link->nets[i]);
+          for (auto it = range.first; it != range.second; ++it)
+            res[received[r] * no + it->second] = buf[i];
+        }
+        received[r]++;
+        progress = true;
+      }
+    }
+    if (progress)
+    {
+      idle = 0;
+      continue;
+    }
+    if (++idle < SpinRounds)
+    {
+      sched_yield();
+      continue;
+    }
+    sleepOn(bells[0], [&] { return room() || arrived(); });
+    for (size_t i = 0; i < workers.size(); i++)
+      if (waitpid(workers[i], nullptr, WNOHANG) == workers[i])
+      {
+        // The rings are half-written now: stop the rest for good
+        workers.erase(workers.begin() + i);
+        shutdown();
+        throw std::runtime_error("Worker process exited");
+      }
+  }
+  return res;
+}
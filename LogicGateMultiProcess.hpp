@@ -0,0 +1,90 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include "LogicGateRing.hpp"
+#include <sys/types.h>
+#include <vector>
+/**
+ *  Netlist simulation split across local worker processes
+ *
+ *  Gates are cut into contiguous slices of the topological order, one per
+ *  process, so every boundary net flows from a lower partition to a higher
+ *  one (or to the parent). Each ordered pair of partitions that shares
+ *  nets gets an SPSC ring of Planes in one POSIX shared memory segment.
+ *  Processes synchronize per cycle: a worker waits until all of its
+ *  incoming rings hold the block's boundary values, evaluates its slice,
+ *  then publishes its outgoing values. The parent feeds primary inputs and
+ *  collects primary outputs, so blocks are pipelined through the workers.
+ *
+ *  Workers are forked in the constructor and share the netlist copy-on-write.
+ *  A process that finds its rings not ready spins briefly, then sleeps on
+ *  a futex doorbell that its peers ring after moving data, so idle workers
+ *  cost nothing between runs. If a worker dies, run() reaps it, stops the
+ *  others and the simulator refuses further runs.
+ */
+struct Doorbell;
+class MultiProcessSimulator
+{
+  struct Link
+  {
+    /**
+     *  Producer and consumer partition (0 - parent)
+     *
+     */
+    size_t from, to;
+    std::vector<NetId> nets;
+    SpscRing<Planes>* ring;
+  };
+
+  Netlist const& nl;
+  size_t parts;
+  void* shm              = nullptr;
+  size_t shmSize         = 0;
+  std::atomic<int>* stop = nullptr;
+  /**
+   *  One per process (0 - parent)
+   *
+   */
+  Doorbell* bells        = nullptr;
+  std::vector<pid_t> workers;
+  std::vector<std::vector<uint32_t>> slices;
+  std::vector<Link> links;
+
+  void work(size_t part) const;
+  void shutdown();
+
+public:
+  /**
+   *  Partition the netlist and start the workers
+   *
+   *  netlist netlist (must outlive the simulator)
+   *  processes number of worker processes
+   *  ringBlocks cycles of boundary values each ring can buffer
+   */
+  MultiProcessSimulator(Netlist const& netlist, size_t processes, size_t ringBlocks = 64);
+  MultiProcessSimulator(MultiProcessSimulator const&) = delete;
+  MultiProcessSimulator& operator=(MultiProcessSimulator const&) = delete;
+  ~MultiProcessSimulator();
+  inline size_t processes() const { return parts; }
+  /**
+   *  Workers are running (false once one has died)
+   *
+   */
+  inline bool usable() const { return shm != nullptr; }
+  /**
+   *  Gates evaluated by worker part
+   *
+   */
+  inline std::vector<uint32_t> const& slice(size_t part) const { return slices.at(part); }
+  /**
+   *  Values exchanged through the rings per cycle
+   *
+   */
+  size_t boundaryNets() const;
+  /**
+   *  Simulate blocks of 64 patterns
+   *
+   *  inputs blocks * inputs() Planes, block-major
+   *  std::vector<Planes> blocks * outputs() Planes, block-major
+   */
+  std::vector<Planes> run(std::vector<Planes> const& inputs);
+};
@@ -0,0 +1,223 @@
+#include "LogicGateNetlist.hpp"
+#include "LogicGateStats.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+Netlist::Netlist(GateTypeLibrary const& library) : lib(&library), pinOffsets{0} {}
+
+NetId Netlist::addNet()
+{
+  drivers.push_back(NoGate);
+  primary.push_back(false);
+  dirty = true;
+  return drivers.size() - 1;
+}
+
+NetId Netlist::addNet(std::string const& name)
+{
+  if (names.count(name))
+    throw std::runtime_error("Net '" + name + "' already exists");
+  return names[name] = addNet();
+}
+
+NetId Netlist::net(std::string const& name) const
+{
+  auto it = names.find(name);
+  if (it == names.end())
+    throw std::out_of_range(name);
+  return it->second;
+}
+
+uint32_t Netlist::addGate(uint32_t type, std::vector<NetId> const& pins)
+{
+  if (type >= lib->size())
+    throw std::out_of_range("");
+  GateType const& t = (*lib)[type];
+  if (pins.size() != t.size())
+    throw std::runtime_error("Pins do not match gate type");
+  for (auto net : pins)
+    if (net >= nets())
+      throw std::out_of_range("");
+  uint32_t g = gateTypes.size();
+  for (size_t k = 0; k < t.outputs(); k++)
+  {
+    NetId net = pins[t.outputTerminal(k)];
+    if (drivers[net] != NoGate || primary[net])
+      throw std::runtime_error("Net has two drivers");
+  }
+  for (size_t k = 0; k < t.outputs(); k++)
+    drivers[pins[t.outputTerminal(k)]] = g;
+  gateTypes.push_back(type);
+  pinNets.insert(pinNets.end(), pins.begin(), pins.end());
+  pinOffsets.push_back(pinNets.size());
+  dirty = true;
+  return g;
+}
+
+void Netlist::reconnect(uint32_t g, size_t n, NetId net)
+{
+  if (g >= gates() || n >= type(g).size() || net >= nets())
+    throw std::out_of_range("");
+  NetId& slot = pinNets[pinOffsets[g] + n];
+  if (slot == net)
+    return;
+  if (type(g).isOutput(n))
+  {
+    if (drivers[net] != NoGate || primary[net])
+      throw std::runtime_error("Net has two drivers");
+    drivers[slot] = NoGate;
+    drivers[net]  = g;
+  }
+  slot  = net;
+  dirty = true;
+}
+
+void Netlist::addInput(NetId net)
+{
+  if (net >= nets())
+    throw std::out_of_range("");
+  if (drivers[net] != NoGate || primary[net])
+    throw std::runtime_error("Net has two drivers");
+  primary[net] = true;
+  _inputs.push_back(net);
+}
+
+void Netlist::addOutput(NetId net)
+{
+  if (net >= nets())
+    throw std::out_of_range("");
+  _outputs.push_back(net);
+}
+
+void Netlist::prepare() const
+{
+  if (!dirty)
+    return;
+  size_t n = gates();
+  // Fanout lists (CSR)
+  fanOffsets.assign(nets() + 1, 0);
+  for (uint32_t g = 0; g < n; g++)
+  {
+    GateType const& t = type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+      fanOffsets[pin(g, t.inputTerminal(k)) + 1]++;
+  }
+  for (size_t i = 0; i < nets(); i++)
+    fanOffsets[i + 1] += fanOffsets[i];
+  fanGates.assign(fanOffsets.back(), 0);
+  std::vector<uint32_t> fill(fanOffsets.begin(), fanOffsets.end() - 1);
+  for (uint32_t g = 0; g < n; g++)
+  {
+    GateType const& t = type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+      fanGates[fill[pin(g, t.inputTerminal(k))]++] = g;
+  }
+  // Levels (Kahn's algorithm)
+  std::vector<uint32_t> pending(n, 0);
+  _levels.assign(n, 0);
+  _order.clear();
+  _order.reserve(n);
+  for (uint32_t g = 0; g < n; g++)
+  {
+    GateType const& t = type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+      if (drivers[pin(g, t.inputTerminal(k))] != NoGate)
+        pending[g]++;
+    if (!pending[g])
+      _order.push_back(g);
+  }
+  for (size_t i = 0; i < _order.size(); i++)
+  {
+    uint32_t g        = _order[i];
+    GateType const& t = type(g);
+    for (size_t k = 0; k < t.outputs(); k++)
+    {
+      NetId net = pin(g, t.outputTerminal(k));
+      for (size_t f = fanOffsets[net]; f < fanOffsets[net + 1]; f++)
+      {
+        uint32_t succ = fanGates[f];
+        _levels[succ] = std::max(_levels[succ], _levels[g] + 1);
+        if (--pending[succ] == 0)
+          _order.push_back(succ);
+      }
+    }
+  }
+  if (_order.size() != n)
+    throw std::runtime_error("Combinational loop");
+  // Keep index order when it is already topological: it is the memory order
+  bool indexed = true;
+  for (uint32_t g = 0; g < n && indexed; g++)
+  {
+    GateType const& t = type(g);
+    for (size_t k = 0; k < t.inputs() && indexed; k++)
+    {
+      uint32_t fanin = drivers[pin(g, t.inputTerminal(k))];
+      indexed        = fanin == NoGate || fanin < g;
+    }
+  }
+  _depth = 0;
+  for (auto lvl : _levels)
+    _depth = std::max<size_t>(_depth, lvl + 1);
+  if (indexed)
+    for (uint32_t g = 0; g < n; g++)
+      _order[g] = g;
+  else
+    std::stable_sort(_order.begin(), _order.end(), [this](uint32_t a, uint32_t b) { return _levels[a] < _levels[b]; });
+  dirty = false;
+}
+
+IdRange Netlist::fanout(NetId net) const
+{
+  prepare();
+  return {fanGates.data() + fanOffsets[net], fanGates.data() + fanOffsets[net + 1]};
+}
+
+std::vector<uint32_t> const& Netlist::order() const
+{
+  prepare();
+  return _order;
+}
+
+uint32_t Netlist::level(uint32_t g) const
+{
+  prepare();
+  return _levels[g];
+}
+
+size_t Netlist::depth() const
+{
+  prepare();
+  return _depth;
+}
+
+void Netlist::evaluateGate(uint32_t g, Planes* values) const
+{
+  GateType const& t = type(g);
+  Planes in[GateType::MaxTerminals];
+  for (size_t k = 0; k < t.inputs(); k++)
+    in[k] = values[pin(g, t.inputTerminal(k))];
+  for (size_t k = 0; k < t.outputs(); k++)
+    values[pin(g, t.outputTerminal(k))] = t.evaluate(in, k);
+}
+
+void Netlist::evaluate(Planes* values) const
+{
+  LG_STAT_PHASE(Evaluate);
+  for (auto g : order())
+    evaluateGate(g, values);
+  LG_STAT_ADD(evaluations, gates());
+}
+
+std::vector<unsigned short> Netlist::evaluate(std::vector<unsigned short> const& inputs) const
+{
+  if (inputs.size() != _inputs.size())
+    throw std::runtime_error("Wrong number of inputs");
+  std::vector<Planes> values(nets(), Planes::broadcast(2));
+  for (size_t i = 0; i < inputs.size(); i++)
+    values[_inputs[i]] = Planes::broadcast(inputs[i]);
+  evaluate(values.data());
+  std::vector<unsigned short> res;
+  for (auto net : _outputs)
+    res.push_back(values[net].lane(0));
+  return res;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include "LogicGateType.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+/**
+ *  Net index
+ *
+ */
+typedef uint32_t NetId;
+/**
+ *  Marks an undriven net
+ *
+ */
+constexpr uint32_t NoGate = UINT32_MAX;
+/**
+ *  Contiguous range of ids
+ *
+ */
+struct IdRange
+{
+  uint32_t const* first;
+  uint32_t const* last;
+  inline uint32_t const* begin() const { return first; }
+  inline uint32_t const* end() const { return last; }
+  inline size_t size() const { return last - first; }
+};
+/**
+ *  Flat netlist of typed gates connected by nets
+ *
+ *  Every terminal of a gate is bound to a net (pins in terminal order); an
+ *  output terminal drives its net, every net has at most one driver. Net
+ *  values are kept by the caller as Planes (64 patterns per word).
+ */
+class Netlist
+{
+  GateTypeLibrary const* lib;
+  std::vector<uint32_t> gateTypes;
+  std::vector<uint32_t> pinOffsets;
+  std::vector<NetId> pinNets;
+  std::vector<uint32_t> drivers;
+  std::vector<bool> primary;
+  std::vector<NetId> _inputs;
+  std::vector<NetId> _outputs;
+  std::map<std::string, NetId> names;
+
+  mutable bool dirty = true;
+  mutable std::vector<uint32_t> _order;
+  mutable std::vector<uint32_t> _levels;
+  mutable size_t _depth = 0;
+  mutable std::vector<uint32_t> fanOffsets;
+  mutable std::vector<uint32_t> fanGates;
+
+  void prepare() const;
+
+public:
+  explicit Netlist(GateTypeLibrary const& library);
+  inline GateTypeLibrary const& library() const { return *lib; }
+
+  /**
+   *  Add anonymous net
+   *
+   *  NetId
+   */
+  NetId addNet();
+  /**
+   *  Add named net
+   *
+   *  name unique net name
+   *  NetId
+   */
+  NetId addNet(std::string const& name);
+  /**
+   *  Find net by name
+   *
+   *  name net name
+   *  NetId
+   */
+  NetId net(std::string const& name) const;
+  /**
+   *  Names of named nets
+   *
+   */
+  inline std::map<std::string, NetId> const& netNames() const { return names; }
+  /**
+   *  Add gate
+   *
+   *  type type id in library
+   *  pins net of every terminal (terminal order)
+   *  uint32_t gate index
+   */
+  uint32_t addGate(uint32_t type, std::vector<NetId> const& pins);
+  /**
+   *  Rebind terminal n of gate g to net
+   *
+   *  A combinational loop is reported by the next levelization.
+   */
+  void reconnect(uint32_t g, size_t n, NetId net);
+  /**
+   *  Mark net as primary input
+   *
+   */
+  void addInput(NetId net);
+  /**
+   *  Mark net as primary output
+   *
+   */
+  void addOutput(NetId net);
+
+  inline size_t gates() const { return gateTypes.size(); }
+  inline size_t nets() const { return drivers.size(); }
+  inline uint32_t typeId(uint32_t g) const { return gateTypes[g]; }
+  inline GateType const& type(uint32_t g) const { return (*lib)[gateTypes[g]]; }
+  /**
+   *  Net bound to terminal n of gate g
+   *
+   */
+  inline NetId pin(uint32_t g, size_t n) const { return pinNets[pinOffsets[g] + n]; }
+  /**
+   *  Gate driving net (NoGate for primary inputs and undriven nets)
+   *
+   */
+  inline uint32_t driver(NetId net) const { return drivers[net]; }
+  inline std::vector<NetId> const& inputs() const { return _inputs; }
+  inline std::vector<NetId> const& outputs() const { return _outputs; }
+
+  /**
+   *  Gates reading net
+   *
+   */
+  IdRange fanout(NetId net) const;
+  /**
+   *  Gates in topological order
+   *
+   *  Index order if it already is topological, otherwise sorted by level.
+   */
+  std::vector<uint32_t> const& order() const;
+  /**
+   *  Level of gate (0 - fed by primary inputs only)
+   *
+   */
+  uint32_t level(uint32_t g) const;
+  /**
+   *  Number of levels
+   *
+   */
+  size_t depth() const;
+
+  /**
+   *  Evaluate one gate, writing its output nets
+   *
+   *  g gate index
+   *  values value of every net
+   */
+  void evaluateGate(uint32_t g, Planes* values) const;
+  /**
+   *  Evaluate all gates in topological order
+   *
+   *  values value of every net (primary inputs set by caller)
+   */
+  void evaluate(Planes* values) const;
+  /**
+   *  Evaluate all gates on single patterns
+   *
+   *  inputs state of every primary input (0, 1 or 2)
+   *  std::vector<unsigned short> state of every primary output
+   */
+  std::vector<unsigned short> evaluate(std::vector<unsigned short> const& inputs) const;
+};
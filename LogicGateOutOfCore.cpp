@@ -0,0 +1,416 @@
+#include "LogicGateOutOfCore.hpp"
+#include "LogicGateStats.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+static const char StreamMagic[] = "LGOOC1\n";
+constexpr uint32_t NoFrame      = UINT32_MAX;
+/**
+ *  Header after the magic: nets, computed nets (inputs and gate outputs,
+ *  numbered first), inputs, outputs, blocks, blockBytes and the offset of
+ *  the block index, which follows the last block
+ *
+ */
+constexpr size_t HeaderWords = 7;
+constexpr size_t PageTarget  = 64 << 10;
+/**
+ *  Value pages shrink until this many fit in the budget
+ *
+ */
+constexpr size_t MinFrames = 1024;
+
+static void readAt(int fd, void* data, size_t size, uint64_t offset)
+{
+  char* pos = static_cast<char*>(data);
+  while (size)
+  {
+    ssize_t n = ::pread(fd, pos, size, offset);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      throw std::system_error(errno, std::generic_category(), "pread");
+    if (n == 0)
+      throw std::runtime_error("Truncated netlist stream");
+    pos += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+static void writeAt(int fd, void const* data, size_t size, uint64_t offset)
+{
+  char const* pos = static_cast<char const*>(data);
+  while (size)
+  {
+    ssize_t n = ::pwrite(fd, pos, size, offset);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      throw std::system_error(errno, std::generic_category(), "pwrite");
+    }
+    pos += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+template <typename T>
+static void put(std::string& out, T value)
+{
+  out.append(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+double StreamStats::bytesPerVector() const
+{
+  return vectors ? double(netlistBytes + spillReads) / vectors : 0;
+}
+
+std::ostream& StreamStats::print(std::ostream& stream) const
+{
+  return stream << "Vectors:          " << vectors << "\n"
+                << "Passes:           " << passes << "\n"
+                << "Netlist read:     " << netlistBytes << " bytes\n"
+                << "Spill read:       " << spillReads << " bytes\n"
+                << "Spill written:    " << spillWrites << " bytes\n"
+                << "Read per vector:  " << bytesPerVector() << " bytes";
+}
+
+void OutOfCoreSimulator::compile(Netlist const& nl, std::string const& name, size_t blockBytes)
+{
+  std::vector<uint32_t> const& order = nl.order();
+  std::vector<NetId> ids(nl.nets(), NoFrame);
+  uint32_t next = 0;
+  auto number   = [&](NetId net) {
+    if (ids[net] == NoFrame)
+      ids[net] = next++;
+  };
+  for (auto net : nl.inputs())
+    number(net);
+  for (auto g : order)
+  {
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.outputs(); k++)
+      number(nl.pin(g, t.outputTerminal(k)));
+  }
+  uint32_t computed = next;
+  for (NetId net = 0; net < nl.nets(); net++)
+    number(net);
+
+  std::ofstream file(name, std::ios::binary);
+  uint64_t header[HeaderWords] = {nl.nets(), computed, nl.inputs().size(), nl.outputs().size(), 0, blockBytes, 0};
+  std::string data;
+  for (auto net : nl.inputs())
+    put<uint32_t>(data, ids[net]);
+  for (auto net : nl.outputs())
+    put<uint32_t>(data, ids[net]);
+  file.write(StreamMagic, 8);
+  file.write(reinterpret_cast<char const*>(header), sizeof(header));
+  file.write(data.data(), data.size());
+
+  std::vector<uint64_t> offsets{8 + sizeof(header) + data.size()};
+  uint32_t count = 0;
+  data.assign(4, 0);
+  auto flush = [&]() {
+    std::memcpy(&data[0], &count, 4);
+    file.write(data.data(), data.size());
+    offsets.push_back(offsets.back() + data.size());
+    count = 0;
+    data.assign(4, 0);
+  };
+  for (auto g : order)
+  {
+    GateType const& t = nl.type(g);
+    size_t record     = 4 * (1 + t.size());
+    if (4 + record > blockBytes)
+      throw std::runtime_error("Block too small for gate " + t.name());
+    if (data.size() + record > blockBytes)
+      flush();
+    put<uint32_t>(data, nl.typeId(g));
+    for (size_t n = 0; n < t.size(); n++)
+      put<uint32_t>(data, ids[nl.pin(g, n)]);
+    count++;
+  }
+  if (count)
+    flush();
+  header[4] = offsets.size() - 1;
+  header[6] = offsets.back();
+  file.write(reinterpret_cast<char const*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+  file.seekp(8);
+  file.write(reinterpret_cast<char const*>(header), sizeof(header));
+  if (!file)
+    throw std::runtime_error("Can not write " + name);
+}
+
+OutOfCoreSimulator::OutOfCoreSimulator(GateTypeLibrary const& library, std::string const& name, size_t memory,
+                                       size_t lanes, std::string spillName)
+    : lib(library), width(lanes)
+{
+  if (!width)
+    throw std::runtime_error("Width must be at least one block");
+  fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), name);
+  try
+  {
+    char magic[8];
+    uint64_t header[HeaderWords];
+    struct stat st;
+    if (fstat(fd, &st) || size_t(st.st_size) < 8 + sizeof(header))
+      throw std::runtime_error("Not a netlist stream: " + name);
+    readAt(fd, magic, 8, 0);
+    if (std::memcmp(magic, StreamMagic, 8))
+      throw std::runtime_error("Not a netlist stream: " + name);
+    readAt(fd, header, sizeof(header), 8);
+    nets       = header[0];
+    computed   = header[1];
+    blockBytes = header[5];
+    if (nets >= NoFrame || computed > nets || header[2] > nets || header[3] > nets || blockBytes < 8 ||
+        header[6] + (header[4] + 1) * sizeof(uint64_t) != uint64_t(st.st_size))
+      throw std::runtime_error("Corrupt netlist stream");
+    _inputs.resize(header[2]);
+    _outputs.resize(header[3]);
+    offsets.resize(header[4] + 1);
+    readAt(fd, _inputs.data(), _inputs.size() * sizeof(NetId), 8 + sizeof(header));
+    readAt(fd, _outputs.data(), _outputs.size() * sizeof(NetId), 8 + sizeof(header) + _inputs.size() * 4);
+    readAt(fd, offsets.data(), offsets.size() * sizeof(uint64_t), header[6]);
+    for (auto net : _inputs)
+      if (net >= nets)
+        throw std::runtime_error("Corrupt netlist stream");
+    for (auto net : _outputs)
+      if (net >= nets)
+        throw std::runtime_error("Corrupt netlist stream");
+    for (size_t b = 0; b < blocks(); b++)
+      if (offsets[b + 1] < offsets[b] + 4 || offsets[b + 1] - offsets[b] > blockBytes)
+        throw std::runtime_error("Corrupt netlist stream");
+    if (offsets.front() != 8 + sizeof(header) + 4 * (_inputs.size() + _outputs.size()) ||
+        offsets.back() != header[6])
+      throw std::runtime_error("Corrupt netlist stream");
+
+    size_t netBytes = width * sizeof(Planes);
+    if (memory < 2 * blockBytes + netBytes)
+      throw std::runtime_error("Memory budget below two blocks and one value page");
+    size_t budget = memory - 2 * blockBytes;
+    pageNets      = std::min<size_t>(PageTarget, budget / MinFrames) / netBytes;
+    pageNets      = std::max<size_t>(1, std::min<size_t>(nets, pageNets));
+    pageBytes     = pageNets * netBytes;
+    size_t pages  = (nets + pageNets - 1) / pageNets;
+    size_t count  = std::min(pages, budget / pageBytes);
+    frames.resize(count * pageNets * width);
+    framePage.assign(count, NoFrame);
+    frameUsed.assign(count, 0);
+    frameDirty.assign(count, 0);
+    pageFrame.assign(pages, NoFrame);
+    pageSpilled.assign(pages, 0);
+    rewritten = computed / pageNets;
+    scratch.resize(GateType::MaxTerminals * width);
+    buffers[0].resize(blockBytes);
+    buffers[1].resize(blockBytes);
+
+    if (spillName.empty())
+      spillName = name + ".spill";
+    spill = open(spillName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (spill < 0)
+      throw std::system_error(errno, std::generic_category(), spillName);
+    unlink(spillName.c_str());
+    reader = std::thread(&OutOfCoreSimulator::readAhead, this);
+  }
+  catch (...)
+  {
+    if (spill >= 0)
+      close(spill);
+    close(fd);
+    throw;
+  }
+}
+
+OutOfCoreSimulator::~OutOfCoreSimulator()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  reader.join();
+  close(fd);
+  close(spill);
+}
+
+void OutOfCoreSimulator::readAhead()
+{
+  std::unique_lock<std::mutex> guard(lock);
+  for (;;)
+  {
+    wake.wait(guard, [this] { return stopping || finished != requested; });
+    if (stopping)
+      return;
+    size_t b = requestedBlock;
+    guard.unlock();
+    std::exception_ptr error;
+    try
+    {
+      readAt(fd, buffers[b & 1].data(), offsets[b + 1] - offsets[b], offsets[b]);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    guard.lock();
+    readError = error;
+    finished++;
+    wake.notify_all();
+  }
+}
+
+void OutOfCoreSimulator::requestBlock(size_t b)
+{
+  std::unique_lock<std::mutex> guard(lock);
+  // A run that threw may have left its read ahead outstanding
+  wake.wait(guard, [this] { return finished == requested; });
+  requestedBlock = b;
+  requested++;
+  wake.notify_all();
+}
+
+void OutOfCoreSimulator::waitBlock()
+{
+  std::unique_lock<std::mutex> guard(lock);
+  wake.wait(guard, [this] { return finished == requested; });
+  if (readError)
+    std::rethrow_exception(std::exchange(readError, nullptr));
+}
+
+uint32_t OutOfCoreSimulator::fetch(uint32_t page)
+{
+  size_t count = framePage.size();
+  while (framePage[hand] != NoFrame && frameUsed[hand])
+  {
+    frameUsed[hand] = 0;
+    hand            = (hand + 1) % count;
+  }
+  uint32_t f   = hand;
+  hand         = (hand + 1) % count;
+  Planes* data = &frames[size_t(f) * pageNets * width];
+  uint32_t old = framePage[f];
+  if (old != NoFrame)
+  {
+    if (frameDirty[f])
+    {
+      writeAt(spill, data, pageBytes, uint64_t(old) * pageBytes);
+      pageSpilled[old] = pass;
+      _stats.spillWrites += pageBytes;
+    }
+    pageFrame[old] = NoFrame;
+  }
+  // Every net of a page below rewritten is written again before it is read
+  if (pageSpilled[page] == pass || (pageSpilled[page] && page >= rewritten))
+  {
+    readAt(spill, data, pageBytes, uint64_t(page) * pageBytes);
+    _stats.spillReads += pageBytes;
+  }
+  else
+    std::fill(data, data + pageNets * width, Planes::broadcast(2));
+  framePage[f]    = page;
+  pageFrame[page] = f;
+  frameDirty[f]   = 0;
+  return f;
+}
+
+Planes* OutOfCoreSimulator::values(NetId net, bool write)
+{
+  uint32_t page = net / pageNets;
+  uint32_t f    = pageFrame[page];
+  if (f == NoFrame)
+    f = fetch(page);
+  frameUsed[f] = 1;
+  frameDirty[f] |= write;
+  return &frames[(size_t(f) * pageNets + net % pageNets) * width];
+}
+
+void OutOfCoreSimulator::evaluateBlock(char const* data, size_t size, size_t lanes)
+{
+  char const* end = data + size;
+  uint32_t count, type;
+  uint32_t pins[GateType::MaxTerminals];
+  std::memcpy(&count, data, 4);
+  data += 4;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (end - data < 4)
+      throw std::runtime_error("Corrupt netlist stream");
+    std::memcpy(&type, data, 4);
+    if (type >= lib.size())
+      throw std::runtime_error("Corrupt netlist stream");
+    GateType const& t = lib[type];
+    if (size_t(end - data) < 4 * (1 + t.size()))
+      throw std::runtime_error("Corrupt netlist stream");
+    std::memcpy(pins, data + 4, 4 * t.size());
+    data += 4 * (1 + t.size());
+    for (size_t n = 0; n < t.size(); n++)
+      if (pins[n] >= nets)
+        throw std::runtime_error("Corrupt netlist stream");
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      Planes const* v = values(pins[t.inputTerminal(k)], false);
+      for (size_t j = 0; j < lanes; j++)
+        scratch[j * GateType::MaxTerminals + k] = v[j];
+    }
+    for (size_t k = 0; k < t.outputs(); k++)
+    {
+      Planes* v = values(pins[t.outputTerminal(k)], true);
+      for (size_t j = 0; j < lanes; j++)
+        v[j] = t.evaluate(&scratch[j * GateType::MaxTerminals], k);
+    }
+  }
+  LG_STAT_ADD(evaluations, uint64_t(count) * lanes);
+}
+
+std::vector<Planes> OutOfCoreSimulator::run(std::vector<Planes> const& inputs)
+{
+  size_t nin = _inputs.size(), nout = _outputs.size();
+  if (nin ? inputs.size() % nin : !inputs.empty())
+    throw std::runtime_error("Input values do not match inputs");
+  size_t count = nin ? inputs.size() / nin : 0;
+  std::vector<Planes> res(count * nout);
+  LG_STAT_PHASE(Evaluate);
+  for (size_t base = 0; base < count; base += width)
+  {
+    size_t lanes = std::min(width, count - base);
+    pass++;
+    for (size_t i = 0; i < nin; i++)
+    {
+      Planes* v = values(_inputs[i], true);
+      for (size_t j = 0; j < lanes; j++)
+        v[j] = inputs[(base + j) * nin + i];
+    }
+    // Read ahead: block b + 1 arrives while block b is evaluated
+    if (blocks())
+      requestBlock(0);
+    for (size_t b = 0; b < blocks(); b++)
+    {
+      waitBlock();
+      if (b + 1 < blocks())
+        requestBlock(b + 1);
+      size_t size = offsets[b + 1] - offsets[b];
+      evaluateBlock(buffers[b & 1].data(), size, lanes);
+      _stats.netlistBytes += size;
+    }
+    for (size_t o = 0; o < nout; o++)
+    {
+      Planes const* v = values(_outputs[o], false);
+      for (size_t j = 0; j < lanes; j++)
+        res[(base + j) * nout + o] = v[j];
+    }
+    _stats.passes++;
+  }
+  _stats.vectors += 64 * count;
+  return res;
+}
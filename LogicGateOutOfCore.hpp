@@ -0,0 +1,156 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+/**
+ *  Traffic of an out-of-core simulation
+ *
+ */
+struct StreamStats
+{
+  uint64_t vectors      = 0;
+  /**
+   *  Sweeps over the whole netlist file
+   *
+   */
+  uint64_t passes       = 0;
+  uint64_t netlistBytes = 0;
+  uint64_t spillReads   = 0;
+  uint64_t spillWrites  = 0;
+  /**
+   *  Bytes read (netlist and spill) per simulated vector
+   *
+   */
+  double bytesPerVector() const;
+  std::ostream& print(std::ostream& stream) const;
+};
+/**
+ *  Simulation of netlists that do not fit in memory
+ *
+ *  compile() writes a netlist in evaluation order to a file of blocks of
+ *  at most blockBytes, each holding whole gate records (type id, then one
+ *  net per terminal). Nets are renumbered on the way: primary inputs
+ *  first, then outputs in the order they are computed, so a block mostly
+ *  reads nets written shortly before it.
+ *
+ *  The simulator streams the blocks through two buffers: a reader thread
+ *  that lives as long as the simulator fills one while the other is
+ *  evaluated. Net values
+ *  live in pages that a CLOCK cache keeps in memory as far as the budget
+ *  allows; evicted pages that were written go to an unlinked spill file
+ *  and are read back when needed, unless the page only holds computed
+ *  values left over from an earlier pass. Pages shrink below 64 KiB when
+ *  the budget would otherwise hold few of them. Every pass simulates width
+ *  blocks of 64 vectors, so a larger width costs memory per net and saves
+ *  passes.
+ *
+ *  The netlist itself is never loaded: only the library, the block index
+ *  and one frame number per value page stay outside the budget.
+ */
+class OutOfCoreSimulator
+{
+  GateTypeLibrary const& lib;
+  int fd    = -1;
+  int spill = -1;
+  uint64_t nets;
+  uint64_t computed;
+  uint64_t blockBytes;
+  size_t width;
+  std::vector<NetId> _inputs, _outputs;
+  std::vector<uint64_t> offsets;
+
+  /**
+   *  Value page cache
+   *
+   */
+  size_t pageNets;
+  size_t pageBytes;
+  std::vector<Planes> frames;
+  std::vector<uint32_t> framePage;
+  std::vector<uint8_t> frameUsed;
+  std::vector<uint8_t> frameDirty;
+  std::vector<uint32_t> pageFrame;
+  /**
+   *  Pass that last spilled every page (0 - never)
+   *
+   */
+  std::vector<uint32_t> pageSpilled;
+  size_t rewritten;
+  uint32_t pass = 0;
+  size_t hand = 0;
+  std::vector<Planes> scratch;
+  std::vector<char> buffers[2];
+  StreamStats _stats;
+  /**
+   *  Read-ahead: block requestedBlock goes to buffers[requestedBlock & 1];
+   *  a request is done once finished catches up with requested
+   *
+   */
+  std::thread reader;
+  std::mutex lock;
+  std::condition_variable wake;
+  uint64_t requested    = 0;
+  uint64_t finished     = 0;
+  size_t requestedBlock = 0;
+  std::exception_ptr readError;
+  bool stopping = false;
+
+  /**
+   *  Values of net (width Planes, valid until the next call)
+   *
+   */
+  Planes* values(NetId net, bool write);
+  uint32_t fetch(uint32_t page);
+  void evaluateBlock(char const* data, size_t size, size_t lanes);
+  void readAhead();
+  void requestBlock(size_t b);
+  /**
+   *  Wait for the last requested block (rethrows its read error)
+   *
+   */
+  void waitBlock();
+
+public:
+  /**
+   *  Write netlist to an out-of-core netlist file
+   *
+   *  blockBytes largest block (at least one gate record)
+   */
+  static void compile(Netlist const& nl, std::string const& name, size_t blockBytes = 1 << 20);
+  /**
+   *  Open a compiled netlist
+   *
+   *  library library the netlist was compiled against
+   *  memory bytes for block buffers and value pages
+   *  width blocks of 64 vectors per pass
+   *  spillName spill file (unlinked once open, default name + ".spill")
+   */
+  OutOfCoreSimulator(GateTypeLibrary const& library, std::string const& name, size_t memory, size_t width = 4,
+                     std::string spillName = "");
+  ~OutOfCoreSimulator();
+  OutOfCoreSimulator(OutOfCoreSimulator const&) = delete;
+  OutOfCoreSimulator& operator=(OutOfCoreSimulator const&) = delete;
+
+  inline std::vector<NetId> const& inputs() const { return _inputs; }
+  inline std::vector<NetId> const& outputs() const { return _outputs; }
+  inline size_t blocks() const { return offsets.size() - 1; }
+  /**
+   *  Value pages that fit in memory
+   *
+   */
+  inline size_t residentPages() const { return framePage.size(); }
+  inline StreamStats const& stats() const { return _stats; }
+  /**
+   *  Simulate blocks of 64 vectors
+   *
+   *  inputs input values, block-major (blocks * inputs().size())
+   *  std::vector<Planes> output values, block-major
+   */
+  std::vector<Planes> run(std::vector<Planes> const& inputs);
+};
@@ -0,0 +1,223 @@
+#include "LogicGatePipeline.hpp"
+#include "LogicGateRing.hpp"
+#include "LogicGateStats.hpp"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ *  Up to batchBlocks * 64 vectors and their responses
+ *
+ */
+struct VectorBatch
+{
+  std::vector<Planes> inputs;
+  std::vector<Planes> outputs;
+  size_t count = 0;
+  /**
+   *  No batches follow
+   *
+   */
+  bool last = false;
+};
+
+bool parseVectorLine(std::string const& line, size_t width, unsigned short* states, uint64_t lineNo)
+{
+  size_t n = 0;
+  for (char c : line)
+  {
+    if (c == '#')
+      break;
+    if (c == ' ' || c == '\t' || c == '\r')
+      continue;
+    if (c != '0' && c != '1' && c != 'X' && c != 'x')
+      throw std::runtime_error("Line " + std::to_string(lineNo) + ": bad state '" + c + "'");
+    if (n == width)
+      throw std::runtime_error("Line " + std::to_string(lineNo) + ": too many states");
+    states[n++] = c == '0' ? 0 : c == '1' ? 1 : 2;
+  }
+  if (n && n != width)
+    throw std::runtime_error("Line " + std::to_string(lineNo) + ": too few states");
+  return n;
+}
+
+template <typename F>
+static bool waitFor(std::atomic<bool> const& stop, F ready)
+{
+  while (!ready())
+  {
+    if (stop.load(std::memory_order_relaxed))
+      return false;
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+StimulusPipeline::StimulusPipeline(Netlist const& netlist) : nl(netlist) {}
+
+PipelineResult StimulusPipeline::run(std::istream& in, std::ostream* out, std::istream* expected) const
+{
+  size_t nin = nl.inputs().size(), nout = nl.outputs().size();
+  size_t perBatch = 64 * batchBlocks;
+  nl.order();
+
+  std::vector<VectorBatch> pool(buffers);
+  std::vector<VectorBatch*> storage(3 * buffers);
+  // spare: writer -> reader, full: reader -> simulator, done: simulator -> writer
+  SpscRing<VectorBatch*> spare(storage.data(), buffers), full(storage.data() + buffers, buffers),
+      done(storage.data() + 2 * buffers, buffers);
+  for (auto& batch : pool)
+  {
+    batch.inputs.resize(batchBlocks * nin);
+    batch.outputs.resize(batchBlocks * nout);
+    spare.push(&batch);
+  }
+
+  PipelineResult res;
+  res.reported.reserve(maxReported);
+  std::atomic<bool> stop{false};
+  std::exception_ptr error;
+  std::mutex lock;
+  auto fail = [&]() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!error)
+      error = std::current_exception();
+    stop = true;
+  };
+
+  std::thread reader([&]() {
+    try
+    {
+      std::string line;
+      std::vector<unsigned short> vec(nin);
+      uint64_t lineNo = 0;
+      bool eof        = false;
+      while (!eof)
+      {
+        VectorBatch* batch;
+        if (!waitFor(stop, [&] { return spare.pop(batch); }))
+          return;
+        batch->count = 0;
+        std::fill(batch->inputs.begin(), batch->inputs.end(), Planes{0, 0});
+        while (batch->count < perBatch)
+        {
+          if (!std::getline(in, line))
+          {
+            eof = true;
+            break;
+          }
+          if (!parseVectorLine(line, nin, vec.data(), ++lineNo))
+            continue;
+          Planes* blk   = batch->inputs.data() + batch->count / 64 * nin;
+          uint64_t lane = 1ULL << (batch->count % 64);
+          for (size_t i = 0; i < nin; i++)
+          {
+            blk[i].val |= vec[i] == 1 ? lane : 0;
+            blk[i].unk |= vec[i] == 2 ? lane : 0;
+          }
+          batch->count++;
+        }
+        batch->last = eof;
+        full.push(batch);
+      }
+    }
+    catch (...)
+    {
+      fail();
+    }
+  });
+
+  std::thread writer([&]() {
+    try
+    {
+      std::string line, expect;
+      std::vector<unsigned short> want(nout);
+      uint64_t vector = 0, lineNo = 0;
+      while (true)
+      {
+        VectorBatch* batch;
+        if (!waitFor(stop, [&] { return done.pop(batch); }))
+          return;
+        for (size_t v = 0; v < batch->count; v++, vector++)
+        {
+          Planes const* blk = batch->outputs.data() + v / 64 * nout;
+          if (out)
+          {
+            line.clear();
+            for (size_t o = 0; o < nout; o++)
+              line.push_back("01X"[blk[o].lane(v % 64)]);
+            line.push_back('\n');
+            out->write(line.data(), line.size());
+          }
+          if (!expected)
+            continue;
+          bool found = false;
+          while (!found && std::getline(*expected, expect))
+            found = parseVectorLine(expect, nout, want.data(), ++lineNo);
+          if (!found)
+            throw std::runtime_error("Expected responses end before vector " + std::to_string(vector));
+          bool differs = false;
+          for (size_t o = 0; o < nout; o++)
+          {
+            unsigned short got = blk[o].lane(v % 64);
+            if (want[o] == 2 || want[o] == got)
+              continue;
+            differs = true;
+            if (res.reported.size() < maxReported)
+              res.reported.push_back({vector, o, want[o], got});
+          }
+          res.mismatches += differs;
+        }
+        bool last = batch->last;
+        spare.push(batch);
+        if (last)
+          break;
+      }
+      res.vectors = vector;
+      if (out)
+        out->flush();
+    }
+    catch (...)
+    {
+      fail();
+    }
+  });
+
+  try
+  {
+    std::vector<Planes> values(nl.nets(), Planes::broadcast(2));
+    while (true)
+    {
+      VectorBatch* batch;
+      if (!waitFor(stop, [&] { return full.pop(batch); }))
+        break;
+      {
+        LG_NO_HEAP();
+        for (size_t b = 0; b * 64 < batch->count; b++)
+        {
+          for (size_t i = 0; i < nin; i++)
+            values[nl.inputs()[i]] = batch->inputs[b * nin + i];
+          nl.evaluate(values.data());
+          for (size_t o = 0; o < nout; o++)
+            batch->outputs[b * nout + o] = values[nl.outputs()[o]];
+        }
+      }
+      bool last = batch->last;
+      done.push(batch);
+      if (last)
+        break;
+    }
+  }
+  catch (...)
+  {
+    fail();
+  }
+  reader.join();
+  writer.join();
+  if (error)
+    std::rethrow_exception(error);
+  return res;
+}
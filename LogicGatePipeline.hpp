@@ -0,0 +1,86 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+/**
+ *  Output that differs from the expected response
+ *
+ */
+struct Mismatch
+{
+  uint64_t vector;
+  size_t output;
+  unsigned short expected;
+  unsigned short actual;
+};
+/**
+ *  Outcome of a pipelined run
+ *
+ */
+struct PipelineResult
+{
+  uint64_t vectors    = 0;
+  /**
+   *  Vectors with at least one mismatching output
+   *
+   */
+  uint64_t mismatches = 0;
+  /**
+   *  First mismatching outputs (at most StimulusPipeline::maxReported)
+   *
+   */
+  std::vector<Mismatch> reported;
+};
+/**
+ *  Parse one line of a vector file (format of StimulusPipeline)
+ *
+ *  width states of a vector line
+ *  states receives width states (0, 1 or 2)
+ *  lineNo line number for error messages
+ *  bool false for a blank or comment line
+ */
+bool parseVectorLine(std::string const& line, size_t width, unsigned short* states, uint64_t lineNo);
+/**
+ *  Stimulus file simulation in three overlapping stages
+ *
+ *  A reader thread parses vector lines into packed batches, the calling
+ *  thread simulates them, and a writer thread formats the responses and
+ *  checks them against an expected file. Stages hand batches on through
+ *  bounded SPSC rings; a fixed set of batches circulates reader ->
+ *  simulator -> writer -> reader, so nothing is allocated once the first
+ *  batches have been filled.
+ *
+ *  Vector files hold one vector per line, one character per input or
+ *  output in net order: 0, 1 or X. Blanks are ignored, '#' starts a
+ *  comment. An X in an expected response matches anything.
+ */
+class StimulusPipeline
+{
+  Netlist const& nl;
+
+public:
+  /**
+   *  Blocks of 64 vectors per batch
+   *
+   */
+  size_t batchBlocks = 16;
+  /**
+   *  Batches in circulation (capacity of every ring)
+   *
+   */
+  size_t buffers     = 8;
+  size_t maxReported = 16;
+
+  explicit StimulusPipeline(Netlist const& netlist);
+  /**
+   *  Simulate every vector of in
+   *
+   *  out receives one response line per vector (nullptr - none)
+   *  expected expected responses (nullptr - no checking)
+   *  PipelineResult
+   */
+  PipelineResult run(std::istream& in, std::ostream* out = nullptr, std::istream* expected = nullptr) const;
+};
@@ -0,0 +1,182 @@
+#include "LogicGateReorder.hpp"
+#include <algorithm>
+#include <deque>
+
+static std::vector<uint32_t> dfsOrder(Netlist const& nl)
+{
+  std::vector<uint32_t> order;
+  std::vector<char> visited(nl.gates(), 0);
+  std::vector<std::pair<uint32_t, size_t>> stack;
+  auto visit = [&](uint32_t root) {
+    if (root == NoGate || visited[root])
+      return;
+    visited[root] = 1;
+    stack.push_back({root, 0});
+    while (!stack.empty())
+    {
+      uint32_t g        = stack.back().first;
+      size_t& next      = stack.back().second;
+      GateType const& t = nl.type(g);
+      if (next < t.inputs())
+      {
+        uint32_t fanin = nl.driver(nl.pin(g, t.inputTerminal(next++)));
+        if (fanin != NoGate && !visited[fanin])
+        {
+          visited[fanin] = 1;
+          stack.push_back({fanin, 0});
+        }
+        continue;
+      }
+      order.push_back(g);
+      stack.pop_back();
+    }
+  };
+  for (auto net : nl.outputs())
+    visit(nl.driver(net));
+  for (uint32_t g = 0; g < nl.gates(); g++)
+    visit(g);
+  return order;
+}
+
+static std::vector<uint32_t> rcmOrder(Netlist const& nl)
+{
+  size_t n = nl.gates();
+  std::vector<std::vector<uint32_t>> adj(n);
+  for (uint32_t g = 0; g < n; g++)
+  {
+    GateType const& t = nl.type(g);
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      uint32_t fanin = nl.driver(nl.pin(g, t.inputTerminal(k)));
+      if (fanin != NoGate && fanin != g)
+      {
+        adj[g].push_back(fanin);
+        adj[fanin].push_back(g);
+      }
+    }
+  }
+  std::vector<uint32_t> byDegree(n);
+  for (uint32_t g = 0; g < n; g++)
+  {
+    byDegree[g] = g;
+    std::sort(adj[g].begin(), adj[g].end());
+    adj[g].erase(std::unique(adj[g].begin(), adj[g].end()), adj[g].end());
+    std::sort(adj[g].begin(), adj[g].end(), [&](uint32_t x, uint32_t y) { return adj[x].size() < adj[y].size(); });
+  }
+  std::stable_sort(byDegree.begin(), byDegree.end(),
+                   [&](uint32_t x, uint32_t y) { return adj[x].size() < adj[y].size(); });
+  std::vector<uint32_t> order;
+  std::vector<char> visited(n, 0);
+  std::deque<uint32_t> queue;
+  for (auto root : byDegree)
+  {
+    if (visited[root])
+      continue;
+    visited[root] = 1;
+    queue.push_back(root);
+    while (!queue.empty())
+    {
+      uint32_t g = queue.front();
+      queue.pop_front();
+      order.push_back(g);
+      for (auto next : adj[g])
+        if (!visited[next])
+        {
+          visited[next] = 1;
+          queue.push_back(next);
+        }
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+Reordering reorder(Netlist const& nl, OrderStrategy strategy)
+{
+  std::vector<uint32_t> order = strategy == OrderStrategy::CuthillMcKee ? rcmOrder(nl) : dfsOrder(nl);
+  Reordering res{Netlist(nl.library()), std::vector<uint32_t>(nl.gates(), NoGate), std::vector<NetId>(nl.nets(), NoGate)};
+
+  // Nets numbered by first use: interface first, then pins in new gate order
+  std::vector<NetId> byNew;
+  auto place = [&](NetId net) {
+    if (res.netMap[net] == NoGate)
+    {
+      res.netMap[net] = byNew.size();
+      byNew.push_back(net);
+    }
+  };
+  for (auto net : nl.inputs())
+    place(net);
+  for (auto g : order)
+    for (size_t n = 0; n < nl.type(g).size(); n++)
+      place(nl.pin(g, n));
+  for (NetId net = 0; net < nl.nets(); net++)
+    place(net);
+
+  std::vector<std::string> names(nl.nets());
+  for (auto const& keyval : nl.netNames())
+    names[keyval.second] = keyval.first;
+  for (auto net : byNew)
+    if (names[net].empty())
+      res.netlist.addNet();
+    else
+      res.netlist.addNet(names[net]);
+  for (auto net : nl.inputs())
+    res.netlist.addInput(res.netMap[net]);
+  for (auto net : nl.outputs())
+    res.netlist.addOutput(res.netMap[net]);
+  std::vector<NetId> pins;
+  for (auto g : order)
+  {
+    pins.clear();
+    for (size_t n = 0; n < nl.type(g).size(); n++)
+      pins.push_back(res.netMap[nl.pin(g, n)]);
+    res.gateMap[g] = res.netlist.addGate(nl.typeId(g), pins);
+  }
+  return res;
+}
+
+uint64_t cacheMisses(Netlist const& nl, size_t sets, size_t ways, uint64_t* accesses)
+{
+  const uint64_t line = 64, pinBase = 0, netBase = uint64_t(1) << 40;
+  std::vector<uint64_t> tags(sets * ways, ~0ULL);
+  uint64_t misses = 0, count = 0;
+  auto touch      = [&](uint64_t addr) {
+    uint64_t tag  = addr / line;
+    uint64_t* set = &tags[(tag % sets) * ways];
+    count++;
+    size_t hit = std::find(set, set + ways, tag) - set;
+    if (hit == ways)
+    {
+      misses++;
+      hit = ways - 1;
+    }
+    // Move to front (LRU order within the set)
+    std::move_backward(set, set + hit, set + hit + 1);
+    set[0] = tag;
+  };
+  // Pin lists are stored contiguously in gate index order
+  std::vector<uint64_t> pinOffset(nl.gates() + 1, 0);
+  for (uint32_t g = 0; g < nl.gates(); g++)
+    pinOffset[g + 1] = pinOffset[g] + nl.type(g).size();
+  for (auto g : nl.order())
+  {
+    GateType const& t = nl.type(g);
+    for (size_t n = 0; n < t.size(); n++)
+    {
+      touch(pinBase + (pinOffset[g] + n) * sizeof(NetId));
+      touch(netBase + uint64_t(nl.pin(g, n)) * sizeof(Planes));
+    }
+  }
+  if (accesses)
+    *accesses = count;
+  return misses;
+}
+
+CacheReport compareCache(Netlist const& before, Netlist const& after)
+{
+  CacheReport res;
+  res.missesBefore = cacheMisses(before, 64, 8, &res.accesses);
+  res.missesAfter  = cacheMisses(after);
+  return res;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <vector>
+/**
+ *  Renumbering strategy
+ *
+ */
+enum class OrderStrategy
+{
+  /**
+   *  Post-order DFS over fanins from the outputs: fanins land right before
+   *  the gate that reads them
+   *
+   */
+  TopologicalDfs,
+  /**
+   *  Reverse Cuthill-McKee over the gate adjacency graph (small bandwidth)
+   *
+   */
+  CuthillMcKee
+};
+/**
+ *  Reordered netlist with remap tables
+ *
+ */
+struct Reordering
+{
+  Netlist netlist;
+  /**
+   *  New index of every old gate
+   *
+   */
+  std::vector<uint32_t> gateMap;
+  /**
+   *  New id of every old net (net names are remapped in netlist)
+   *
+   */
+  std::vector<NetId> netMap;
+};
+/**
+ *  Estimated cache behaviour of one evaluation pass
+ *
+ */
+struct CacheReport
+{
+  uint64_t accesses;
+  uint64_t missesBefore;
+  uint64_t missesAfter;
+  inline double reduction() const { return missesAfter ? double(missesBefore) / missesAfter : 0; }
+};
+/**
+ *  Renumber gates and nets so that connected logic is adjacent in memory
+ *
+ *  Primary inputs and outputs keep their order, so the interface and any
+ *  stimulus stay valid.
+ *
+ *  nl netlist to reorder
+ *  strategy ordering
+ *  Reordering
+ */
+Reordering reorder(Netlist const& nl, OrderStrategy strategy = OrderStrategy::TopologicalDfs);
+/**
+ *  Count misses of one levelized evaluation pass in an LRU set-associative
+ *  cache model (pin lists and net values)
+ *
+ *  nl netlist
+ *  sets number of cache sets
+ *  ways associativity
+ *  uint64_t misses (accesses returned through accesses if not null)
+ */
+uint64_t cacheMisses(Netlist const& nl, size_t sets = 64, size_t ways = 8, uint64_t* accesses = nullptr);
+/**
+ *  Compare cache misses of a netlist before and after reordering
+ *
+ */
+CacheReport compareCache(Netlist const& before, Netlist const& after);
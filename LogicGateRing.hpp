@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+/**
+ *  Bounded lock-free single-producer/single-consumer ring
+ *
+ *  Storage is supplied by the owner, so a ring can live in process-shared
+ *  memory as well as on the heap. Positions only grow; slot = position %
+ *  capacity. The producer publishes with a release store of tail, the
+ *  consumer frees slots with a release store of head.
+ */
+template <typename T>
+class SpscRing
+{
+  alignas(64) std::atomic<uint64_t> head{0};
+  alignas(64) std::atomic<uint64_t> tail{0};
+  alignas(64) uint64_t cap;
+  T* slots;
+
+public:
+  SpscRing(T* storage, uint64_t capacity) : cap{capacity}, slots{storage} {}
+  inline uint64_t capacity() const { return cap; }
+  /**
+   *  Items ready for the consumer
+   *
+   */
+  inline size_t available() const
+  {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+  }
+  /**
+   *  Free slots for the producer
+   *
+   */
+  inline size_t space() const
+  {
+    return cap - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+  }
+  /**
+   *  Append n items (producer, requires space() >= n)
+   *
+   */
+  void write(T const* src, size_t n)
+  {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; i++)
+      slots[(t + i) % cap] = src[i];
+    tail.store(t + n, std::memory_order_release);
+  }
+  /**
+   *  Remove n items (consumer, requires available() >= n)
+   *
+   */
+  void read(T* dst, size_t n)
+  {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; i++)
+      dst[i] = slots[(h + i) % cap];
+    head.store(h + n, std::memory_order_release);
+  }
+  /**
+   *  Append one item if there is room (producer)
+   *
+   */
+  bool push(T const& item)
+  {
+    if (!space())
+      return false;
+    write(&item, 1);
+    return true;
+  }
+  /**
+   *  Remove one item if there is one (consumer)
+   *
+   */
+  bool pop(T& item)
+  {
+    if (!available())
+      return false;
+    read(&item, 1);
+    return true;
+  }
+};
@@ -0,0 +1,291 @@
+#include "LogicGateSat.hpp"
+#include <algorithm>
+
+int SatSolver::newVar()
+{
+  int var = assign.size();
+  assign.push_back(-1);
+  levels.push_back(0);
+  reasons.push_back(-1);
+  activity.push_back(0);
+  heapPos.push_back(-1);
+  polarity.push_back(1);
+  seen.push_back(0);
+  watches.resize(2 * assign.size());
+  heapInsert(var);
+  return var;
+}
+
+void SatSolver::heapUp(int pos)
+{
+  int var = heap[pos];
+  while (pos > 0 && activity[heap[(pos - 1) / 2]] < activity[var])
+  {
+    heap[pos]          = heap[(pos - 1) / 2];
+    heapPos[heap[pos]] = pos;
+    pos                = (pos - 1) / 2;
+  }
+  heap[pos]    = var;
+  heapPos[var] = pos;
+}
+
+void SatSolver::heapDown(int pos)
+{
+  int var = heap[pos];
+  int n   = heap.size();
+  while (2 * pos + 1 < n)
+  {
+    int child = 2 * pos + 1;
+    if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]])
+      child++;
+    if (activity[heap[child]] <= activity[var])
+      break;
+    heap[pos]          = heap[child];
+    heapPos[heap[pos]] = pos;
+    pos                = child;
+  }
+  heap[pos]    = var;
+  heapPos[var] = pos;
+}
+
+void SatSolver::heapInsert(int var)
+{
+  if (heapPos[var] >= 0)
+    return;
+  heap.push_back(var);
+  heapUp(heap.size() - 1);
+}
+
+int SatSolver::heapPop()
+{
+  int var      = heap[0];
+  heapPos[var] = -1;
+  heap[0]      = heap.back();
+  heap.pop_back();
+  if (!heap.empty())
+    heapDown(0);
+  return var;
+}
+
+void SatSolver::bump(int var)
+{
+  if ((activity[var] += inc) > 1e100)
+  {
+    for (auto& a : activity)
+      a *= 1e-100;
+    inc *= 1e-100;
+  }
+  if (heapPos[var] >= 0)
+    heapUp(heapPos[var]);
+}
+
+void SatSolver::enqueue(Lit l, int reason)
+{
+  assign[l >> 1]  = !(l & 1);
+  levels[l >> 1]  = decisionLevel();
+  reasons[l >> 1] = reason;
+  trail.push_back(l);
+}
+
+void SatSolver::watch(int ci)
+{
+  watches[clauses[ci][0]].push_back(ci);
+  watches[clauses[ci][1]].push_back(ci);
+}
+
+bool SatSolver::addClause(std::vector<Lit> lits)
+{
+  if (!ok)
+    return false;
+  cancelUntil(0);
+  std::sort(lits.begin(), lits.end());
+  size_t kept = 0;
+  for (size_t i = 0; i < lits.size(); i++)
+  {
+    if (value(lits[i]) == 1 || (i + 1 < lits.size() && lits[i + 1] == (lits[i] ^ 1)))
+      return true;
+    if (value(lits[i]) == 0 || (kept && lits[kept - 1] == lits[i]))
+      continue;
+    lits[kept++] = lits[i];
+  }
+  lits.resize(kept);
+  if (lits.empty())
+    return ok = false;
+  if (lits.size() == 1)
+  {
+    enqueue(lits[0], -1);
+    return ok = propagate() < 0;
+  }
+  clauses.push_back(std::move(lits));
+  watch(clauses.size() - 1);
+  return true;
+}
+
+int SatSolver::propagate()
+{
+  while (qhead < trail.size())
+  {
+    Lit falsified = trail[qhead++] ^ 1;
+    auto& ws      = watches[falsified];
+    size_t i = 0, j = 0;
+    while (i < ws.size())
+    {
+      int ci  = ws[i++];
+      auto& c = clauses[ci];
+      if (c[0] == falsified)
+        std::swap(c[0], c[1]);
+      if (value(c[0]) == 1)
+      {
+        ws[j++] = ci;
+        continue;
+      }
+      bool moved = false;
+      for (size_t k = 2; k < c.size(); k++)
+        if (value(c[k]) != 0)
+        {
+          std::swap(c[1], c[k]);
+          watches[c[1]].push_back(ci);
+          moved = true;
+          break;
+        }
+      if (moved)
+        continue;
+      ws[j++] = ci;
+      if (value(c[0]) == 0)
+      {
+        while (i < ws.size())
+          ws[j++] = ws[i++];
+        ws.resize(j);
+        qhead = trail.size();
+        return ci;
+      }
+      enqueue(c[0], ci);
+    }
+    ws.resize(j);
+  }
+  return -1;
+}
+
+void SatSolver::analyze(int confl, std::vector<Lit>& learnt, int& backLevel)
+{
+  learnt.assign(1, 0);
+  int pending = 0;
+  Lit p       = -1;
+  size_t idx  = trail.size();
+  do
+  {
+    auto const& c = clauses[confl];
+    for (size_t k = (p < 0 ? 0 : 1); k < c.size(); k++)
+    {
+      int var = c[k] >> 1;
+      if (seen[var] || levels[var] == 0)
+        continue;
+      seen[var] = 1;
+      bump(var);
+      if (levels[var] >= decisionLevel())
+        pending++;
+      else
+        learnt.push_back(c[k]);
+    }
+    while (!seen[trail[--idx] >> 1])
+      ;
+    p            = trail[idx];
+    confl        = reasons[p >> 1];
+    seen[p >> 1] = 0;
+    pending--;
+  } while (pending > 0);
+  learnt[0] = p ^ 1;
+
+  backLevel = 0;
+  for (size_t k = 1; k < learnt.size(); k++)
+  {
+    seen[learnt[k] >> 1] = 0;
+    if (levels[learnt[k] >> 1] > backLevel)
+    {
+      backLevel = levels[learnt[k] >> 1];
+      std::swap(learnt[1], learnt[k]);
+    }
+  }
+  inc *= 1 / 0.95;
+}
+
+void SatSolver::cancelUntil(int level)
+{
+  if (decisionLevel() <= level)
+    return;
+  for (size_t i = trail.size(); i-- > trailLim[level];)
+  {
+    int var       = trail[i] >> 1;
+    polarity[var] = trail[i] & 1;
+    assign[var]   = -1;
+    heapInsert(var);
+  }
+  trail.resize(trailLim[level]);
+  trailLim.resize(level);
+  qhead = trail.size();
+}
+
+static uint64_t luby(uint64_t i)
+{
+  uint64_t size = 1, seq = 0;
+  while (size < i + 1)
+  {
+    seq++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != i)
+  {
+    size = (size - 1) >> 1;
+    seq--;
+    i = i % size;
+  }
+  return uint64_t(1) << seq;
+}
+
+bool SatSolver::solve()
+{
+  if (!ok)
+    return false;
+  cancelUntil(0);
+  std::vector<Lit> learnt;
+  uint64_t restarts = 0, conflicts = 0, budget = 100 * luby(0);
+  while (true)
+  {
+    int confl = propagate();
+    if (confl >= 0)
+    {
+      conflicts++;
+      if (decisionLevel() == 0)
+        return ok = false;
+      int backLevel;
+      analyze(confl, learnt, backLevel);
+      cancelUntil(backLevel);
+      if (learnt.size() == 1)
+        enqueue(learnt[0], -1);
+      else
+      {
+        clauses.push_back(learnt);
+        watch(clauses.size() - 1);
+        enqueue(learnt[0], clauses.size() - 1);
+      }
+      continue;
+    }
+    if (conflicts >= budget)
+    {
+      cancelUntil(0);
+      conflicts = 0;
+      budget    = 100 * luby(++restarts);
+    }
+    int var = -1;
+    while (!heap.empty() && var < 0)
+    {
+      int top = heapPop();
+      if (assign[top] < 0)
+        var = top;
+    }
+    if (var < 0)
+      return true;
+    trailLim.push_back(trail.size());
+    enqueue(lit(var, polarity[var]), -1);
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+/**
+ *  Conflict-driven clause-learning SAT solver
+ *
+ *  Two watched literals, first-UIP learning, VSIDS decisions with phase
+ *  saving and Luby restarts. Literal of variable v is 2*v (positive) or
+ *  2*v+1 (negated).
+ */
+class SatSolver
+{
+public:
+  typedef int Lit;
+  static inline Lit lit(int var, bool neg = false) { return 2 * var + neg; }
+
+private:
+  std::vector<std::vector<Lit>> clauses;
+  std::vector<std::vector<int>> watches;
+  std::vector<signed char> assign;
+  std::vector<int> levels;
+  std::vector<int> reasons;
+  std::vector<Lit> trail;
+  std::vector<size_t> trailLim;
+  size_t qhead = 0;
+  std::vector<double> activity;
+  double inc = 1;
+  std::vector<int> heap;
+  std::vector<int> heapPos;
+  std::vector<char> polarity;
+  std::vector<char> seen;
+  bool ok = true;
+
+  inline int value(Lit l) const { return assign[l >> 1] < 0 ? -1 : assign[l >> 1] ^ (l & 1); }
+  inline int decisionLevel() const { return trailLim.size(); }
+  void enqueue(Lit l, int reason);
+  int propagate();
+  void analyze(int confl, std::vector<Lit>& learnt, int& backLevel);
+  void cancelUntil(int level);
+  void bump(int var);
+  void heapUp(int pos);
+  void heapDown(int pos);
+  void heapInsert(int var);
+  int heapPop();
+  void watch(int ci);
+
+public:
+  /**
+   *  Add variable
+   *
+   *  int variable index
+   */
+  int newVar();
+  inline int vars() const { return assign.size(); }
+  /**
+   *  Add clause (before or between solve() calls)
+   *
+   *  lits literals of clause
+   *  false if the formula became trivially unsatisfiable
+   */
+  bool addClause(std::vector<Lit> lits);
+  /**
+   *  Search for a satisfying assignment
+   *
+   *  true if satisfiable
+   */
+  bool solve();
+  /**
+   *  Value of variable in the last model
+   *
+   */
+  inline bool model(int var) const { return assign[var] == 1; }
+};
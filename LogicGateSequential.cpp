@@ -0,0 +1,168 @@
+#include "LogicGateSequential.hpp"
+#include "LogicGateStats.hpp"
+#include <stdexcept>
+
+SequentialCircuit::SequentialCircuit(Netlist const& netlist) : comb(netlist), isQ(netlist.nets(), false) {}
+
+size_t SequentialCircuit::add(Register reg)
+{
+  if (reg.d >= comb.nets() || reg.q >= comb.nets() || (reg.enable != NoNet && reg.enable >= comb.nets()))
+    throw std::out_of_range("");
+  if (reg.reset > 2)
+    throw std::runtime_error("Reset state must be 0, 1 or 2");
+  // The netlist may have grown since construction
+  if (isQ.size() < comb.nets())
+    isQ.resize(comb.nets(), false);
+  if (comb.driver(reg.q) != NoGate || isQ[reg.q])
+    throw std::runtime_error("Net has two drivers");
+  for (auto in : comb.inputs())
+    if (in == reg.q)
+      throw std::runtime_error("Net has two drivers");
+  isQ[reg.q] = true;
+  regs.push_back(reg);
+  return regs.size() - 1;
+}
+
+size_t SequentialCircuit::addDff(NetId d, NetId q, unsigned short reset, NetId enable)
+{
+  return add({RegisterKind::Dff, d, q, enable, reset});
+}
+
+size_t SequentialCircuit::addLatch(NetId d, NetId q, NetId enable, unsigned short reset)
+{
+  if (enable == NoNet)
+    throw std::runtime_error("Latch requires enable");
+  return add({RegisterKind::Latch, d, q, enable, reset});
+}
+
+CycleSimulator::CycleSimulator(SequentialCircuit const& seq)
+    : circuit(seq), values(seq.netlist().nets(), Planes::broadcast(2)), opOffsets{0}
+{
+  Netlist const& nl = seq.netlist();
+  for (auto g : nl.order())
+  {
+    GateType const& t = nl.type(g);
+    opTypes.push_back(&t);
+    for (size_t k = 0; k < t.inputs(); k++)
+      opNets.push_back(nl.pin(g, t.inputTerminal(k)));
+    for (size_t k = 0; k < t.outputs(); k++)
+      opNets.push_back(nl.pin(g, t.outputTerminal(k)));
+    opOffsets.push_back(opNets.size());
+  }
+  reset();
+}
+
+void CycleSimulator::load()
+{
+  auto const& regs = circuit.registers();
+  for (size_t r = 0; r < regs.size(); r++)
+    values[regs[r].q] = state[cur][r];
+}
+
+void CycleSimulator::reset()
+{
+  auto const& regs = circuit.registers();
+  for (auto& buf : state)
+    buf.resize(regs.size());
+  for (size_t r = 0; r < regs.size(); r++)
+    state[cur][r] = Planes::broadcast(regs[r].reset);
+  _cycle = 0;
+  load();
+}
+
+void CycleSimulator::setInput(size_t i, unsigned short st) { setInput(i, Planes::broadcast(st)); }
+
+void CycleSimulator::setInput(size_t i, Planes val)
+{
+  auto const& in = circuit.netlist().inputs();
+  if (i >= in.size())
+    throw std::out_of_range("");
+  values[in[i]] = val;
+}
+
+void CycleSimulator::setInputs(std::vector<unsigned short> const& states)
+{
+  if (states.size() != circuit.netlist().inputs().size())
+    throw std::runtime_error("Wrong number of inputs");
+  for (size_t i = 0; i < states.size(); i++)
+    setInput(i, states[i]);
+}
+
+Planes CycleSimulator::output(size_t i) const
+{
+  auto const& out = circuit.netlist().outputs();
+  if (i >= out.size())
+    throw std::out_of_range("");
+  return values[out[i]];
+}
+
+std::vector<unsigned short> CycleSimulator::outputs(size_t lane) const
+{
+  std::vector<unsigned short> res;
+  for (auto net : circuit.netlist().outputs())
+    res.push_back(values[net].lane(lane));
+  return res;
+}
+
+void CycleSimulator::evaluate()
+{
+  Planes* v = values.data();
+  Planes in[GateType::MaxTerminals];
+  for (size_t op = 0; op < opTypes.size(); op++)
+  {
+    GateType const& t = *opTypes[op];
+    NetId const* nets = opNets.data() + opOffsets[op];
+    for (size_t k = 0; k < t.inputs(); k++)
+      in[k] = v[nets[k]];
+    for (size_t k = 0; k < t.outputs(); k++)
+      v[nets[t.inputs() + k]] = t.evaluate(in, k);
+  }
+  LG_STAT_ADD(evaluations, opTypes.size());
+}
+
+void CycleSimulator::settle()
+{
+  LG_STAT_PHASE(Evaluate);
+  LG_NO_HEAP();
+  evaluate();
+}
+
+void CycleSimulator::step()
+{
+  {
+    LG_STAT_PHASE(Evaluate);
+    LG_NO_HEAP();
+    evaluate();
+  }
+  LG_STAT_PHASE(Commit);
+  LG_NO_HEAP();
+  auto const& regs  = circuit.registers();
+  Planes const* now = state[cur].data();
+  Planes* next      = state[cur ^ 1].data();
+  for (size_t r = 0; r < regs.size(); r++)
+  {
+    Planes d = values[regs[r].d];
+    if (regs[r].enable == NoNet)
+    {
+      next[r] = d;
+      continue;
+    }
+    // Hold on Low enable, load on High, X unless data equals the held value
+    Planes en     = values[regs[r].enable];
+    Planes q      = now[r];
+    uint64_t en1  = en.val & ~en.unk;
+    uint64_t en0  = ~en.val & ~en.unk;
+    uint64_t same = ~(d.unk | q.unk) & ~(d.val ^ q.val);
+    uint64_t unk  = (en1 & d.unk) | (en0 & q.unk) | (en.unk & ~same);
+    next[r]       = {((en1 & d.val) | (en0 & q.val) | (en.unk & same & d.val)) & ~unk, unk};
+  }
+  cur ^= 1;
+  _cycle++;
+  load();
+}
+
+void CycleSimulator::run(uint64_t cycles)
+{
+  for (uint64_t c = 0; c < cycles; c++)
+    step();
+}
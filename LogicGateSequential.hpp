@@ -0,0 +1,167 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <vector>
+/**
+ *  Marks an absent optional net
+ *
+ */
+constexpr NetId NoNet = UINT32_MAX;
+/**
+ *  Storage element kind
+ *
+ */
+enum class RegisterKind : unsigned char
+{
+  /**
+   *  Edge-triggered flip-flop (optional clock enable)
+   *
+   */
+  Dff,
+  /**
+   *  Level-sensitive latch, sampled once per cycle while enable is High
+   *
+   */
+  Latch
+};
+/**
+ *  Storage element between two nets of the combinational netlist
+ *
+ */
+struct Register
+{
+  RegisterKind kind;
+  NetId d;
+  NetId q;
+  NetId enable;
+  /**
+   *  State after reset (0 - Low, 1 - High, 2 - Undefined)
+   *
+   */
+  unsigned short reset;
+};
+/**
+ *  Combinational netlist plus registers
+ *
+ *  Register outputs (q) must be undriven nets of the netlist; they act as
+ *  sources for levelization, so every loop has to pass through a register.
+ */
+class SequentialCircuit
+{
+  Netlist const& comb;
+  std::vector<Register> regs;
+  std::vector<bool> isQ;
+
+  size_t add(Register reg);
+
+public:
+  explicit SequentialCircuit(Netlist const& netlist);
+  inline Netlist const& netlist() const { return comb; }
+  inline std::vector<Register> const& registers() const { return regs; }
+  /**
+   *  Add flip-flop
+   *
+   *  d data net
+   *  q output net (undriven in netlist)
+   *  reset state after reset (2 - X)
+   *  enable clock enable net or NoNet
+   *  size_t register index
+   */
+  size_t addDff(NetId d, NetId q, unsigned short reset = 2, NetId enable = NoNet);
+  /**
+   *  Add latch
+   *
+   *  d data net
+   *  q output net (undriven in netlist)
+   *  enable gate net
+   *  reset state after reset (2 - X)
+   *  size_t register index
+   */
+  size_t addLatch(NetId d, NetId q, NetId enable, unsigned short reset = 2);
+};
+/**
+ *  Cycle-based simulator
+ *
+ *  Each step() evaluates the combinational logic once in levelized order and
+ *  commits all registers at once by swapping the current/next state buffers.
+ *  Every net carries 64 independent lanes (Planes), so one run simulates up
+ *  to 64 stimulus streams.
+ */
+class CycleSimulator
+{
+  SequentialCircuit const& circuit;
+  std::vector<Planes> values;
+  std::vector<Planes> state[2];
+  unsigned cur    = 0;
+  uint64_t _cycle = 0;
+  /**
+   *  Compiled schedule: type and input+output nets of every gate
+   *
+   */
+  std::vector<GateType const*> opTypes;
+  std::vector<uint32_t> opOffsets;
+  std::vector<NetId> opNets;
+
+  void evaluate();
+  void load();
+
+public:
+  explicit CycleSimulator(SequentialCircuit const& seq);
+  /**
+   *  Put every register into its reset state
+   *
+   */
+  void reset();
+  /**
+   *  Set primary input i on all lanes
+   *
+   */
+  void setInput(size_t i, unsigned short state);
+  /**
+   *  Set primary input i per lane
+   *
+   */
+  void setInput(size_t i, Planes val);
+  /**
+   *  Set all primary inputs on all lanes
+   *
+   */
+  void setInputs(std::vector<unsigned short> const& states);
+  /**
+   *  Value of primary output i as of the last evaluation
+   *
+   */
+  Planes output(size_t i) const;
+  /**
+   *  States of all primary outputs on one lane
+   *
+   */
+  std::vector<unsigned short> outputs(size_t lane = 0) const;
+  /**
+   *  Current (committed) state of register r
+   *
+   */
+  inline Planes registerState(size_t r) const { return state[cur][r]; }
+  /**
+   *  Value of net as of the last evaluation
+   *
+   */
+  inline Planes net(NetId n) const { return values[n]; }
+  /**
+   *  Evaluate combinational logic without clocking
+   *
+   */
+  void settle();
+  /**
+   *  One clock edge: evaluate, then commit every register
+   *
+   *  Outputs afterwards show the values sampled at that edge.
+   */
+  void step();
+  /**
+   *  Run a number of clock edges with constant inputs
+   *
+   */
+  void run(uint64_t cycles);
+  inline uint64_t cycle() const { return _cycle; }
+};
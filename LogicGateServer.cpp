@@ -0,0 +1,566 @@
+#include "LogicGateServer.hpp"
+#include "LogicGateJournal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <unistd.h>
+
+static void check(int res, char const* what)
+{
+  if (res < 0)
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+std::shared_ptr<GateMap const> DesignStore::open(std::string const& path)
+{
+  // The journal itself may be missing (snapshot only), so resolve its directory
+  size_t slash     = path.rfind('/');
+  std::string dir  = slash == std::string::npos ? "." : slash ? path.substr(0, slash) : "/";
+  std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+  char real[PATH_MAX];
+  if (!realpath(dir.c_str(), real))
+    throw std::system_error(errno, std::generic_category(), path);
+  std::string key = std::string(real) + "/" + name;
+
+  std::promise<std::shared_ptr<GateMap const>> loaded;
+  std::shared_future<std::shared_ptr<GateMap const>> design;
+  bool loader = false;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = designs.find(key);
+    if (it != designs.end())
+      design = it->second;
+    else
+    {
+      design = loaded.get_future().share();
+      designs.emplace(key, design);
+      loader = true;
+    }
+  }
+  // Load outside the lock; sessions opening the same design wait on the future
+  if (loader)
+    try
+    {
+      auto map = std::make_shared<GateMap>();
+      Journal::load(key, *map);
+      loaded.set_value(std::move(map));
+    }
+    catch (...)
+    {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        designs.erase(key);
+      }
+      loaded.set_exception(std::current_exception());
+    }
+  return design.get();
+}
+
+size_t DesignStore::size()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return designs.size();
+}
+
+void SessionOverlay::reset(std::shared_ptr<GateMap const> design)
+{
+  base = std::move(design);
+  changed.clear();
+  removed.clear();
+}
+
+void SessionOverlay::revert()
+{
+  changed.clear();
+  removed.clear();
+}
+
+Gate const* SessionOverlay::find(std::string const& name) const
+{
+  auto it = changed.find(name);
+  if (it != changed.end())
+    return &it->second;
+  if (!base || removed.count(name))
+    return nullptr;
+  auto jt = base->find(name);
+  return jt == base->end() ? nullptr : &jt->second;
+}
+
+Gate& SessionOverlay::write(std::string const& name)
+{
+  auto it = changed.find(name);
+  if (it != changed.end())
+    return it->second;
+  Gate const* shared = find(name);
+  if (!shared)
+    throw std::out_of_range("Gate not found");
+  return changed.emplace(name, Gate(*shared)).first->second;
+}
+
+void SessionOverlay::put(std::string const& name, Gate gate)
+{
+  changed.erase(name);
+  changed.emplace(name, std::move(gate));
+}
+
+bool SessionOverlay::erase(std::string const& name)
+{
+  if (!find(name))
+    return false;
+  changed.erase(name);
+  if (base && base->count(name))
+    removed.insert(name);
+  return true;
+}
+
+std::vector<std::string> SessionOverlay::names() const
+{
+  std::vector<std::string> res;
+  if (base)
+    for (auto const& keyval : *base)
+      if (!removed.count(keyval.first) && !changed.count(keyval.first))
+        res.push_back(keyval.first);
+  size_t shared = res.size();
+  for (auto const& keyval : changed)
+    res.push_back(keyval.first);
+  std::inplace_merge(res.begin(), res.begin() + shared, res.end());
+  return res;
+}
+
+SimulationServer::SimulationServer(std::string socket, size_t threads) : path(std::move(socket))
+{
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("Socket path too long: " + path);
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  try
+  {
+    check(listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0), "socket");
+    unlink(path.c_str());
+    check(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), path.c_str());
+    check(listen(listener, SOMAXCONN), "listen");
+    check(epoll = epoll_create1(EPOLL_CLOEXEC), "epoll_create1");
+    check(wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd");
+    for (int fd : {listener, wakeup})
+    {
+      epoll_event ev{};
+      ev.events  = EPOLLIN;
+      ev.data.fd = fd;
+      check(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev), "epoll_ctl");
+    }
+  }
+  catch (...)
+  {
+    for (int fd : {listener, epoll, wakeup})
+      if (fd >= 0)
+        close(fd);
+    throw;
+  }
+  size_t count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < count; i++)
+    workers.emplace_back([this] { work(); });
+}
+
+SimulationServer::~SimulationServer()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  ready.notify_all();
+  for (auto& worker : workers)
+    worker.join();
+  for (auto& keyval : sessions)
+    close(keyval.first);
+  close(listener);
+  close(epoll);
+  close(wakeup);
+  unlink(path.c_str());
+}
+
+void SimulationServer::preload(std::string const& design) { store.open(design); }
+
+void SimulationServer::stop()
+{
+  stopRequested = true;
+  uint64_t one  = 1;
+  // Only async-signal-safe calls here
+  ssize_t res = ::write(wakeup, &one, sizeof(one));
+  (void)res;
+}
+
+void SimulationServer::run()
+{
+  epoll_event events[64];
+  while (!stopRequested)
+  {
+    int n = epoll_wait(epoll, events, 64, -1);
+    if (n < 0 && errno == EINTR)
+      continue;
+    check(n, "epoll_wait");
+    for (int i = 0; i < n; i++)
+    {
+      int fd = events[i].data.fd;
+      if (fd == listener)
+        accept();
+      else if (fd == wakeup)
+      {
+        uint64_t count;
+        ssize_t res = ::read(wakeup, &count, sizeof(count));
+        (void)res;
+        complete();
+      }
+      else
+      {
+        auto it = sessions.find(fd);
+        if (it == sessions.end())
+          continue;
+        Session& session = *it->second;
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+        {
+          session.closing = true;
+          send(session);
+        }
+        else if (events[i].events & EPOLLIN)
+          receive(session);
+        else
+          send(session);
+      }
+    }
+  }
+  stopRequested = false;
+}
+
+void SimulationServer::accept()
+{
+  while (true)
+  {
+    int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      // EAGAIN, or out of descriptors: pending clients wait for the next round
+      return;
+    }
+    auto session = std::make_unique<Session>();
+    session->fd  = fd;
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      close(fd);
+      continue;
+    }
+    session->events = EPOLLIN;
+    sessions.emplace(fd, std::move(session));
+  }
+}
+
+void SimulationServer::receive(Session& session)
+{
+  char buf[16 << 10];
+  while (session.in.size() < maxLine)
+  {
+    ssize_t n = ::read(session.fd, buf, sizeof(buf));
+    if (n > 0)
+    {
+      session.in.append(buf, n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (n < 0)
+      session.closing = true;
+    // End of input: the last line needs no newline
+    else if (!session.in.empty() && session.in.back() != '\n')
+      session.in.push_back('\n');
+    session.eof = true;
+    break;
+  }
+  dispatch(session);
+  send(session);
+}
+
+void SimulationServer::dispatch(Session& session)
+{
+  if (session.busy || session.closing || session.out.size() >= maxOutput)
+    return;
+  size_t end = session.in.rfind('\n');
+  if (end == std::string::npos)
+  {
+    if (session.in.size() >= maxLine)
+    {
+      session.in.clear();
+      session.out += "err Request too long\n";
+      session.eof = true;
+    }
+    return;
+  }
+  session.batch.assign(session.in, 0, end + 1);
+  session.in.erase(0, end + 1);
+  session.busy = true;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    queued.push_back(&session);
+  }
+  ready.notify_one();
+}
+
+void SimulationServer::send(Session& session)
+{
+  while (!session.out.empty() && !session.closing)
+  {
+    ssize_t n = ::send(session.fd, session.out.data(), session.out.size(), MSG_NOSIGNAL);
+    if (n > 0)
+      session.out.erase(0, n);
+    else if (n < 0 && errno == EINTR)
+      continue;
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    else
+      session.closing = true;
+  }
+  if (session.closing)
+  {
+    // A hung-up socket keeps reporting until the worker is done with it
+    if (session.busy)
+      epoll_ctl(epoll, EPOLL_CTL_DEL, session.fd, nullptr);
+    else
+      drop(session);
+    return;
+  }
+  // Requests held back while replies piled up
+  dispatch(session);
+  if (!session.busy && session.eof && session.out.empty())
+  {
+    drop(session);
+    return;
+  }
+  // Stop reading while requests or replies pile up, or after end of input
+  bool full       = session.eof || session.in.size() >= maxLine || session.out.size() >= maxOutput;
+  uint32_t events = (full ? 0u : uint32_t(EPOLLIN)) | (session.out.empty() ? 0u : uint32_t(EPOLLOUT));
+  if (events != session.events)
+  {
+    epoll_event ev{};
+    ev.events  = events;
+    ev.data.fd = session.fd;
+    epoll_ctl(epoll, EPOLL_CTL_MOD, session.fd, &ev);
+    session.events = events;
+  }
+}
+
+void SimulationServer::complete()
+{
+  std::vector<Session*> done;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    done.swap(finished);
+  }
+  for (auto session : done)
+  {
+    session->busy = false;
+    session->out += session->replies;
+    if (session->quit)
+    {
+      session->in.clear();
+      session->eof = true;
+    }
+    dispatch(*session);
+    send(*session);
+  }
+}
+
+void SimulationServer::drop(Session& session)
+{
+  int fd = session.fd;
+  epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  sessions.erase(fd);
+}
+
+void SimulationServer::work()
+{
+  while (true)
+  {
+    Session* session;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      ready.wait(guard, [this] { return stopping || !queued.empty(); });
+      if (stopping)
+        return;
+      session = queued.front();
+      queued.pop_front();
+    }
+    session->replies.clear();
+    std::string const& batch = session->batch;
+    for (size_t pos = 0; pos < batch.size() && !session->quit;)
+    {
+      size_t end = batch.find('\n', pos);
+      size_t len = end - pos;
+      if (len && batch[end - 1] == '\r')
+        len--;
+      if (len)
+        execute(*session, batch.substr(pos, len));
+      pos = end + 1;
+    }
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      finished.push_back(session);
+    }
+    uint64_t one = 1;
+    ssize_t res  = ::write(wakeup, &one, sizeof(one));
+    (void)res;
+  }
+}
+
+static unsigned short parseState(std::string const& token)
+{
+  if (token == "0" || token == "1")
+    return token[0] - '0';
+  if (token == "X" || token == "x")
+    return 2;
+  throw std::runtime_error("Bad state '" + token + "'");
+}
+
+void SimulationServer::execute(Session& session, std::string const& request)
+{
+  served.fetch_add(1, std::memory_order_relaxed);
+  std::istringstream in(request);
+  std::string cmd, name, token;
+  size_t pos = 0, outs = 0;
+  std::string& reply = session.replies;
+  auto args          = [&](bool hasPos) {
+    if (!(in >> name) || (hasPos && !(in >> pos)))
+      throw std::runtime_error("Bad request");
+  };
+  auto finish = [&]() {
+    if (in >> token)
+      throw std::runtime_error("Bad request");
+  };
+  try
+  {
+    in >> cmd;
+    if (cmd == "open")
+    {
+      std::getline(in >> std::ws, name);
+      session.overlay.reset(store.open(name));
+      reply += "ok " + std::to_string(session.overlay.names().size()) + "\n";
+    }
+    else if (cmd == "revert")
+    {
+      finish();
+      session.overlay.revert();
+      reply += "ok\n";
+    }
+    else if (cmd == "list")
+    {
+      finish();
+      reply += "ok";
+      for (auto const& gate : session.overlay.names())
+        reply += " " + gate;
+      reply += "\n";
+    }
+    else if (cmd == "new")
+    {
+      args(true);
+      if (!(in >> outs))
+        throw std::runtime_error("Bad request");
+      finish();
+      session.overlay.put(name, Gate(pos, outs));
+      reply += "ok\n";
+    }
+    else if (cmd == "remove")
+    {
+      args(false);
+      finish();
+      reply += session.overlay.erase(name) ? "ok\n" : "err Gate not found\n";
+    }
+    else if (cmd == "add")
+    {
+      args(false);
+      std::string io;
+      if (!(in >> io >> token) || (io != "in" && io != "out"))
+        throw std::runtime_error("Bad request");
+      finish();
+      unsigned short state = parseState(token);
+      session.overlay.write(name) += Terminal(io == "out", 0, state);
+      reply += "ok\n";
+    }
+    else if (cmd == "states")
+    {
+      args(false);
+      finish();
+      Gate const* gate = session.overlay.find(name);
+      if (!gate)
+        throw std::out_of_range("Gate not found");
+      reply += "ok";
+      for (size_t i = 0; i < gate->size(); i++)
+      {
+        Terminal const& term = gate->terminal(i);
+        reply += term.isOutput ? " o" : " i";
+        reply += "01X"[term.state];
+      }
+      reply += "\n";
+    }
+    else if (cmd == "get")
+    {
+      args(true);
+      finish();
+      Gate const* gate = session.overlay.find(name);
+      if (!gate)
+        throw std::out_of_range("Gate not found");
+      reply += std::string("ok ") + "01X"[gate->terminal(pos).state] + "\n";
+    }
+    else if (cmd == "set")
+    {
+      args(true);
+      if (!(in >> token))
+        throw std::runtime_error("Bad request");
+      finish();
+      unsigned short state = parseState(token);
+      session.overlay.write(name)(pos, state);
+      reply += "ok\n";
+    }
+    else if (cmd == "connect" || cmd == "disconnect")
+    {
+      args(true);
+      finish();
+      Gate& gate = session.overlay.write(name);
+      if (cmd == "connect")
+        gate.connect(pos);
+      else
+        gate.disconnect(pos);
+      reply += "ok\n";
+    }
+    else if (cmd == "quit")
+    {
+      session.quit = true;
+      reply += "ok\n";
+    }
+    else
+      reply += "err Unknown request '" + cmd + "'\n";
+  }
+  catch (std::out_of_range& e)
+  {
+    reply += std::string("err ") + (*e.what() ? e.what() : "Out of range") + "\n";
+  }
+  catch (std::exception& e)
+  {
+    reply += std::string("err ") + e.what() + "\n";
+  }
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+/**
+ *  Saved sessions loaded once and shared read-only
+ *
+ *  Designs are keyed by canonical path; every session opening the same
+ *  journal gets the same map. A loaded design is never modified, so any
+ *  number of threads read it without locking. Loading happens outside the
+ *  store lock, so one large design never holds up opens of others.
+ */
+class DesignStore
+{
+  std::mutex lock;
+  /**
+   *  Designs by canonical path, ready or still loading
+   *
+   */
+  std::map<std::string, std::shared_future<std::shared_ptr<GateMap const>>> designs;
+
+public:
+  /**
+   *  Design saved at path (loaded by Journal::load on first use)
+   *
+   */
+  std::shared_ptr<GateMap const> open(std::string const& path);
+  size_t size();
+};
+/**
+ *  Private edits of one session on top of a shared design
+ *
+ *  A gate is copied into the overlay the first time the session changes
+ *  it; untouched gates are read straight from the design. Removed design
+ *  gates are remembered as such, so the design itself never changes.
+ */
+class SessionOverlay
+{
+  std::shared_ptr<GateMap const> base;
+  GateMap changed;
+  std::set<std::string> removed;
+
+public:
+  /**
+   *  Start over on design (nullptr - empty design)
+   *
+   */
+  void reset(std::shared_ptr<GateMap const> design = nullptr);
+  /**
+   *  Gate name as seen by the session (nullptr if none)
+   *
+   */
+  Gate const* find(std::string const& name) const;
+  /**
+   *  Drop all edits, keeping the design
+   *
+   */
+  void revert();
+  /**
+   *  Gate name for modification (copied from the design if needed)
+   *
+   *  Throws std::out_of_range if the session has no such gate.
+   */
+  Gate& write(std::string const& name);
+  void put(std::string const& name, Gate gate);
+  bool erase(std::string const& name);
+  /**
+   *  Names of all gates of the session in order
+   *
+   */
+  std::vector<std::string> names() const;
+  /**
+   *  Gates copied or created by the session
+   *
+   */
+  inline size_t edited() const { return changed.size(); }
+};
+/**
+ *  Simulation daemon on a Unix-domain stream socket
+ *
+ *  Clients send one request per line and get one reply line per request,
+ *  "ok [result]" or "err message"; requests may be pipelined. Requests:
+ *
+ *    open PATH            work on the design saved at journal PATH
+ *    revert               drop the edits of this session
+ *    list                 names of all gates
+ *    new NAME IN OUT      gate with IN inputs and OUT outputs
+ *    remove NAME
+ *    add NAME in|out S    append a terminal in state S (0, 1 or X)
+ *    states NAME          iotype and state of every terminal, e.g. i0 i1 oX
+ *    get NAME POS
+ *    set NAME POS S
+ *    connect NAME POS
+ *    disconnect NAME POS
+ *    quit
+ *
+ *  One thread runs an epoll loop that accepts clients, reads requests and
+ *  writes replies without blocking. Complete request lines of a session go
+ *  to a worker pool as one batch; a session has at most one batch in
+ *  flight, so its requests run in order while different sessions run in
+ *  parallel. Workers hand results back through an eventfd.
+ */
+class SimulationServer
+{
+  struct Session
+  {
+    int fd;
+    SessionOverlay overlay;
+    std::string in, out;
+    /**
+     *  Requests taken by a worker and its replies
+     *
+     */
+    std::string batch, replies;
+    uint32_t events = 0;
+    bool busy       = false;
+    /**
+     *  Connection broken: drop as soon as no worker holds the session
+     *
+     */
+    bool closing = false;
+    /**
+     *  No more requests: close once the replies are written
+     *
+     */
+    bool eof = false;
+    /**
+     *  Set by the worker that ran quit
+     *
+     */
+    bool quit = false;
+  };
+
+  std::string path;
+  DesignStore store;
+  int listener = -1;
+  int epoll    = -1;
+  int wakeup   = -1;
+  std::unordered_map<int, std::unique_ptr<Session>> sessions;
+  std::vector<std::thread> workers;
+  std::mutex lock;
+  std::condition_variable ready;
+  std::deque<Session*> queued;
+  std::vector<Session*> finished;
+  bool stopping = false;
+  std::atomic<bool> stopRequested{false};
+  std::atomic<uint64_t> served{0};
+
+  void accept();
+  void receive(Session& session);
+  void send(Session& session);
+  void dispatch(Session& session);
+  void complete();
+  void drop(Session& session);
+  void work();
+  void execute(Session& session, std::string const& request);
+
+public:
+  /**
+   *  Largest request line and largest unsent output of a session
+   *
+   */
+  size_t maxLine   = 64 << 10;
+  size_t maxOutput = 1 << 20;
+
+  /**
+   *  Listen on socket path (replacing a stale socket file)
+   *
+   *  threads workers (0 - one per hardware thread)
+   */
+  SimulationServer(std::string socket, size_t threads = 0);
+  SimulationServer(SimulationServer const&) = delete;
+  SimulationServer& operator=(SimulationServer const&) = delete;
+  ~SimulationServer();
+  /**
+   *  Load a design before clients ask for it
+   *
+   */
+  void preload(std::string const& design);
+  /**
+   *  Serve clients until stop()
+   *
+   */
+  void run();
+  /**
+   *  Make run() return (safe from other threads and signal handlers)
+   *
+   */
+  void stop();
+  inline uint64_t requests() const { return served.load(std::memory_order_relaxed); }
+  inline size_t clients() const { return sessions.size(); }
+};
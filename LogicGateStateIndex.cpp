@@ -0,0 +1,129 @@
+#include "LogicGateStateIndex.hpp"
+
+void SparseBitmap::set(uint32_t id)
+{
+  size_t w = id >> 6;
+  if (w >= words.size())
+  {
+    words.resize(w + 1, 0);
+    summary.resize((words.size() + 63) / 64, 0);
+  }
+  words[w] |= 1ULL << (id & 63);
+  summary[w >> 6] |= 1ULL << (w & 63);
+}
+
+void SparseBitmap::reset(uint32_t id)
+{
+  size_t w = id >> 6;
+  if (w >= words.size())
+    return;
+  words[w] &= ~(1ULL << (id & 63));
+  if (!words[w])
+    summary[w >> 6] &= ~(1ULL << (w & 63));
+}
+
+size_t SparseBitmap::count() const
+{
+  size_t res = 0;
+  for (size_t s = 0; s < summary.size(); s++)
+    for (uint64_t top = summary[s]; top; top &= top - 1)
+      res += __builtin_popcountll(words[s * 64 + __builtin_ctzll(top)]);
+  return res;
+}
+
+StateIndex::StateIndex(GateMap const& gates) : map(gates)
+{
+  for (auto const& keyval : map)
+    update(keyval.first);
+}
+
+static uint8_t slotOf(Terminal const& term) { return term.state <= 2 ? term.state * 2 + term.isOutput : 0xff; }
+
+void StateIndex::place(uint32_t id, uint8_t slot)
+{
+  if (slots[id] == slot)
+    return;
+  if (slots[id] != NoSlot)
+    bitmaps[slots[id]].reset(id);
+  if (slot != NoSlot)
+    bitmaps[slot].set(id);
+  slots[id] = slot;
+}
+
+void StateIndex::update(std::string const& name)
+{
+  auto gate = map.find(name);
+  auto ids  = gateIds.find(name);
+  if (gate == map.end())
+  {
+    if (ids == gateIds.end())
+      return;
+    for (auto id : ids->second)
+    {
+      place(id, NoSlot);
+      freeIds.push_back(id);
+    }
+    gateIds.erase(ids);
+    return;
+  }
+  if (ids == gateIds.end())
+    ids = gateIds.emplace(name, std::vector<uint32_t>{}).first;
+  std::vector<uint32_t>& own = ids->second;
+  while (own.size() > gate->second.size())
+  {
+    place(own.back(), NoSlot);
+    freeIds.push_back(own.back());
+    own.pop_back();
+  }
+  while (own.size() < gate->second.size())
+  {
+    uint32_t id;
+    if (freeIds.empty())
+    {
+      id = refs.size();
+      refs.push_back({});
+      slots.push_back(NoSlot);
+    }
+    else
+    {
+      id = freeIds.back();
+      freeIds.pop_back();
+    }
+    refs[id] = {&ids->first, own.size()};
+    own.push_back(id);
+  }
+  for (size_t n = 0; n < own.size(); n++)
+    place(own[n], slotOf(gate->second.terminal(n)));
+}
+
+void StateIndex::update(std::string const& name, size_t n)
+{
+  auto ids = gateIds.find(name);
+  if (ids == gateIds.end() || n >= ids->second.size())
+  {
+    update(name);
+    return;
+  }
+  place(ids->second[n], slotOf(map.at(name).terminal(n)));
+}
+
+std::vector<TerminalRef> StateIndex::find(unsigned short state, TerminalFilter filter) const
+{
+  std::vector<TerminalRef> res;
+  if (state > 2)
+    return res;
+  auto collect = [&](uint32_t id) { res.push_back(refs[id]); };
+  if (filter != TerminalFilter::Outputs)
+    bitmaps[state * 2].forEach(collect);
+  if (filter != TerminalFilter::Inputs)
+    bitmaps[state * 2 + 1].forEach(collect);
+  return res;
+}
+
+size_t StateIndex::count(unsigned short state, TerminalFilter filter) const
+{
+  if (state > 2)
+    return 0;
+  return (filter != TerminalFilter::Outputs ? bitmaps[state * 2].count() : 0) +
+         (filter != TerminalFilter::Inputs ? bitmaps[state * 2 + 1].count() : 0);
+}
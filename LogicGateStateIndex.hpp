@@ -0,0 +1,119 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+/**
+ *  Bitmap with a summary bit per non-empty word
+ *
+ *  Iteration skips empty words 64 at a time, so it costs the number of set
+ *  bits plus size / 4096.
+ */
+class SparseBitmap
+{
+  std::vector<uint64_t> words;
+  std::vector<uint64_t> summary;
+
+public:
+  void set(uint32_t id);
+  void reset(uint32_t id);
+  inline bool test(uint32_t id) const
+  {
+    return (id >> 6) < words.size() && (words[id >> 6] >> (id & 63) & 1);
+  }
+  /**
+   *  Number of set bits (popcount over non-empty words)
+   *
+   */
+  size_t count() const;
+  /**
+   *  Call f(id) for every set bit in increasing order
+   *
+   */
+  template <typename F>
+  void forEach(F f) const
+  {
+    for (size_t s = 0; s < summary.size(); s++)
+      for (uint64_t top = summary[s]; top; top &= top - 1)
+      {
+        size_t w = s * 64 + __builtin_ctzll(top);
+        for (uint64_t bits = words[w]; bits; bits &= bits - 1)
+          f(uint32_t(w * 64 + __builtin_ctzll(bits)));
+      }
+  }
+};
+/**
+ *  Terminal direction filter of a query
+ *
+ */
+enum class TerminalFilter
+{
+  Any,
+  Inputs,
+  Outputs
+};
+/**
+ *  Terminal found by a query
+ *
+ */
+struct TerminalRef
+{
+  std::string const* gate;
+  size_t terminal;
+};
+/**
+ *  Index of session terminals by state
+ *
+ *  Every terminal gets a global id; one bitmap per (state, direction) holds
+ *  the ids currently in that state. Callers report each write through
+ *  update(), which touches only the written terminals.
+ */
+class StateIndex
+{
+  GateMap const& map;
+  /**
+   *  Ids of every indexed gate's terminals
+   *
+   */
+  std::map<std::string, std::vector<uint32_t>> gateIds;
+  std::vector<TerminalRef> refs;
+  /**
+   *  Bitmap holding each id (state * 2 + isOutput), NoSlot if none
+   *
+   */
+  std::vector<uint8_t> slots;
+  std::vector<uint32_t> freeIds;
+  SparseBitmap bitmaps[6];
+
+  static constexpr uint8_t NoSlot = 0xff;
+  void place(uint32_t id, uint8_t slot);
+
+public:
+  explicit StateIndex(GateMap const& gates);
+  /**
+   *  Re-index gate name (created, replaced, grown or removed)
+   *
+   */
+  void update(std::string const& name);
+  /**
+   *  Re-index terminal n of gate name after a state write
+   *
+   */
+  void update(std::string const& name, size_t n);
+  /**
+   *  Terminals in state (0, 1 or 2)
+   *
+   */
+  std::vector<TerminalRef> find(unsigned short state, TerminalFilter filter = TerminalFilter::Any) const;
+  /**
+   *  Number of terminals in state
+   *
+   */
+  size_t count(unsigned short state, TerminalFilter filter = TerminalFilter::Any) const;
+  /**
+   *  Number of indexed terminals
+   *
+   */
+  inline size_t size() const { return refs.size() - freeIds.size(); }
+};
@@ -0,0 +1,194 @@
+#include "LogicGateStats.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace stats
+{
+char const* phaseName(Phase ph)
+{
+  static char const* const names[PhaseCount] = {"input", "evaluate", "propagate", "commit", "output"};
+  return ph < PhaseCount ? names[ph] : "unknown";
+}
+
+#ifdef LOGICGATE_STATS
+namespace
+{
+/**
+ *  Live thread blocks and totals of finished threads
+ *
+ */
+struct Registry
+{
+  std::mutex lock;
+  std::vector<ThreadCounters*> threads;
+  Snapshot retired;
+};
+
+Registry& registry()
+{
+  static Registry reg;
+  return reg;
+}
+
+void accumulate(Snapshot& dst, ThreadCounters const& src)
+{
+  dst.evaluations += src.evaluations.load(std::memory_order_relaxed);
+  dst.state_changes += src.state_changes.load(std::memory_order_relaxed);
+  dst.connects += src.connects.load(std::memory_order_relaxed);
+  dst.disconnects += src.disconnects.load(std::memory_order_relaxed);
+  dst.allocations += src.allocations.load(std::memory_order_relaxed);
+  dst.events_scheduled += src.events_scheduled.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < PhaseCount; i++)
+    dst.phase_ns[i] += src.phase_ns[i].load(std::memory_order_relaxed);
+}
+
+void zero(ThreadCounters& c)
+{
+  c.evaluations.store(0, std::memory_order_relaxed);
+  c.state_changes.store(0, std::memory_order_relaxed);
+  c.connects.store(0, std::memory_order_relaxed);
+  c.disconnects.store(0, std::memory_order_relaxed);
+  c.allocations.store(0, std::memory_order_relaxed);
+  c.events_scheduled.store(0, std::memory_order_relaxed);
+  for (auto& ns : c.phase_ns)
+    ns.store(0, std::memory_order_relaxed);
+}
+} // namespace
+
+ThreadCounters::ThreadCounters()
+{
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> guard(reg.lock);
+  reg.threads.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters()
+{
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> guard(reg.lock);
+  accumulate(reg.retired, *this);
+  reg.threads.erase(std::remove(reg.threads.begin(), reg.threads.end(), this), reg.threads.end());
+}
+
+ThreadCounters& local()
+{
+  thread_local ThreadCounters counters;
+  return counters;
+}
+
+bool enabled() { return true; }
+
+Snapshot collect()
+{
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> guard(reg.lock);
+  Snapshot snap = reg.retired;
+  for (auto* thr : reg.threads)
+    accumulate(snap, *thr);
+  return snap;
+}
+
+void reset()
+{
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> guard(reg.lock);
+  reg.retired = Snapshot{};
+  for (auto* thr : reg.threads)
+    zero(*thr);
+}
+#else
+bool enabled() { return false; }
+
+Snapshot collect() { return Snapshot{}; }
+
+void reset() {}
+#endif
+
+std::ostream& print(std::ostream& stream)
+{
+  if (!enabled())
+    return stream << "Statistics are disabled in this build";
+  Snapshot snap = collect();
+  stream << "Evaluations:      " << snap.evaluations << "\n"
+         << "State changes:    " << snap.state_changes << "\n"
+         << "Connects:         " << snap.connects << "\n"
+         << "Disconnects:      " << snap.disconnects << "\n"
+         << "Allocations:      " << snap.allocations << "\n"
+         << "Events scheduled: " << snap.events_scheduled << "\n"
+         << "Time per phase (us):";
+  for (size_t i = 0; i < PhaseCount; i++)
+    stream << " " << phaseName(Phase(i)) << "=" << snap.phase_ns[i] / 1000;
+  return stream;
+}
+
+std::ostream& dumpJson(std::ostream& stream)
+{
+  Snapshot snap = collect();
+  stream << "{\"enabled\":" << (enabled() ? "true" : "false") << ",\"evaluations\":" << snap.evaluations
+         << ",\"state_changes\":" << snap.state_changes << ",\"connects\":" << snap.connects
+         << ",\"disconnects\":" << snap.disconnects << ",\"allocations\":" << snap.allocations
+         << ",\"events_scheduled\":" << snap.events_scheduled << ",\"phase_ns\":{";
+  for (size_t i = 0; i < PhaseCount; i++)
+    stream << (i ? "," : "") << "\"" << phaseName(Phase(i)) << "\":" << snap.phase_ns[i];
+  return stream << "}}";
+}
+
+#ifdef LOGICGATE_HEAP_CHECK
+namespace
+{
+thread_local unsigned noHeapDepth = 0;
+thread_local uint64_t heapCount   = 0;
+
+void* heapAllocate(size_t size, bool nothrow, size_t align = 0)
+{
+  heapCount++;
+  if (noHeapDepth)
+  {
+    std::fputs("Heap allocation inside a no-heap scope\n", stderr);
+    std::abort();
+  }
+  size = size ? size : 1;
+  void* res = align ? std::aligned_alloc(align, (size + align - 1) / align * align) : std::malloc(size);
+  if (!res && !nothrow)
+    throw std::bad_alloc();
+  return res;
+}
+} // namespace
+
+uint64_t heapAllocations() { return heapCount; }
+
+NoHeapScope::NoHeapScope()
+{
+#ifdef LOGICGATE_STATS
+  // First use of the thread's counters registers them on the heap
+  local();
+#endif
+  noHeapDepth++;
+}
+
+NoHeapScope::~NoHeapScope() { noHeapDepth--; }
+#else
+uint64_t heapAllocations() { return 0; }
+#endif
+} // namespace stats
+
+#ifdef LOGICGATE_HEAP_CHECK
+void* operator new(size_t size) { return stats::heapAllocate(size, false); }
+void* operator new[](size_t size) { return stats::heapAllocate(size, false); }
+void* operator new(size_t size, std::nothrow_t const&) noexcept { return stats::heapAllocate(size, true); }
+void* operator new[](size_t size, std::nothrow_t const&) noexcept { return stats::heapAllocate(size, true); }
+void* operator new(size_t size, std::align_val_t align) { return stats::heapAllocate(size, false, size_t(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return stats::heapAllocate(size, false, size_t(align)); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+#endif
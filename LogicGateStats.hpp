@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+/**
+ *  Hot-path counters of the gate and simulation layers
+ *
+ *  Every thread increments its own block of counters (no shared cache lines,
+ *  no locked instructions), blocks are merged only when statistics are read.
+ *  Build without LOGICGATE_STATS to remove counters entirely.
+ */
+namespace stats
+{
+/**
+ *  Simulation phases measured by PhaseTimer
+ *
+ *  Propagate covers event-driven and demand-driven re-evaluation (fault
+ *  simulation cones, DemandEvaluator), Commit the register updates of a
+ *  clock cycle.
+ */
+enum Phase
+{
+  Input,
+  Evaluate,
+  Propagate,
+  Commit,
+  Output,
+  PhaseCount
+};
+/**
+ *  Printable phase name
+ *
+ *  ph phase
+ *  char const*
+ */
+char const* phaseName(Phase ph);
+/**
+ *  Merged value of all counters
+ *
+ */
+struct Snapshot
+{
+  uint64_t evaluations      = 0;
+  uint64_t state_changes    = 0;
+  uint64_t connects         = 0;
+  uint64_t disconnects      = 0;
+  uint64_t allocations      = 0;
+  /**
+   *  Gates queued for re-evaluation by propagation
+   *
+   */
+  uint64_t events_scheduled = 0;
+  /**
+   *  Time spent per phase (nanoseconds)
+   *
+   */
+  uint64_t phase_ns[PhaseCount] = {};
+};
+/**
+ *  true if counters are compiled in
+ *
+ */
+bool enabled();
+/**
+ *  Merge counters of all live and finished threads
+ *
+ *  Snapshot
+ */
+Snapshot collect();
+/**
+ *  Zero counters of all threads
+ *
+ */
+void reset();
+/**
+ *  Formatted output of merged counters
+ *
+ *  stream
+ *  std::ostream&
+ */
+std::ostream& print(std::ostream& stream);
+/**
+ *  JSON dump of merged counters
+ *
+ *  stream
+ *  std::ostream&
+ */
+std::ostream& dumpJson(std::ostream& stream);
+
+#ifdef LOGICGATE_STATS
+/**
+ *  Counters owned by one thread
+ *
+ *  Only the owner writes, so increments are plain load/store pairs; atomics
+ *  keep concurrent reads by collect() well-defined.
+ */
+struct ThreadCounters
+{
+  std::atomic<uint64_t> evaluations{0};
+  std::atomic<uint64_t> state_changes{0};
+  std::atomic<uint64_t> connects{0};
+  std::atomic<uint64_t> disconnects{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> events_scheduled{0};
+  std::atomic<uint64_t> phase_ns[PhaseCount]{};
+
+  ThreadCounters();
+  ~ThreadCounters();
+};
+/**
+ *  Counters of calling thread
+ *
+ *  ThreadCounters&
+ */
+ThreadCounters& local();
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1)
+{
+  counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+/**
+ *  Adds elapsed time of its scope to a phase
+ *
+ */
+class PhaseTimer
+{
+  Phase phase;
+  std::chrono::steady_clock::time_point start;
+
+public:
+  explicit PhaseTimer(Phase ph) : phase{ph}, start{std::chrono::steady_clock::now()} {}
+  ~PhaseTimer()
+  {
+    bump(local().phase_ns[phase],
+         std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+  PhaseTimer(PhaseTimer const&) = delete;
+  PhaseTimer& operator=(PhaseTimer const&) = delete;
+};
+#endif
+/**
+ *  Heap allocations through operator new by the calling thread (counted in
+ *  LOGICGATE_HEAP_CHECK builds only)
+ *
+ */
+uint64_t heapAllocations();
+#ifdef LOGICGATE_HEAP_CHECK
+/**
+ *  Debug hook: any heap allocation by the calling thread while a scope is
+ *  alive aborts the program
+ *
+ *  Global operator new is replaced in LOGICGATE_HEAP_CHECK builds.
+ */
+class NoHeapScope
+{
+public:
+  NoHeapScope();
+  ~NoHeapScope();
+  NoHeapScope(NoHeapScope const&) = delete;
+  NoHeapScope& operator=(NoHeapScope const&) = delete;
+};
+#endif
+} // namespace stats
+
+#define LG_STAT_CONCAT_(a, b) a##b
+#define LG_STAT_CONCAT(a, b) LG_STAT_CONCAT_(a, b)
+#ifdef LOGICGATE_HEAP_CHECK
+#define LG_NO_HEAP() ::stats::NoHeapScope LG_STAT_CONCAT(lg_no_heap_, __LINE__)
+#else
+#define LG_NO_HEAP() ((void)0)
+#endif
+
+#ifdef LOGICGATE_STATS
+#define LG_STAT_ADD(counter, n) ::stats::bump(::stats::local().counter, (n))
+#define LG_STAT_INC(counter) LG_STAT_ADD(counter, 1)
+#define LG_STAT_PHASE(ph) ::stats::PhaseTimer LG_STAT_CONCAT(lg_phase_timer_, __LINE__)(::stats::ph)
+#else
+#define LG_STAT_ADD(counter, n) ((void)0)
+#define LG_STAT_INC(counter) ((void)0)
+#define LG_STAT_PHASE(ph) ((void)0)
+#endif
@@ -0,0 +1,255 @@
+#include "LogicGateStdLogic.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LG_HAVE_SSSE3_KERNEL
+#endif
+
+static const char Chars[] = "UX01ZWLH-";
+
+char toChar(StdLogic value) { return size_t(value) < 9 ? Chars[size_t(value)] : '?'; }
+
+StdLogic fromChar(char ch)
+{
+  char const* pos = std::strchr(Chars, ch);
+  if (!ch || !pos)
+    throw std::runtime_error("Not a std_logic value");
+  return StdLogic(pos - Chars);
+}
+
+std::ostream& operator<<(std::ostream& stream, StdLogic value) { return stream << toChar(value); }
+
+StdLogicTable::StdLogicTable(char const* text)
+{
+  std::memset(packed, 0, sizeof(packed));
+  // Columns past '-' never match a valid operand; X keeps them harmless
+  std::memset(rows, uint8_t(StdLogic::X), sizeof(rows));
+  for (size_t n = 0; n < 81; n++)
+  {
+    uint8_t value = uint8_t(fromChar(text[n]));
+    packed[n >> 1] |= value << ((n & 1) * 4);
+    rows[n / 9][n % 9] = value;
+  }
+}
+
+// Tables of the std_logic_1164 package body
+const StdLogicTable ResolutionTable("UUUUUUUUU"
+                                    "UXXXXXXXX"
+                                    "UX0X0000X"
+                                    "UXX11111X"
+                                    "UX01ZWLHX"
+                                    "UX01WWWWX"
+                                    "UX01LWLWX"
+                                    "UX01HWWHX"
+                                    "UXXXXXXXX");
+const StdLogicTable AndTable("UU0UUU0UU"
+                             "UX0XXX0XX"
+                             "000000000"
+                             "UX01XX01X"
+                             "UX0XXX0XX"
+                             "UX0XXX0XX"
+                             "000000000"
+                             "UX01XX01X"
+                             "UX0XXX0XX");
+const StdLogicTable OrTable("UUU1UUU1U"
+                            "UXX1XXX1X"
+                            "UX01XX01X"
+                            "111111111"
+                            "UXX1XXX1X"
+                            "UXX1XXX1X"
+                            "UX01XX01X"
+                            "111111111"
+                            "UXX1XXX1X");
+const StdLogicTable XorTable("UUUUUUUUU"
+                             "UXXXXXXXX"
+                             "UX01XX01X"
+                             "UX10XX10X"
+                             "UXXXXXXXX"
+                             "UXXXXXXXX"
+                             "UX01XX01X"
+                             "UX10XX10X"
+                             "UXXXXXXXX");
+alignas(16) static const uint8_t NotRow[16] = {0, 1, 3, 2, 1, 1, 3, 2, 1, 1, 1, 1, 1, 1, 1, 1};
+
+StdLogic stdNot(StdLogic value) { return StdLogic(NotRow[size_t(value) & 0xf]); }
+
+StdLogic resolve(StdLogic const* drivers, size_t n)
+{
+  StdLogic res = StdLogic::Z;
+  for (size_t i = 0; i < n; i++)
+    res = ResolutionTable(res, drivers[i]);
+  return res;
+}
+
+StdLogicVector::StdLogicVector(size_t n, StdLogic value)
+    : bytes((n + 1) / 2, uint8_t(value) * 0x11), _size(n)
+{
+}
+
+void StdLogicVector::fromPlanes(size_t offset, Planes planes)
+{
+  // Pairs of lanes map to one byte: 2 bits of (val, unk) -> two nibbles
+  static const uint8_t codes[4] = {uint8_t(StdLogic::Zero), uint8_t(StdLogic::One), uint8_t(StdLogic::X),
+                                   uint8_t(StdLogic::X)};
+  size_t end = std::min<size_t>(64, _size - offset);
+  for (size_t i = 0; i < end; i += 2)
+  {
+    uint8_t lo = codes[(planes.val >> i & 1) | (planes.unk >> i & 1) << 1];
+    uint8_t hi = i + 1 < end ? codes[(planes.val >> (i + 1) & 1) | (planes.unk >> (i + 1) & 1) << 1] : 0;
+    bytes[(offset + i) >> 1] = lo | hi << 4;
+  }
+}
+
+Planes StdLogicVector::toPlanes(size_t offset) const
+{
+  // Per value: is it a 1 (1, H), is it known (0, 1, L, H)
+  static const uint8_t one[16]   = {0, 0, 0, 1, 0, 0, 0, 1};
+  static const uint8_t known[16] = {0, 0, 1, 1, 0, 0, 1, 1};
+  Planes res{0, ~0ULL};
+  size_t end = std::min<size_t>(64, _size - offset);
+  for (size_t i = 0; i < end; i++)
+  {
+    uint8_t v = uint8_t((*this)[offset + i]);
+    res.val |= uint64_t(one[v] & known[v]) << i;
+    res.unk &= ~(uint64_t(known[v]) << i);
+  }
+  return res;
+}
+
+static void applyScalar(StdLogicTable const& table, uint8_t const* a, uint8_t const* b, uint8_t* out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    StdLogic lo = table(StdLogic(a[i] & 0xf), StdLogic(b[i] & 0xf));
+    StdLogic hi = table(StdLogic(a[i] >> 4), StdLogic(b[i] >> 4));
+    out[i]      = uint8_t(lo) | uint8_t(hi) << 4;
+  }
+}
+
+#ifdef LG_HAVE_SSSE3_KERNEL
+/**
+ *  32 values per step: for every row value k, shuffle row k by the second
+ *  operand and keep the lanes whose first operand equals k
+ *
+ */
+__attribute__((target("ssse3"))) static size_t applySsse3(StdLogicTable const& table, uint8_t const* a,
+                                                          uint8_t const* b, uint8_t* out, size_t n)
+{
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  __m128i rows[9];
+  for (size_t k = 0; k < 9; k++)
+    rows[k] = _mm_load_si128(reinterpret_cast<__m128i const*>(table.row(StdLogic(k))));
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i va  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+    __m128i vb  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+    __m128i alo = _mm_and_si128(va, nibble), ahi = _mm_and_si128(_mm_srli_epi16(va, 4), nibble);
+    __m128i blo = _mm_and_si128(vb, nibble), bhi = _mm_and_si128(_mm_srli_epi16(vb, 4), nibble);
+    __m128i rlo = _mm_setzero_si128(), rhi = _mm_setzero_si128();
+    for (size_t k = 0; k < 9; k++)
+    {
+      __m128i key = _mm_set1_epi8(char(k));
+      rlo         = _mm_or_si128(rlo, _mm_and_si128(_mm_cmpeq_epi8(alo, key), _mm_shuffle_epi8(rows[k], blo)));
+      rhi         = _mm_or_si128(rhi, _mm_and_si128(_mm_cmpeq_epi8(ahi, key), _mm_shuffle_epi8(rows[k], bhi)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(rlo, _mm_slli_epi16(rhi, 4)));
+  }
+  return i;
+}
+
+__attribute__((target("ssse3"))) static size_t notSsse3(uint8_t const* a, uint8_t* out, size_t n)
+{
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i row    = _mm_load_si128(reinterpret_cast<__m128i const*>(NotRow));
+  size_t i             = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+    __m128i lo = _mm_shuffle_epi8(row, _mm_and_si128(va, nibble));
+    __m128i hi = _mm_shuffle_epi8(row, _mm_and_si128(_mm_srli_epi16(va, 4), nibble));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(lo, _mm_slli_epi16(hi, 4)));
+  }
+  return i;
+}
+
+static const bool UseSsse3 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+}();
+#endif
+
+void apply(StdLogicTable const& table, StdLogicVector const& a, StdLogicVector const& b, StdLogicVector& out)
+{
+  if (a.size() != b.size() || a.size() != out.size())
+    throw std::runtime_error("Vector sizes differ");
+  size_t n = a.byteSize(), done = 0;
+#ifdef LG_HAVE_SSSE3_KERNEL
+  if (UseSsse3)
+    done = applySsse3(table, a.data(), b.data(), out.data(), n);
+#endif
+  applyScalar(table, a.data() + done, b.data() + done, out.data() + done, n - done);
+}
+
+void applyNot(StdLogicVector const& a, StdLogicVector& out)
+{
+  if (a.size() != out.size())
+    throw std::runtime_error("Vector sizes differ");
+  size_t n = a.byteSize(), done = 0;
+#ifdef LG_HAVE_SSSE3_KERNEL
+  if (UseSsse3)
+    done = notSsse3(a.data(), out.data(), n);
+#endif
+  for (size_t i = done; i < n; i++)
+    out.data()[i] = NotRow[a.data()[i] & 0xf] | NotRow[a.data()[i] >> 4] << 4;
+}
+
+void evaluateStdLogic(Netlist const& nl, std::vector<StdLogicVector>& values)
+{
+  if (values.size() != nl.nets())
+    throw std::runtime_error("Wrong number of nets");
+  size_t patterns = values.empty() ? 0 : values[0].size();
+  StdLogicVector acc(patterns);
+  unsigned short in[GateType::MaxTerminals];
+  for (auto g : nl.order())
+  {
+    GateType const& t = nl.type(g);
+    auto input        = [&](size_t k) -> StdLogicVector const& { return values[nl.pin(g, t.inputTerminal(k))]; };
+    GateFunction fn   = t.function();
+    if (fn == GateFunction::Lut)
+    {
+      for (size_t k = 0; k < t.outputs(); k++)
+      {
+        StdLogicVector& out = values[nl.pin(g, t.outputTerminal(k))];
+        for (size_t p = 0; p < patterns; p++)
+        {
+          for (size_t i = 0; i < t.inputs(); i++)
+            in[i] = toState(input(i)[p]);
+          out.set(p, fromState(t.evaluate(in, k)));
+        }
+      }
+      continue;
+    }
+    StdLogicTable const& table = fn == GateFunction::Or || fn == GateFunction::Nor     ? OrTable
+                                 : fn == GateFunction::Xor || fn == GateFunction::Xnor ? XorTable
+                                                                                       : AndTable;
+    if (!t.inputs())
+    {
+      for (size_t k = 0; k < t.outputs(); k++)
+        values[nl.pin(g, t.outputTerminal(k))] = StdLogicVector(patterns, StdLogic::X);
+      continue;
+    }
+    // Buffer and Not reduce to x op x, which also strips strengths
+    acc = input(0);
+    for (size_t i = 1; i < t.inputs(); i++)
+      apply(table, acc, input(i), acc);
+    if (t.inputs() == 1)
+      apply(AndTable, acc, acc, acc);
+    if (fn == GateFunction::Not || fn == GateFunction::Nand || fn == GateFunction::Nor || fn == GateFunction::Xnor)
+      applyNot(acc, acc);
+    for (size_t k = 0; k < t.outputs(); k++)
+      values[nl.pin(g, t.outputTerminal(k))] = acc;
+  }
+}
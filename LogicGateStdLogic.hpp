@@ -0,0 +1,140 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+/**
+ *  IEEE 1164 std_ulogic value (declaration order of the standard)
+ *
+ */
+enum class StdLogic : uint8_t
+{
+  U,
+  X,
+  Zero,
+  One,
+  Z,
+  W,
+  L,
+  H,
+  DontCare
+};
+/**
+ *  Character of value ('U', 'X', '0', '1', 'Z', 'W', 'L', 'H', '-')
+ *
+ */
+char toChar(StdLogic value);
+/**
+ *  Value of character (throws on anything else)
+ *
+ */
+StdLogic fromChar(char ch);
+/**
+ *  Value of 3-valued state (0, 1, 2 - X)
+ *
+ */
+inline StdLogic fromState(unsigned short state)
+{
+  return state == 0 ? StdLogic::Zero : state == 1 ? StdLogic::One : StdLogic::X;
+}
+/**
+ *  3-valued state of value (strength dropped: L - 0, H - 1, rest - X)
+ *
+ */
+inline unsigned short toState(StdLogic value)
+{
+  return value == StdLogic::Zero || value == StdLogic::L ? 0 : value == StdLogic::One || value == StdLogic::H ? 1 : 2;
+}
+std::ostream& operator<<(std::ostream& stream, StdLogic value);
+/**
+ *  9x9 table of a binary operator on StdLogic
+ *
+ *  Stored as 81 nibbles packed two per byte; each row is also kept
+ *  expanded to 16 bytes for the shuffle kernel.
+ */
+class StdLogicTable
+{
+  uint8_t packed[41];
+  alignas(16) uint8_t rows[9][16];
+
+public:
+  /**
+   *  Construct a table from its rows as characters
+   *
+   *  text 81 characters, row-major, first operand selects the row
+   */
+  explicit StdLogicTable(char const* text);
+  inline StdLogic operator()(StdLogic a, StdLogic b) const
+  {
+    size_t n = size_t(a) * 9 + size_t(b);
+    return StdLogic(packed[n >> 1] >> ((n & 1) * 4) & 0xf);
+  }
+  inline uint8_t const* row(StdLogic a) const { return rows[size_t(a)]; }
+};
+/**
+ *  Wired resolution of two drivers of one net
+ *
+ */
+extern const StdLogicTable ResolutionTable;
+extern const StdLogicTable AndTable;
+extern const StdLogicTable OrTable;
+extern const StdLogicTable XorTable;
+StdLogic stdNot(StdLogic value);
+/**
+ *  Resolved value of a net with several drivers (Z if none)
+ *
+ */
+StdLogic resolve(StdLogic const* drivers, size_t n);
+/**
+ *  StdLogic values packed two per byte (even index in the low nibble)
+ *
+ */
+class StdLogicVector
+{
+  std::vector<uint8_t> bytes;
+  size_t _size = 0;
+
+public:
+  StdLogicVector() = default;
+  explicit StdLogicVector(size_t n, StdLogic value = StdLogic::U);
+  inline size_t size() const { return _size; }
+  inline StdLogic operator[](size_t i) const { return StdLogic(bytes[i >> 1] >> ((i & 1) * 4) & 0xf); }
+  inline void set(size_t i, StdLogic value)
+  {
+    uint8_t shift = (i & 1) * 4;
+    bytes[i >> 1] = (bytes[i >> 1] & ~(0xf << shift)) | uint8_t(value) << shift;
+  }
+  inline uint8_t const* data() const { return bytes.data(); }
+  inline uint8_t* data() { return bytes.data(); }
+  inline size_t byteSize() const { return bytes.size(); }
+  /**
+   *  Store 64 lanes of 3-valued planes at offset (multiple of 64)
+   *
+   */
+  void fromPlanes(size_t offset, Planes planes);
+  /**
+   *  3-valued planes of 64 values at offset (multiple of 64)
+   *
+   */
+  Planes toPlanes(size_t offset) const;
+};
+/**
+ *  out[i] = table(a[i], b[i]) on whole vectors (SSSE3 shuffles when available)
+ *
+ *  Vectors must have equal size; out may alias a or b.
+ */
+void apply(StdLogicTable const& table, StdLogicVector const& a, StdLogicVector const& b, StdLogicVector& out);
+/**
+ *  out[i] = not a[i]
+ *
+ */
+void applyNot(StdLogicVector const& a, StdLogicVector& out);
+/**
+ *  Evaluate netlist in nine-valued logic, many patterns per net
+ *
+ *  Lookup-table gates go through the 3-valued tables (strengths dropped).
+ *
+ *  nl netlist
+ *  values value vector of every net (primary inputs set by caller, equal sizes)
+ */
+void evaluateStdLogic(Netlist const& nl, std::vector<StdLogicVector>& values);
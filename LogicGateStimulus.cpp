@@ -0,0 +1,114 @@
+#include "LogicGateStimulus.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+Philox::Philox(uint64_t seed) : key{uint32_t(seed), uint32_t(seed >> 32)} {}
+
+void Philox::operator()(uint32_t ctr[4]) const
+{
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int round = 0; round < 10; round++)
+  {
+    uint64_t p0 = uint64_t(0xD2511F53u) * ctr[0];
+    uint64_t p1 = uint64_t(0xCD9E8D57u) * ctr[2];
+    uint32_t c0 = uint32_t(p1 >> 32) ^ ctr[1] ^ k0;
+    uint32_t c2 = uint32_t(p0 >> 32) ^ ctr[3] ^ k1;
+    ctr[0]      = c0;
+    ctr[1]      = uint32_t(p1);
+    ctr[2]      = c2;
+    ctr[3]      = uint32_t(p0);
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+}
+
+void Philox::words(uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint64_t& w0, uint64_t& w1) const
+{
+  uint32_t ctr[4] = {a, b, c, d};
+  (*this)(ctr);
+  w0 = uint64_t(ctr[0]) | uint64_t(ctr[1]) << 32;
+  w1 = uint64_t(ctr[2]) | uint64_t(ctr[3]) << 32;
+}
+
+StimulusGenerator::StimulusGenerator(uint64_t seed, size_t inputs)
+    : rng(seed), _inputs(inputs), bias(inputs, 128), xrate(inputs, 0)
+{
+}
+
+static uint16_t fixedPoint(double p)
+{
+  if (p < 0 || p > 1)
+    throw std::runtime_error("Probability must be within [0, 1]");
+  return uint16_t(p * 256 + 0.5);
+}
+
+void StimulusGenerator::setBias(size_t input, double high)
+{
+  if (input >= _inputs)
+    throw std::out_of_range("");
+  bias[input] = fixedPoint(high);
+}
+
+void StimulusGenerator::setXRate(size_t input, double x)
+{
+  if (input >= _inputs)
+    throw std::out_of_range("");
+  xrate[input] = fixedPoint(x);
+}
+
+uint64_t StimulusGenerator::biased(uint64_t block, uint32_t input, uint32_t stream, uint16_t p) const
+{
+  if (p == 0)
+    return 0;
+  if (p >= 256)
+    return ~0ULL;
+  // Binary expansion of p from the lowest set bit: each step halves and
+  // optionally adds 1/2, so P(bit) == p/256 with one fresh word per step
+  int bit      = __builtin_ctz(p);
+  uint64_t res = 0, w[2];
+  for (int k = bit, n = 0; k < 8; k++, n++)
+  {
+    if ((n & 1) == 0)
+      rng.words(uint32_t(block), uint32_t(block >> 32), input, stream << 8 | n, w[0], w[1]);
+    res = ((p >> k) & 1) ? (res | w[n & 1]) : (res & w[n & 1]);
+  }
+  return res;
+}
+
+void StimulusGenerator::block(uint64_t index, Planes* out) const
+{
+  for (uint32_t i = 0; i < _inputs; i++)
+  {
+    uint64_t unk = biased(index, i, 1, xrate[i]);
+    out[i]       = {biased(index, i, 0, bias[i]) & ~unk, unk};
+  }
+}
+
+void StimulusGenerator::generate(uint64_t first, uint64_t count, Planes* out, unsigned threads) const
+{
+  if (!threads)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = unsigned(std::min<uint64_t>(threads, std::max<uint64_t>(count, 1)));
+  auto work = [=](unsigned t) {
+    uint64_t from = count * t / threads, to = count * (t + 1) / threads;
+    for (uint64_t b = from; b < to; b++)
+      block(first + b, out + b * _inputs);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++)
+    pool.emplace_back(work, t);
+  work(0);
+  for (auto& thr : pool)
+    thr.join();
+}
+
+std::vector<unsigned short> StimulusGenerator::vector(uint64_t index) const
+{
+  std::vector<Planes> planes(_inputs);
+  block(index / 64, planes.data());
+  std::vector<unsigned short> res;
+  for (auto const& p : planes)
+    res.push_back(p.lane(index % 64));
+  return res;
+}
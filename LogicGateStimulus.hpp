@@ -0,0 +1,94 @@
+#pragma once
+#include "LogicGateType.hpp"
+#include <cstdint>
+#include <vector>
+/**
+ *  Counter-based random generator (Philox4x32-10)
+ *
+ *  Output is a pure function of key and counter, so any value can be
+ *  recomputed without replaying the sequence before it.
+ */
+struct Philox
+{
+  uint32_t key[2];
+
+  explicit Philox(uint64_t seed);
+  /**
+   *  Four random words for a counter
+   *
+   *  ctr counter (modified into the result)
+   */
+  void operator()(uint32_t ctr[4]) const;
+  /**
+   *  Two random 64-bit words for (a, b, c, d)
+   *
+   */
+  void words(uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint64_t& w0, uint64_t& w1) const;
+};
+/**
+ *  Random 0/1/X input vectors, 64 per block, generated straight into Planes
+ *
+ *  Vector n is a function of (seed, n) only: it is bit `n % 64` of block
+ *  `n / 64`, whatever the number of threads or the order of generation.
+ *  Per-input probabilities have 8-bit resolution.
+ */
+class StimulusGenerator
+{
+  Philox rng;
+  size_t _inputs;
+  /**
+   *  Probability of High (of 256) for every input
+   *
+   */
+  std::vector<uint16_t> bias;
+  /**
+   *  Probability of X (of 256) for every input
+   *
+   */
+  std::vector<uint16_t> xrate;
+
+  uint64_t biased(uint64_t block, uint32_t input, uint32_t stream, uint16_t p) const;
+
+public:
+  /**
+   *  Construct a new StimulusGenerator object (unbiased, no X)
+   *
+   *  seed stimulus seed
+   *  inputs number of inputs
+   */
+  StimulusGenerator(uint64_t seed, size_t inputs);
+  inline size_t inputs() const { return _inputs; }
+  /**
+   *  Set probability of High for input
+   *
+   */
+  void setBias(size_t input, double high);
+  /**
+   *  Set probability of X for input
+   *
+   */
+  void setXRate(size_t input, double x);
+  /**
+   *  Generate 64 vectors
+   *
+   *  index block number (vectors 64*index .. 64*index+63)
+   *  out planes of every input
+   */
+  void block(uint64_t index, Planes* out) const;
+  /**
+   *  Generate consecutive blocks on several threads
+   *
+   *  first first block number
+   *  count number of blocks
+   *  out count*inputs() planes, block-major
+   *  threads number of threads (0 - hardware concurrency)
+   */
+  void generate(uint64_t first, uint64_t count, Planes* out, unsigned threads = 0) const;
+  /**
+   *  Replay one vector
+   *
+   *  index vector number
+   *  std::vector<unsigned short> state of every input
+   */
+  std::vector<unsigned short> vector(uint64_t index) const;
+};
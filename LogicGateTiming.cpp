@@ -0,0 +1,401 @@
+#include "LogicGateTiming.hpp"
+#include "LogicGateLevels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+static const double Never = std::numeric_limits<double>::infinity();
+
+TimingAnalysis::TimingAnalysis(Netlist const& netlist, double period) : nl(netlist), _period(period), pinOffsets{0}
+{
+  resize();
+}
+
+TimingAnalysis::TimingAnalysis(IncrementalLevels const& levels, double period)
+    : nl(levels.netlist()), incremental(&levels), _period(period), pinOffsets{0}
+{
+  resize();
+}
+
+uint32_t TimingAnalysis::levelOf(uint32_t g) const { return incremental ? incremental->level(g) : nl.level(g); }
+
+IdRange TimingAnalysis::readers(NetId net) const
+{
+  if (!incremental)
+    return nl.fanout(net);
+  std::vector<uint32_t> const& gates = incremental->readersOf(net);
+  return {gates.data(), gates.data() + gates.size()};
+}
+
+void TimingAnalysis::resize()
+{
+  size_t oldGates = gateDelays.size();
+  for (uint32_t g = oldGates; g < nl.gates(); g++)
+  {
+    gateDelays.push_back(1);
+    pinOffsets.push_back(pinOffsets.back() + nl.type(g).size());
+    queued.push_back(0);
+  }
+  pinDelays.resize(pinOffsets.back(), 0);
+  for (NetId net = arrivals.size(); net < nl.nets(); net++)
+  {
+    arrivals.push_back(0);
+    requireds.push_back(Never);
+    primaryOutput.push_back(0);
+  }
+  for (size_t i = inputArrival.size(); i < nl.inputs().size(); i++)
+  {
+    inputArrival.push_back(0);
+    arrivals[nl.inputs()[i]] = 0;
+    if (analyzed)
+      touchReaders(nl.inputs()[i]);
+  }
+  for (; outputsSeen < nl.outputs().size(); outputsSeen++)
+  {
+    primaryOutput[nl.outputs()[outputsSeen]] = 1;
+    if (analyzed)
+      touchDriver(nl.outputs()[outputsSeen]);
+  }
+  if (analyzed)
+    for (uint32_t g = oldGates; g < nl.gates(); g++)
+      gateChanged(g);
+}
+
+bool TimingAnalysis::arrive(uint32_t g)
+{
+  GateType const& t = nl.type(g);
+  double latest     = 0;
+  for (size_t k = 0; k < t.inputs(); k++)
+  {
+    size_t n = t.inputTerminal(k);
+    latest   = std::max(latest, arrivals[nl.pin(g, n)] + pinDelays[pinOffsets[g] + n]);
+  }
+  bool changed = false;
+  for (size_t k = 0; k < t.outputs(); k++)
+  {
+    size_t n    = t.outputTerminal(k);
+    double time = latest + gateDelays[g] + pinDelays[pinOffsets[g] + n];
+    NetId net   = nl.pin(g, n);
+    changed     = changed || arrivals[net] != time;
+    arrivals[net] = time;
+  }
+  return changed;
+}
+
+double TimingAnalysis::pinRequired(uint32_t g, size_t n) const
+{
+  GateType const& t = nl.type(g);
+  double earliest   = Never;
+  for (size_t k = 0; k < t.outputs(); k++)
+  {
+    size_t o = t.outputTerminal(k);
+    earliest = std::min(earliest, requireds[nl.pin(g, o)] - pinDelays[pinOffsets[g] + o]);
+  }
+  return earliest - gateDelays[g] - pinDelays[pinOffsets[g] + n];
+}
+
+double TimingAnalysis::netRequired(NetId net) const
+{
+  double res = primaryOutput[net] ? _period : Never;
+  for (auto reader : readers(net))
+  {
+    GateType const& t = nl.type(reader);
+    for (size_t k = 0; k < t.inputs(); k++)
+      if (nl.pin(reader, t.inputTerminal(k)) == net)
+        res = std::min(res, pinRequired(reader, t.inputTerminal(k)));
+  }
+  return res;
+}
+
+bool TimingAnalysis::require(uint32_t g)
+{
+  GateType const& t = nl.type(g);
+  bool changed      = false;
+  for (size_t k = 0; k < t.outputs(); k++)
+  {
+    NetId net     = nl.pin(g, t.outputTerminal(k));
+    double time   = netRequired(net);
+    changed       = changed || requireds[net] != time;
+    requireds[net] = time;
+  }
+  return changed;
+}
+
+void TimingAnalysis::touchReaders(NetId net)
+{
+  for (auto reader : readers(net))
+    if (!(queued[reader] & 1))
+    {
+      queued[reader] |= 1;
+      forward.push_back(reader);
+      std::push_heap(forward.begin(), forward.end(),
+                     [this](uint32_t a, uint32_t b) { return levelOf(a) > levelOf(b); });
+    }
+}
+
+void TimingAnalysis::touchDriver(NetId net)
+{
+  uint32_t g = nl.driver(net);
+  if (g == NoGate)
+    sources.push_back(net);
+  else if (!(queued[g] & 2))
+  {
+    queued[g] |= 2;
+    backward.push_back(g);
+    std::push_heap(backward.begin(), backward.end(),
+                   [this](uint32_t a, uint32_t b) { return levelOf(b) > levelOf(a); });
+  }
+}
+
+void TimingAnalysis::touchInputs(uint32_t g)
+{
+  GateType const& t = nl.type(g);
+  for (size_t k = 0; k < t.inputs(); k++)
+    touchDriver(nl.pin(g, t.inputTerminal(k)));
+}
+
+void TimingAnalysis::setGateDelay(uint32_t g, double delay)
+{
+  gateDelays.at(g) = delay;
+  gateChanged(g);
+}
+
+void TimingAnalysis::setPinDelay(uint32_t g, size_t n, double delay)
+{
+  if (g >= gateDelays.size() || n >= nl.type(g).size())
+    throw std::out_of_range("");
+  pinDelays[pinOffsets[g] + n] = delay;
+  gateChanged(g);
+}
+
+void TimingAnalysis::setInputArrival(size_t i, double time)
+{
+  NetId net       = nl.inputs().at(i);
+  inputArrival[i] = time;
+  arrivals[net]   = time;
+  if (analyzed)
+    touchReaders(net);
+}
+
+void TimingAnalysis::setPeriod(double period)
+{
+  _period = period;
+  if (analyzed)
+    for (auto net : nl.outputs())
+      touchDriver(net);
+}
+
+void TimingAnalysis::gateChanged(uint32_t g, std::vector<NetId> const& oldNets)
+{
+  if (!analyzed)
+    return;
+  if (g >= gateDelays.size())
+  {
+    resize();
+    return;
+  }
+  if (!(queued[g] & 1))
+  {
+    queued[g] |= 1;
+    forward.push_back(g);
+    std::push_heap(forward.begin(), forward.end(), [this](uint32_t a, uint32_t b) { return levelOf(a) > levelOf(b); });
+  }
+  touchInputs(g);
+  GateType const& t = nl.type(g);
+  for (size_t k = 0; k < t.outputs(); k++)
+    touchDriver(nl.pin(g, t.outputTerminal(k)));
+  for (auto net : oldNets)
+  {
+    // A net that lost its driver reverts to an undriven arrival
+    if (nl.driver(net) == NoGate)
+    {
+      auto input   = std::find(nl.inputs().begin(), nl.inputs().end(), net);
+      arrivals[net] = input == nl.inputs().end() ? 0 : inputArrival[input - nl.inputs().begin()];
+      touchReaders(net);
+    }
+    touchDriver(net);
+  }
+}
+
+namespace
+{
+struct SpinBarrier
+{
+  std::atomic<unsigned> count{0};
+  std::atomic<unsigned> generation{0};
+  unsigned parties;
+
+  void wait()
+  {
+    unsigned gen = generation.load(std::memory_order_acquire);
+    if (count.fetch_add(1, std::memory_order_acq_rel) + 1 == parties)
+    {
+      count.store(0, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+      return;
+    }
+    while (generation.load(std::memory_order_acquire) == gen)
+      std::this_thread::yield();
+  }
+};
+} // namespace
+
+/**
+ *  Run f on every gate level by level (reverse - deepest first); gates of
+ *  one level are split into contiguous chunks across threads
+ *
+ */
+template <typename F>
+static void sweep(std::vector<std::vector<uint32_t>> const& byLevel, bool reverse, unsigned threads, F f)
+{
+  auto level = [&](size_t i) -> std::vector<uint32_t> const& {
+    return byLevel[reverse ? byLevel.size() - 1 - i : i];
+  };
+  if (threads <= 1)
+  {
+    for (size_t i = 0; i < byLevel.size(); i++)
+      for (auto g : level(i))
+        f(g);
+    return;
+  }
+  SpinBarrier barrier;
+  barrier.parties = threads;
+  auto work       = [&](unsigned id) {
+    for (size_t i = 0; i < byLevel.size(); i++)
+    {
+      auto const& gates = level(i);
+      size_t first = gates.size() * id / threads, last = gates.size() * (id + 1) / threads;
+      for (size_t j = first; j < last; j++)
+        f(gates[j]);
+      barrier.wait();
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned id = 1; id < threads; id++)
+    pool.emplace_back(work, id);
+  work(0);
+  for (auto& th : pool)
+    th.join();
+}
+
+void TimingAnalysis::analyze()
+{
+  resize();
+  std::vector<std::vector<uint32_t>> byLevel;
+  if (incremental)
+    for (size_t l = 0; l < incremental->depth(); l++)
+      byLevel.push_back(incremental->gatesAt(l));
+  else
+  {
+    byLevel.resize(nl.depth());
+    for (auto g : nl.order())
+      byLevel[nl.level(g)].push_back(g);
+  }
+  unsigned count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+  // Threads only pay off when levels are wide
+  if (nl.gates() < 65536 || nl.gates() / std::max<size_t>(1, byLevel.size()) < 1024)
+    count = 1;
+
+  for (NetId net = 0; net < nl.nets(); net++)
+    if (nl.driver(net) == NoGate)
+      arrivals[net] = 0;
+  for (size_t i = 0; i < nl.inputs().size(); i++)
+    arrivals[nl.inputs()[i]] = inputArrival[i];
+  sweep(byLevel, false, count, [this](uint32_t g) { arrive(g); });
+  sweep(byLevel, true, count, [this](uint32_t g) { require(g); });
+  for (NetId net = 0; net < nl.nets(); net++)
+    if (nl.driver(net) == NoGate)
+      requireds[net] = netRequired(net);
+
+  forward.clear();
+  backward.clear();
+  sources.clear();
+  std::fill(queued.begin(), queued.end(), 0);
+  analyzed = true;
+}
+
+size_t TimingAnalysis::update()
+{
+  if (!analyzed)
+  {
+    analyze();
+    return nl.gates();
+  }
+  resize();
+  size_t count = 0;
+  // Heaps were built against the levels of the time of the edit; rebuild
+  auto byLevel = [this](uint32_t a, uint32_t b) { return levelOf(a) > levelOf(b); };
+  std::make_heap(forward.begin(), forward.end(), byLevel);
+  while (!forward.empty())
+  {
+    std::pop_heap(forward.begin(), forward.end(), byLevel);
+    uint32_t g = forward.back();
+    forward.pop_back();
+    queued[g] &= ~1;
+    count++;
+    if (arrive(g))
+    {
+      GateType const& t = nl.type(g);
+      for (size_t k = 0; k < t.outputs(); k++)
+        touchReaders(nl.pin(g, t.outputTerminal(k)));
+    }
+  }
+  auto deeper = [this](uint32_t a, uint32_t b) { return levelOf(b) > levelOf(a); };
+  std::make_heap(backward.begin(), backward.end(), deeper);
+  while (!backward.empty())
+  {
+    std::pop_heap(backward.begin(), backward.end(), deeper);
+    uint32_t g = backward.back();
+    backward.pop_back();
+    queued[g] &= ~2;
+    count++;
+    if (require(g))
+      touchInputs(g);
+  }
+  for (auto net : sources)
+    requireds[net] = netRequired(net);
+  sources.clear();
+  return count;
+}
+
+double TimingAnalysis::worstSlack() const
+{
+  double res = Never;
+  for (auto net : nl.outputs())
+    res = std::min(res, slack(net));
+  return res;
+}
+
+std::vector<uint32_t> TimingAnalysis::criticalPath() const
+{
+  std::vector<uint32_t> path;
+  if (nl.outputs().empty())
+    return path;
+  NetId net = nl.outputs()[0];
+  for (auto out : nl.outputs())
+    if (slack(out) < slack(net))
+      net = out;
+  for (uint32_t g = nl.driver(net); g != NoGate; g = nl.driver(net))
+  {
+    path.push_back(g);
+    GateType const& t = nl.type(g);
+    if (!t.inputs())
+      break;
+    // Follow the input that sets the arrival time
+    double latest = -Never;
+    for (size_t k = 0; k < t.inputs(); k++)
+    {
+      size_t n    = t.inputTerminal(k);
+      double time = arrivals[nl.pin(g, n)] + pinDelays[pinOffsets[g] + n];
+      if (time > latest)
+      {
+        latest = time;
+        net    = nl.pin(g, n);
+      }
+    }
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "LogicGateNetlist.hpp"
+#include <cstdint>
+#include <vector>
+class IncrementalLevels;
+/**
+ *  Static timing analysis of a netlist
+ *
+ *  Delay of the arc from input terminal k to output terminal o of gate g is
+ *  pinDelay(g, k) + gateDelay(g) + pinDelay(g, o). Arrival times flow from
+ *  primary inputs, required times from primary outputs (the period) back
+ *  through the fanout; slack = required - arrival.
+ *
+ *  analyze() sweeps level by level (levels split across threads on large
+ *  designs). Afterwards every edit only marks the touched gates, and
+ *  update() re-propagates arrival forward and required backward through the
+ *  affected cones, stopping wherever a time does not change.
+ *
+ *  Levels and fanout come from the netlist, which relevelizes the whole
+ *  design on the first query after a connection edit; only delay edits
+ *  stay local then. Built on IncrementalLevels, the analysis reads its
+ *  levels and readers instead, so connection edits made through it cost
+ *  the affected cones as well.
+ */
+class TimingAnalysis
+{
+  Netlist const& nl;
+  IncrementalLevels const* incremental = nullptr;
+  double _period;
+  std::vector<double> gateDelays;
+  std::vector<uint32_t> pinOffsets;
+  std::vector<double> pinDelays;
+  std::vector<double> inputArrival;
+  std::vector<char> primaryOutput;
+  size_t outputsSeen = 0;
+  std::vector<double> arrivals;
+  std::vector<double> requireds;
+  bool analyzed = false;
+  /**
+   *  Gates whose output arrival / required times must be recomputed and
+   *  undriven nets whose required time must be recomputed
+   *
+   */
+  std::vector<uint32_t> forward;
+  std::vector<uint32_t> backward;
+  std::vector<NetId> sources;
+  /**
+   *  Bit 0 - in forward, bit 1 - in backward
+   *
+   */
+  std::vector<char> queued;
+
+  void resize();
+  uint32_t levelOf(uint32_t g) const;
+  IdRange readers(NetId net) const;
+  bool arrive(uint32_t g);
+  bool require(uint32_t g);
+  double netRequired(NetId net) const;
+  double pinRequired(uint32_t g, size_t n) const;
+  void touchInputs(uint32_t g);
+  void touchReaders(NetId net);
+  void touchDriver(NetId net);
+
+public:
+  /**
+   *  Worker threads of full sweeps (0 - hardware concurrency)
+   *
+   */
+  unsigned threads = 0;
+
+  /**
+   *  Construct with unit gate delays, zero pin delays and input arrivals
+   *
+   *  netlist analysed netlist (may be edited between updates)
+   *  period required time at every primary output
+   */
+  TimingAnalysis(Netlist const& netlist, double period);
+  /**
+   *  Analyse the netlist of levels, edited through levels between updates
+   *
+   */
+  TimingAnalysis(IncrementalLevels const& levels, double period);
+  inline double gateDelay(uint32_t g) const { return gateDelays.at(g); }
+  inline double pinDelay(uint32_t g, size_t n) const { return pinDelays.at(pinOffsets.at(g) + n); }
+  inline double period() const { return _period; }
+  void setGateDelay(uint32_t g, double delay);
+  /**
+   *  Extra delay of terminal n of gate g (input or output)
+   *
+   */
+  void setPinDelay(uint32_t g, size_t n, double delay);
+  /**
+   *  Arrival time of primary input i
+   *
+   */
+  void setInputArrival(size_t i, double time);
+  void setPeriod(double period);
+  /**
+   *  Report that gate g was added or its pins were rebound
+   *
+   *  oldNets nets its terminals were bound to before (if rebound)
+   */
+  void gateChanged(uint32_t g, std::vector<NetId> const& oldNets = {});
+  /**
+   *  Full levelized sweep
+   *
+   */
+  void analyze();
+  /**
+   *  Incremental propagation of pending edits (full sweep the first time)
+   *
+   *  size_t gates recomputed
+   */
+  size_t update();
+  inline double arrival(NetId net) const { return arrivals.at(net); }
+  inline double required(NetId net) const { return requireds.at(net); }
+  inline double slack(NetId net) const { return requireds.at(net) - arrivals.at(net); }
+  /**
+   *  Smallest slack over the primary outputs
+   *
+   */
+  double worstSlack() const;
+  /**
+   *  Gates on the path ending at the worst output, from the input side
+   *
+   */
+  std::vector<uint32_t> criticalPath() const;
+};
@@ -0,0 +1,219 @@
+#include "LogicGateTrace.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static const uint32_t NoChunk = UINT32_MAX;
+/**
+ *  Room every chunk keeps free for a run record (two 10-byte varints)
+ *
+ */
+static const uint32_t RunReserve = 20;
+
+static uint32_t varintSize(uint64_t value)
+{
+  uint32_t res = 1;
+  for (; value >= 0x80; value >>= 7)
+    res++;
+  return res;
+}
+
+static uint64_t readVarint(uint8_t const* bytes, uint32_t& pos)
+{
+  uint64_t res = 0;
+  for (unsigned shift = 0;; shift += 7)
+  {
+    uint8_t b = bytes[pos++];
+    res |= uint64_t(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return res;
+  }
+}
+
+TraceRecorder::TraceRecorder(Netlist const& netlist, size_t memory, size_t chunk) : nl(netlist), chunkBytes(chunk)
+{
+  if (chunk < 64)
+    throw std::runtime_error("Trace chunks must hold at least 64 bytes");
+  size_t count = std::min<size_t>(memory / chunk, NoChunk - 1);
+  if (!count)
+    throw std::runtime_error("Trace memory is smaller than one chunk");
+  chunks.resize(count);
+  data.resize(count * chunk);
+}
+
+void TraceRecorder::append(uint32_t c, uint64_t value)
+{
+  uint8_t* out = data.data() + size_t(c) * chunkBytes + chunks[c].used;
+  for (; value >= 0x80; value >>= 7)
+  {
+    *out++ = uint8_t(value) | 0x80;
+    chunks[c].used++;
+  }
+  *out = uint8_t(value);
+  chunks[c].used++;
+}
+
+uint32_t TraceRecorder::allocate(NetId net)
+{
+  uint32_t c = cursor;
+  cursor     = (cursor + 1) % chunks.size();
+  if (allocated < chunks.size())
+    allocated++;
+  else
+  {
+    // Chunks are recycled in the order they were handed out, so the victim
+    // is always the oldest chunk of its net
+    Track& owner = tracks[chunks[c].net];
+    owner.head   = chunks[c].next;
+    if (owner.tail == c)
+    {
+      owner.tail = NoChunk;
+      owner.run  = 0;
+    }
+  }
+  Track& track = tracks[net];
+  chunks[c]    = {track.lastTime, net, NoChunk, 0, current[net]};
+  if (track.tail == NoChunk)
+    track.head = c;
+  else
+    chunks[track.tail].next = c;
+  track.tail = c;
+  return c;
+}
+
+void TraceRecorder::flush(Track& track)
+{
+  if (!track.run)
+    return;
+  append(track.tail, track.lastDelta << 2 | 3);
+  append(track.tail, track.run);
+  track.run = 0;
+}
+
+void TraceRecorder::change(NetId net, unsigned char state, uint64_t time)
+{
+  Track& track   = tracks[net];
+  uint64_t delta = time - track.lastTime;
+  // Returning to the previous state after the same delta extends a run
+  if (track.tail != NoChunk && delta == track.lastDelta && state == track.before)
+    track.run++;
+  else
+  {
+    flush(track);
+    uint64_t record = delta << 2 | state;
+    if (track.tail == NoChunk || chunks[track.tail].used + varintSize(record) + RunReserve > chunkBytes)
+      allocate(net);
+    append(track.tail, record);
+    track.lastDelta = delta;
+  }
+  track.before   = current[net];
+  current[net]   = state;
+  track.lastTime = time;
+}
+
+template <typename F>
+void TraceRecorder::record(uint64_t time, F value)
+{
+  if (!started)
+  {
+    tracks.assign(nl.nets(), {NoChunk, NoChunk, time, 0, 0, 0});
+    current.resize(nl.nets());
+    for (NetId net = 0; net < nl.nets(); net++)
+      current[net] = tracks[net].before = value(net);
+    started = true;
+    last    = time;
+    return;
+  }
+  if (time <= last)
+    throw std::runtime_error("Trace time must increase");
+  if (nl.nets() != tracks.size())
+    throw std::runtime_error("Traced netlist changed");
+  for (NetId net = 0; net < tracks.size(); net++)
+  {
+    unsigned char state = value(net);
+    if (state != current[net])
+      change(net, state, time);
+  }
+  last = time;
+}
+
+static inline unsigned char laneState(Planes p, unsigned lane)
+{
+  return (p.unk >> lane) & 1 ? 2 : (p.val >> lane) & 1;
+}
+
+void TraceRecorder::sample(uint64_t time, Planes const* values)
+{
+  record(time, [&](NetId net) { return laneState(values[net], lane); });
+}
+
+void TraceRecorder::sample(CycleSimulator const& sim)
+{
+  record(sim.cycle(), [&](NetId net) { return laneState(sim.net(net), lane); });
+}
+
+uint64_t TraceRecorder::since(NetId net) const
+{
+  if (!started || net >= tracks.size())
+    throw std::out_of_range("");
+  Track const& track = tracks[net];
+  return track.head == NoChunk ? track.lastTime : chunks[track.head].start;
+}
+
+/**
+ *  Advance over count toggles of period delta up to time
+ *
+ *  bool true if the run passes time (state is final)
+ */
+static bool skipRun(uint64_t& at, uint64_t delta, uint64_t count, uint64_t time, unsigned char& state,
+                    unsigned char& before)
+{
+  uint64_t steps = std::min(count, (time - at) / delta);
+  if (steps & 1)
+    std::swap(state, before);
+  at += steps * delta;
+  return steps < count;
+}
+
+unsigned short TraceRecorder::state(NetId net, uint64_t time) const
+{
+  if (time < since(net) || time > last)
+    throw std::out_of_range("");
+  Track const& track = tracks[net];
+  if (track.head == NoChunk)
+    return current[net];
+  uint32_t c = track.head;
+  while (chunks[c].next != NoChunk && chunks[chunks[c].next].start <= time)
+    c = chunks[c].next;
+
+  Chunk const& chunk   = chunks[c];
+  uint8_t const* bytes = data.data() + size_t(c) * chunkBytes;
+  unsigned char state = chunk.state, before = chunk.state;
+  uint64_t at         = chunk.start;
+  for (uint32_t pos = 0; pos < chunk.used;)
+  {
+    uint64_t record = readVarint(bytes, pos);
+    uint64_t delta  = record >> 2;
+    if ((record & 3) == 3)
+    {
+      if (skipRun(at, delta, readVarint(bytes, pos), time, state, before))
+        return state;
+      continue;
+    }
+    if (at + delta > time)
+      return state;
+    at += delta;
+    before = state;
+    state  = record & 3;
+  }
+  if (c == track.tail && track.run)
+    skipRun(at, track.lastDelta, track.run, time, state, before);
+  return state;
+}
+
+size_t TraceRecorder::size() const
+{
+  size_t res = 0;
+  for (uint32_t c = 0; c < allocated; c++)
+    res += chunks[c].used;
+  return res;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "LogicGateSequential.hpp"
+#include <cstdint>
+#include <vector>
+/**
+ *  Always-on flight recorder of net value changes
+ *
+ *  Keeps the recent history of every net of a netlist (one lane of the
+ *  Planes values) in a fixed pool of chunks. Each chunk belongs to one net
+ *  and holds its changes as varint records of (time delta, new state); a net
+ *  toggling between two states with a constant period (clocks, counter bits)
+ *  collapses into a single run record. Chunks are handed out in ring order,
+ *  so when the pool is full the oldest chunk of all is recycled and memory
+ *  never exceeds the configured budget.
+ *
+ *  sample() costs one compare per net; only changed nets are encoded.
+ */
+class TraceRecorder
+{
+  struct Chunk
+  {
+    uint64_t start;
+    NetId net;
+    uint32_t next;
+    uint32_t used;
+    /**
+     *  State of the net at start (before the first record)
+     *
+     */
+    unsigned char state;
+  };
+  /**
+   *  Writer state of one net
+   *
+   */
+  struct Track
+  {
+    uint32_t head;
+    uint32_t tail;
+    uint64_t lastTime;
+    uint64_t lastDelta;
+    /**
+     *  Toggles pending in a run record not yet written to tail
+     *
+     */
+    uint64_t run;
+    /**
+     *  State before the last change
+     *
+     */
+    unsigned char before;
+  };
+  Netlist const& nl;
+  size_t chunkBytes;
+  std::vector<Chunk> chunks;
+  std::vector<uint8_t> data;
+  /**
+   *  Next chunk to hand out; every chunk below allocated is in use
+   *
+   */
+  uint32_t cursor    = 0;
+  uint32_t allocated = 0;
+  std::vector<Track> tracks;
+  std::vector<unsigned char> current;
+  uint64_t last = 0;
+  bool started  = false;
+
+  void change(NetId net, unsigned char state, uint64_t time);
+  void flush(Track& track);
+  void append(uint32_t c, uint64_t value);
+  uint32_t allocate(NetId net);
+  template <typename F>
+  void record(uint64_t time, F value);
+
+public:
+  /**
+   *  Lane of the Planes values that is recorded (set before the first sample)
+   *
+   */
+  unsigned lane = 0;
+
+  /**
+   *  Construct an empty recorder
+   *
+   *  netlist recorded netlist (net count must not change)
+   *  memory bytes of the chunk pool
+   *  chunk bytes of one chunk (at least 64)
+   */
+  TraceRecorder(Netlist const& netlist, size_t memory, size_t chunk = 256);
+  /**
+   *  Record values of all nets at time (strictly increasing)
+   *
+   */
+  void sample(uint64_t time, Planes const* values);
+  /**
+   *  Record the nets of a simulator at its current cycle
+   *
+   */
+  void sample(CycleSimulator const& sim);
+  /**
+   *  State of net at time (0, 1 or 2)
+   *
+   *  Throws std::out_of_range if time is outside [since(net), latest()].
+   */
+  unsigned short state(NetId net, uint64_t time) const;
+  /**
+   *  State of terminal n of gate g at time
+   *
+   */
+  inline unsigned short state(uint32_t g, size_t n, uint64_t time) const { return state(nl.pin(g, n), time); }
+  /**
+   *  Oldest time the history of net still covers
+   *
+   */
+  uint64_t since(NetId net) const;
+  /**
+   *  Time of the last sample
+   *
+   */
+  inline uint64_t latest() const { return last; }
+  /**
+   *  Bytes of the chunk pool (the memory bound)
+   *
+   */
+  inline size_t capacity() const { return data.size(); }
+  /**
+   *  Encoded bytes currently held
+   *
+   */
+  size_t size() const;
+};
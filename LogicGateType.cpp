@@ -0,0 +1,364 @@
+#include "LogicGateType.hpp"
+#include "LogicGateStats.hpp"
+#include <sstream>
+#include <stdexcept>
+
+Planes Planes::broadcast(unsigned short state)
+{
+  if (state == 2)
+    return {0, ~0ULL};
+  return {state ? ~0ULL : 0, 0};
+}
+
+unsigned short Planes::lane(size_t n) const
+{
+  if ((unk >> n) & 1)
+    return 2;
+  return (val >> n) & 1;
+}
+
+void Planes::setLane(size_t n, unsigned short state)
+{
+  uint64_t bit = 1ULL << n;
+  val          = (state == 1) ? (val | bit) : (val & ~bit);
+  unk          = (state == 2) ? (unk | bit) : (unk & ~bit);
+}
+
+static std::vector<bool> directionsOf(size_t in, size_t out)
+{
+  std::vector<bool> dirs(in, false);
+  dirs.resize(in + out, true);
+  return dirs;
+}
+
+static uint32_t maskOf(std::vector<bool> const& directions)
+{
+  if (directions.size() > GateType::MaxTerminals)
+    throw std::runtime_error("Too many terminals");
+  uint32_t mask = 0;
+  for (size_t i = 0; i < directions.size(); i++)
+    if (directions[i])
+      mask |= 1u << i;
+  return mask;
+}
+
+GateType::GateType(std::string name, GateFunction func, size_t in, size_t out)
+    : GateType(std::move(name), func, directionsOf(in, out))
+{
+}
+
+GateType::GateType(std::string name, GateFunction func, std::vector<bool> const& directions)
+    : _name(std::move(name)), _func(func), _outputs(maskOf(directions)), _size(directions.size())
+{
+  if (func == GateFunction::Lut)
+    throw std::runtime_error("Lookup table is required");
+  build();
+}
+
+GateType::GateType(std::string name, std::vector<bool> const& directions, std::vector<uint64_t> tables)
+    : _name(std::move(name)), _func(GateFunction::Lut), _outputs(maskOf(directions)), _size(directions.size()),
+      _tables(std::move(tables))
+{
+  build();
+}
+
+void GateType::build()
+{
+  _order.clear();
+  _slot.assign(_size, 0);
+  for (size_t i = 0; i < _size; i++)
+    if (!isOutput(i))
+      _order.push_back(i);
+  _in = _order.size();
+  for (size_t i = 0; i < _size; i++)
+    if (isOutput(i))
+      _order.push_back(i);
+  for (size_t k = 0; k < _size; k++)
+    _slot[_order[k]] = k;
+
+  if ((_func == GateFunction::Buffer || _func == GateFunction::Not) && _in != 1)
+    throw std::runtime_error("Buffer and invertor have exactly one input");
+  if (_func == GateFunction::Lut && (_in > MaxLutInputs || _tables.size() != outputs()))
+    throw std::runtime_error("Lookup table does not match terminals");
+  if (_in > MaxLutInputs)
+    return;
+
+  if (_func != GateFunction::Lut)
+  {
+    // Truth table from the primitive: lane m holds minterm m
+    std::vector<Planes> in(_in);
+    for (size_t i = 0; i < _in; i++)
+    {
+      in[i] = {0, 0};
+      for (size_t m = 0; m < (1u << _in); m++)
+        in[i].val |= uint64_t((m >> i) & 1) << m;
+    }
+    uint64_t used = (_in == 6) ? ~0ULL : ((1ULL << (1u << _in)) - 1);
+    _tables.assign(outputs(), evaluate(in.data()).val & used);
+  }
+
+  _eval.assign(size_t(1) << (2 * _in), 0);
+  std::vector<unsigned short> states(_in);
+  for (uint32_t word = 0; word < _eval.size(); word++)
+  {
+    for (size_t i = 0; i < _in; i++)
+    {
+      unsigned short code = (word >> (2 * i)) & 3;
+      states[i]           = code == 3 ? 2 : code;
+    }
+    for (size_t k = 0; k < outputs(); k++)
+      _eval[word] |= uint32_t(evaluate(states.data(), k)) << (2 * (_in + k));
+  }
+}
+
+Planes GateType::evaluate(Planes const* in, size_t k) const
+{
+  uint64_t one = 0, zero = 0;
+  switch (_func)
+  {
+  case GateFunction::Buffer:
+  case GateFunction::Not:
+    one  = in[0].val & ~in[0].unk;
+    zero = ~in[0].val & ~in[0].unk;
+    break;
+  case GateFunction::And:
+  case GateFunction::Nand:
+    one = ~0ULL;
+    for (size_t i = 0; i < _in; i++)
+    {
+      one &= in[i].val & ~in[i].unk;
+      zero |= ~in[i].val & ~in[i].unk;
+    }
+    break;
+  case GateFunction::Or:
+  case GateFunction::Nor:
+    zero = ~0ULL;
+    for (size_t i = 0; i < _in; i++)
+    {
+      one |= in[i].val & ~in[i].unk;
+      zero &= ~in[i].val & ~in[i].unk;
+    }
+    break;
+  case GateFunction::Xor:
+  case GateFunction::Xnor:
+  {
+    uint64_t val = 0, unk = 0;
+    for (size_t i = 0; i < _in; i++)
+    {
+      val ^= in[i].val;
+      unk |= in[i].unk;
+    }
+    one  = val & ~unk;
+    zero = ~val & ~unk;
+    break;
+  }
+  case GateFunction::Lut:
+  {
+    // A lane is 1 (0) if every completion of its X inputs hits a 1 (0) minterm
+    uint64_t can1 = 0, can0 = 0;
+    for (size_t m = 0; m < (1u << _in); m++)
+    {
+      uint64_t term = ~0ULL;
+      for (size_t i = 0; i < _in; i++)
+        term &= ((m >> i) & 1) ? (in[i].val | in[i].unk) : (~in[i].val | in[i].unk);
+      if ((_tables[k] >> m) & 1)
+        can1 |= term;
+      else
+        can0 |= term;
+    }
+    one  = can1 & ~can0;
+    zero = can0 & ~can1;
+    break;
+  }
+  }
+  if (_func == GateFunction::Not || _func == GateFunction::Nand || _func == GateFunction::Nor ||
+      _func == GateFunction::Xnor)
+    std::swap(one, zero);
+  return {one, ~(one | zero)};
+}
+
+unsigned short GateType::evaluate(unsigned short const* in, size_t k) const
+{
+  std::vector<Planes> planes(_in);
+  for (size_t i = 0; i < _in; i++)
+    planes[i] = Planes::broadcast(in[i]);
+  return evaluate(planes.data(), k).lane(0);
+}
+
+std::string GateType::key() const
+{
+  std::ostringstream res;
+  res << int(_func) << ':' << _size << ':' << _outputs;
+  if (_func == GateFunction::Lut)
+    for (auto t : _tables)
+      res << ':' << std::hex << t;
+  return res.str();
+}
+
+uint32_t GateTypeLibrary::intern(GateType const& type)
+{
+  auto it = byKey.find(type.key());
+  if (it != byKey.end())
+    return it->second;
+  types.emplace_back(new GateType(type));
+  return byKey[type.key()] = types.size() - 1;
+}
+
+GatePool::GatePool(GateTypeLibrary const& library) : lib(library) {}
+
+GatePool::Block& GatePool::block(GateRef ref)
+{
+  if (ref.type >= blocks.size() || ref.index >= blocks[ref.type].states.size())
+    throw std::out_of_range("");
+  return blocks[ref.type];
+}
+
+GatePool::Block const& GatePool::block(GateRef ref) const
+{
+  if (ref.type >= blocks.size() || ref.index >= blocks[ref.type].states.size())
+    throw std::out_of_range("");
+  return blocks[ref.type];
+}
+
+GateRef GatePool::add(uint32_t type)
+{
+  if (type >= lib.size())
+    throw std::out_of_range("");
+  if (blocks.size() < lib.size())
+    blocks.resize(lib.size());
+  blocks[type].states.push_back(0);
+  blocks[type].conns.push_back(0);
+  return {type, uint32_t(blocks[type].states.size() - 1)};
+}
+
+GateRef GatePool::add(uint32_t type, Gate const& gate)
+{
+  GateType const& t = lib[type];
+  if (gate.size() != t.size())
+    throw std::runtime_error("Gate does not match type");
+  for (size_t i = 0; i < t.size(); i++)
+    if (gate.terminal(i).isOutput != t.isOutput(i))
+      throw std::runtime_error("Gate does not match type");
+  GateRef ref = add(type);
+  for (size_t i = 0; i < t.size(); i++)
+  {
+    Terminal const& term = gate.terminal(i);
+    blocks[type].states[ref.index] |= uint32_t(term.state < 3 ? term.state : 2) << (2 * t.slot(i));
+    blocks[type].conns[ref.index] |= uint32_t(term.conn_num & 3) << (2 * t.slot(i));
+  }
+  return ref;
+}
+
+size_t GatePool::count(uint32_t type) const { return type < blocks.size() ? blocks[type].states.size() : 0; }
+
+size_t GatePool::count() const
+{
+  size_t res = 0;
+  for (auto const& b : blocks)
+    res += b.states.size();
+  return res;
+}
+
+unsigned short GatePool::getTerminalState(GateRef ref, size_t n) const
+{
+  Block const& b = block(ref);
+  if (n >= lib[ref.type].size())
+    throw std::out_of_range("");
+  unsigned short code = (b.states[ref.index] >> (2 * lib[ref.type].slot(n))) & 3;
+  return code == 3 ? 2 : code;
+}
+
+unsigned short GatePool::setTerminalState(GateRef ref, size_t n, unsigned short val)
+{
+  Block& b = block(ref);
+  if (n >= lib[ref.type].size())
+    throw std::out_of_range("");
+  if (val < 3)
+  {
+    size_t shift = 2 * lib[ref.type].slot(n);
+    uint32_t old = b.states[ref.index];
+    uint32_t now = (old & ~(3u << shift)) | (uint32_t(val) << shift);
+    if (now != old)
+      LG_STAT_INC(state_changes);
+    b.states[ref.index] = now;
+  }
+  return getTerminalState(ref, n);
+}
+
+unsigned short GatePool::connections(GateRef ref, size_t n) const
+{
+  Block const& b = block(ref);
+  if (n >= lib[ref.type].size())
+    throw std::out_of_range("");
+  return (b.conns[ref.index] >> (2 * lib[ref.type].slot(n))) & 3;
+}
+
+void GatePool::connect(GateRef ref, size_t n)
+{
+  unsigned short conns = connections(ref, n);
+  if (conns >= (lib[ref.type].isOutput(n) ? 3 : 1))
+    throw std::runtime_error("Number of connections can't be increased!");
+  blocks[ref.type].conns[ref.index] += 1u << (2 * lib[ref.type].slot(n));
+  LG_STAT_INC(connects);
+}
+
+void GatePool::disconnect(GateRef ref, size_t n)
+{
+  if (connections(ref, n) == 0)
+    throw std::runtime_error("Can not disconnect! No connections");
+  blocks[ref.type].conns[ref.index] -= 1u << (2 * lib[ref.type].slot(n));
+  LG_STAT_INC(disconnects);
+}
+
+void GatePool::evaluate(uint32_t type)
+{
+  if (type >= blocks.size())
+    return;
+  GateType const& t = lib[type];
+  auto& states      = blocks[type].states;
+  LG_STAT_ADD(evaluations, states.size());
+  if (t.tabulated())
+  {
+    uint32_t inMask = uint32_t((1ULL << (2 * t.inputs())) - 1);
+    for (auto& s : states)
+      s = (s & inMask) | t.lookup(s & inMask);
+    return;
+  }
+  std::vector<unsigned short> in(t.inputs());
+  for (auto& s : states)
+  {
+    for (size_t i = 0; i < t.inputs(); i++)
+    {
+      unsigned short code = (s >> (2 * i)) & 3;
+      in[i]               = code == 3 ? 2 : code;
+    }
+    uint32_t res = s & uint32_t((1ULL << (2 * t.inputs())) - 1);
+    for (size_t k = 0; k < t.outputs(); k++)
+      res |= uint32_t(t.evaluate(in.data(), k)) << (2 * (t.inputs() + k));
+    s = res;
+  }
+}
+
+void GatePool::evaluate()
+{
+  LG_STAT_PHASE(Evaluate);
+  for (uint32_t type = 0; type < blocks.size(); type++)
+    evaluate(type);
+}
+
+Gate GatePool::toGate(GateRef ref) const
+{
+  GateType const& t = lib[ref.type];
+  std::vector<Terminal> terms;
+  for (size_t i = 0; i < t.size(); i++)
+    terms.push_back({t.isOutput(i), connections(ref, i), getTerminalState(ref, i)});
+  return Gate(std::move(terms));
+}
+
+size_t GatePool::bytes() const
+{
+  size_t res = blocks.capacity() * sizeof(Block);
+  for (auto const& b : blocks)
+    res += (b.states.capacity() + b.conns.capacity()) * sizeof(uint32_t);
+  return res;
+}
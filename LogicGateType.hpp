@@ -0,0 +1,287 @@
+#pragma once
+#include "LogicGateDynamic.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+/**
+ *  Logic function of a gate type
+ *
+ */
+enum class GateFunction : unsigned char
+{
+  Buffer,
+  Not,
+  And,
+  Nand,
+  Or,
+  Nor,
+  Xor,
+  Xnor,
+  Lut
+};
+/**
+ *  64 terminal states packed as two bit planes
+ *
+ *  (val, unk): (0, 0) - Low, (1, 0) - High, (0, 1) - Undefined
+ */
+struct Planes
+{
+  uint64_t val;
+  uint64_t unk;
+
+  /**
+   *  All 64 lanes set to state (0, 1 or 2)
+   *
+   */
+  static Planes broadcast(unsigned short state);
+  /**
+   *  State of one lane (0, 1 or 2)
+   *
+   */
+  unsigned short lane(size_t n) const;
+  /**
+   *  Set state of one lane
+   *
+   */
+  void setLane(size_t n, unsigned short state);
+  bool operator==(Planes const& rhs) const { return val == rhs.val && unk == rhs.unk; }
+  bool operator!=(Planes const& rhs) const { return !(*this == rhs); }
+};
+/**
+ *  Shared immutable description of a gate shape
+ *
+ *  Holds terminal directions, the logic function and the evaluation table;
+ *  every output terminal computes its own function of all input terminals.
+ *  Instances of the type (GatePool) store only packed states, inputs first.
+ */
+class GateType
+{
+public:
+  static constexpr size_t MaxTerminals = 16;
+  static constexpr size_t MaxLutInputs = 6;
+
+private:
+  std::string _name;
+  GateFunction _func;
+  /**
+   *  Bit n is set if terminal n is output
+   *
+   */
+  uint32_t _outputs;
+  size_t _size;
+  /**
+   *  Terminal indices in packed order (inputs first)
+   *
+   */
+  std::vector<unsigned char> _order;
+  /**
+   *  Packed position of each terminal
+   *
+   */
+  std::vector<unsigned char> _slot;
+  size_t _in;
+  /**
+   *  Truth table of every output (bit m - value for input minterm m)
+   *
+   */
+  std::vector<uint64_t> _tables;
+  /**
+   *  Packed output states for every packed input word (4^in entries)
+   *
+   */
+  std::vector<uint32_t> _eval;
+
+  void build();
+
+public:
+  /**
+   *  Construct a new GateType object (inputs first)
+   *
+   *  name type name
+   *  func logic function
+   *  in number of input terminals
+   *  out number of output terminals
+   */
+  GateType(std::string name, GateFunction func, size_t in, size_t out);
+  /**
+   *  Construct a new GateType object
+   *
+   *  name type name
+   *  func logic function
+   *  directions isOutput flag of every terminal
+   */
+  GateType(std::string name, GateFunction func, std::vector<bool> const& directions);
+  /**
+   *  Construct a new lookup-table GateType object
+   *
+   *  name type name
+   *  directions isOutput flag of every terminal
+   *  tables truth table of every output
+   */
+  GateType(std::string name, std::vector<bool> const& directions, std::vector<uint64_t> tables);
+
+  inline std::string const& name() const { return _name; }
+  inline GateFunction function() const { return _func; }
+  inline size_t size() const { return _size; }
+  inline size_t inputs() const { return _in; }
+  inline size_t outputs() const { return _size - _in; }
+  inline bool isOutput(size_t n) const { return (_outputs >> n) & 1; }
+  /**
+   *  Packed position of terminal n
+   *
+   */
+  inline size_t slot(size_t n) const { return _slot[n]; }
+  /**
+   *  Terminal index of k-th input
+   *
+   */
+  inline size_t inputTerminal(size_t k) const { return _order[k]; }
+  /**
+   *  Terminal index of k-th output
+   *
+   */
+  inline size_t outputTerminal(size_t k) const { return _order[_in + k]; }
+  /**
+   *  Truth table of k-th output (only if inputs() <= MaxLutInputs)
+   *
+   */
+  inline uint64_t table(size_t k = 0) const { return _tables[k]; }
+  /**
+   *  true if packed evaluation table is available
+   *
+   */
+  inline bool tabulated() const { return !_eval.empty(); }
+  /**
+   *  Output states for packed input states (requires tabulated())
+   *
+   *  inputs 2 bits per input, packed order
+   *  uint32_t outputs at their packed positions
+   */
+  inline uint32_t lookup(uint32_t inputs) const { return _eval[inputs]; }
+  /**
+   *  Evaluate k-th output on 64 lanes at once
+   *
+   *  in planes of every input, packed order
+   *  k output number
+   *  Planes
+   */
+  Planes evaluate(Planes const* in, size_t k = 0) const;
+  /**
+   *  Evaluate k-th output for one set of input states
+   *
+   *  in states of every input (0, 1 or 2), packed order
+   *  k output number
+   *  unsigned short
+   */
+  unsigned short evaluate(unsigned short const* in, size_t k = 0) const;
+  /**
+   *  Identity of the shape and function (used for interning)
+   *
+   */
+  std::string key() const;
+};
+/**
+ *  Owner of interned gate types
+ *
+ */
+class GateTypeLibrary
+{
+  std::vector<std::unique_ptr<GateType>> types;
+  std::map<std::string, uint32_t> byKey;
+
+public:
+  /**
+   *  Intern gate type, equal shapes share one id
+   *
+   *  type type to be added
+   *  uint32_t type id
+   */
+  uint32_t intern(GateType const& type);
+  inline GateType const& operator[](uint32_t id) const { return *types[id]; }
+  inline size_t size() const { return types.size(); }
+};
+/**
+ *  Handle of a gate instance in GatePool
+ *
+ */
+struct GateRef
+{
+  uint32_t type;
+  uint32_t index;
+};
+/**
+ *  Flyweight gate instances grouped by type
+ *
+ *  An instance is two words: packed states (2 bits per terminal) and packed
+ *  connection counts (2 bits per terminal). Evaluation runs one kernel per
+ *  type over all its instances.
+ */
+class GatePool
+{
+  struct Block
+  {
+    std::vector<uint32_t> states;
+    std::vector<uint32_t> conns;
+  };
+  GateTypeLibrary const& lib;
+  std::vector<Block> blocks;
+
+  Block& block(GateRef ref);
+  Block const& block(GateRef ref) const;
+
+public:
+  explicit GatePool(GateTypeLibrary const& library);
+  inline GateTypeLibrary const& library() const { return lib; }
+  /**
+   *  Create instance of type (all states Low, no connections)
+   *
+   *  type type id
+   *  GateRef
+   */
+  GateRef add(uint32_t type);
+  /**
+   *  Create instance from a dynamic gate of the same shape
+   *
+   *  type type id
+   *  gate source of states and connection numbers
+   *  GateRef
+   */
+  GateRef add(uint32_t type, Gate const& gate);
+  /**
+   *  Number of instances of type
+   *
+   */
+  size_t count(uint32_t type) const;
+  /**
+   *  Number of instances of all types
+   *
+   */
+  size_t count() const;
+  unsigned short getTerminalState(GateRef ref, size_t n) const;
+  unsigned short setTerminalState(GateRef ref, size_t n, unsigned short val);
+  unsigned short connections(GateRef ref, size_t n) const;
+  void connect(GateRef ref, size_t n);
+  void disconnect(GateRef ref, size_t n);
+  /**
+   *  Recompute outputs of every instance of type
+   *
+   */
+  void evaluate(uint32_t type);
+  /**
+   *  Recompute outputs of every instance
+   *
+   */
+  void evaluate();
+  /**
+   *  Expand instance into a dynamic gate
+   *
+   */
+  Gate toGate(GateRef ref) const;
+  /**
+   *  Heap bytes held by instances
+   *
+   */
+  size_t bytes() const;
+};
@@ -1,8 +1,43 @@
 #include "LogicGateDynamic.hpp"
-#include <map>
-typedef std::map<std::string, Gate> GateMap;
+#include "LogicGateJournal.hpp"
+#include "LogicGateServer.hpp"
+#include "LogicGateStateIndex.hpp"
+#include "LogicGateStats.hpp"
+#include <csignal>
+#include <fstream>
 
-void exit(GateMap& lg, std::string& sel) { exit(0); }
+/**
+ *  Journal of session edits (set up in main)
+ *
+ */
+Journal* journal = nullptr;
+/**
+ *  Terminals of the session by state (set up in main)
+ *
+ */
+StateIndex* states = nullptr;
+/**
+ *  Selected gate, or nullptr if it was removed since it was selected
+ *
+ *  Looks the gate up without creating it, so the session, its journal and
+ *  the state index never see a gate the user did not make.
+ */
+Gate* selected_gate(GateMap& lg, std::string const& sel)
+{
+  auto it = lg.find(sel);
+  if (it == lg.end())
+  {
+    std::cout << "Gate '" << sel << "' not found!";
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void exit(GateMap& lg, std::string& sel)
+{
+  journal->commit();
+  exit(0);
+}
 void new_gate(GateMap& lg, std::string& sel)
 {
   std::cout << "Input gate name: ";
@@ -29,7 +64,9 @@ void new_gate(GateMap& lg, std::string& sel)
     std::cin >> ch;
   }
   lg[name] = Gate(terms);
-  sel      = name;
+  journal->putGate(name);
+  states->update(name);
+  sel = name;
   std::cout << "Successfully created!";
 }
 
@@ -39,10 +76,20 @@ void remove_gate(GateMap& lg, std::string& sel)
   std::string name;
   std::cin.get();
   std::getline(std::cin, name);
-  std::cout << (lg.erase(name) == 1 ? "Successfully removed!" : "Key not found!");
+  bool removed = lg.erase(name) == 1;
+  if (removed)
+  {
+    journal->removeGate(name);
+    states->update(name);
+  }
+  std::cout << (removed ? "Successfully removed!" : "Key not found!");
 }
 
-void print_gate(GateMap& lg, std::string& sel) { std::cout << sel << " gate: \n" << lg[sel]; }
+void print_gate(GateMap& lg, std::string& sel)
+{
+  if (Gate* gate = selected_gate(lg, sel))
+    std::cout << sel << " gate: \n" << *gate;
+}
 
 void list_gates(GateMap& lg, std::string& sel)
 {
@@ -70,6 +117,9 @@ void select_gate(GateMap& lg, std::string& sel)
 
 void add_terminals(GateMap& lg, std::string& sel)
 {
+  Gate* gate = selected_gate(lg, sel);
+  if (!gate)
+    return;
   char ch = '1';
   while (ch == '1')
   {
@@ -86,7 +136,9 @@ void add_terminals(GateMap& lg, std::string& sel)
     std::cin >> term;
     try
     {
-      lg[sel] += std::move(term);
+      *gate += std::move(term);
+      journal->addTerminal(sel);
+      states->update(sel);
     }
     catch (std::bad_alloc& e)
     {
@@ -100,42 +152,55 @@ void add_terminals(GateMap& lg, std::string& sel)
 
 void get_term_state(GateMap& lg, std::string& sel)
 {
-  size_t pos = lg[sel].size();
-  while (pos >= lg[sel].size())
+  Gate* gate = selected_gate(lg, sel);
+  if (!gate)
+    return;
+  size_t pos = gate->size();
+  while (pos >= gate->size())
   {
-    std::cout << "Input terminal number (from 0 to " << lg[sel].size() - 1 << "): ";
+    std::cout << "Input terminal number (from 0 to " << gate->size() - 1 << "): ";
     std::cin >> pos;
   }
 
-  std::cout << "Terminal state: " << lg[sel][pos];
+  std::cout << "Terminal state: " << (*gate)[pos];
 }
 
 void set_term_state(GateMap& lg, std::string& sel)
 {
-  size_t pos = lg[sel].size();
-  while (pos >= lg[sel].size())
+  Gate* gate = selected_gate(lg, sel);
+  if (!gate)
+    return;
+  size_t pos = gate->size();
+  while (pos >= gate->size())
   {
-    std::cout << "Input terminal number (from 0 to " << lg[sel].size() - 1 << "): ";
+    std::cout << "Input terminal number (from 0 to " << gate->size() - 1 << "): ";
     std::cin >> pos;
   }
   unsigned short st;
   std::cout << "Input terminal state: ";
   std::cin >> st;
 
-  std::cout << "Terminal state set to: " << lg[sel](pos, st);
+  (*gate)(pos, st);
+  journal->setState(sel, pos);
+  states->update(sel, pos);
+  std::cout << "Terminal state set to: " << (*gate)[pos];
 }
 
 void connect_term(GateMap& lg, std::string& sel)
 {
-  size_t pos = lg[sel].size();
-  while (pos >= lg[sel].size())
+  Gate* gate = selected_gate(lg, sel);
+  if (!gate)
+    return;
+  size_t pos = gate->size();
+  while (pos >= gate->size())
   {
-    std::cout << "Input terminal number (from 0 to " << lg[sel].size() - 1 << "): ";
+    std::cout << "Input terminal number (from 0 to " << gate->size() - 1 << "): ";
     std::cin >> pos;
   }
   try
   {
-    lg[sel].connect(pos);
+    gate->connect(pos);
+    journal->connect(sel, pos);
   }
   catch (std::out_of_range& e)
   {
@@ -145,15 +210,19 @@ void connect_term(GateMap& lg, std::string& sel)
 
 void disconnect_term(GateMap& lg, std::string& sel)
 {
-  size_t pos = lg[sel].size();
-  while (pos >= lg[sel].size())
+  Gate* gate = selected_gate(lg, sel);
+  if (!gate)
+    return;
+  size_t pos = gate->size();
+  while (pos >= gate->size())
   {
-    std::cout << "Input terminal number (from 0 to " << lg[sel].size() - 1 << "): ";
+    std::cout << "Input terminal number (from 0 to " << gate->size() - 1 << "): ";
     std::cin >> pos;
   }
   try
   {
-    lg[sel].disconnect(pos);
+    gate->disconnect(pos);
+    journal->disconnect(sel, pos);
   }
   catch (std::out_of_range& e)
   {
@@ -161,16 +230,101 @@ void disconnect_term(GateMap& lg, std::string& sel)
   }
 }
 
-void renew_states(GateMap& lg, std::string& sel) { std::cin >> lg[sel]; }
+void renew_states(GateMap& lg, std::string& sel)
+{
+  Gate* gate = selected_gate(lg, sel);
+  if (!gate)
+    return;
+  std::cin >> *gate;
+  journal->putGate(sel);
+  states->update(sel);
+}
+
+void show_stats(GateMap& lg, std::string& sel)
+{
+  stats::print(std::cout) << "\n";
+  std::cout << "Dump as JSON?(0_/1) > ";
+  char ch;
+  std::cin >> ch;
+  if (ch != '1')
+    return;
+  std::cout << "Input file name ('-' for console): ";
+  std::string name;
+  std::cin >> name;
+  if (name == "-")
+  {
+    stats::dumpJson(std::cout);
+    return;
+  }
+  std::ofstream file(name);
+  if (!file)
+  {
+    std::cout << "Can not open file!";
+    return;
+  }
+  stats::dumpJson(file) << "\n";
+  std::cout << "Successfully written!";
+}
+
+void find_terminals(GateMap& lg, std::string& sel)
+{
+  std::cout << "Input state (0,1 or X): ";
+  Terminal probe;
+  std::cin >> probe;
+  std::cout << "Input iotype ('in':'out':'any'): ";
+  std::string ans;
+  while (ans != "in" && ans != "out" && ans != "any")
+    std::cin >> ans;
+  TerminalFilter filter = ans == "in" ? TerminalFilter::Inputs
+                          : ans == "out" ? TerminalFilter::Outputs
+                                         : TerminalFilter::Any;
+  std::cout << states->count(probe.state, filter) << " of " << states->size() << " terminals:\n";
+  for (auto const& ref : states->find(probe.state, filter))
+    std::cout << *ref.gate << "#" << ref.terminal << " ";
+}
 
 void (*options[])(GateMap&, std::string&) = {exit,           new_gate,     remove_gate,     list_gates,
                                              select_gate,    print_gate,   add_terminals,   get_term_state,
-                                             set_term_state, connect_term, disconnect_term, renew_states};
-int main()
+                                             set_term_state, connect_term, disconnect_term, renew_states,
+                                             show_stats,     find_terminals};
+/**
+ *  Daemon of --serve (set up in serve)
+ *
+ */
+SimulationServer* server = nullptr;
+
+int serve(int argc, char** argv)
 {
+  SimulationServer daemon(argv[2]);
+  for (int i = 3; i < argc; i++)
+    daemon.preload(argv[i]);
+  server = &daemon;
+  std::signal(SIGINT, [](int) { server->stop(); });
+  std::signal(SIGTERM, [](int) { server->stop(); });
+  std::cout << "Listening on " << argv[2] << std::endl;
+  daemon.run();
+  std::cout << "Served " << daemon.requests() << " requests" << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  // DynamicEdition --serve SOCKET [DESIGN...]: shared designs for many sessions
+  if (argc > 2 && std::string(argv[1]) == "--serve")
+    return serve(argc, argv);
   GateMap gates;
+  Journal session("logicgate.journal", gates);
+  journal              = &session;
   std::string selected = "invertor";
-  gates["invertor"]    = Gate{};
+  if (session.fresh())
+  {
+    gates["invertor"] = Gate{};
+    session.putGate("invertor");
+  }
+  else
+    std::cout << "Restored " << gates.size() << " gates (" << session.replayed() << " records)\n";
+  StateIndex index(gates);
+  states = &index;
 
   while (1)
   {
@@ -186,7 +340,9 @@ int main()
     [9]Set terminal state\n\
     [10]Connect terminal\n\
     [11]Disconnect terminal\n\
-    [12]Renew satates\n"
+    [12]Renew satates\n\
+    [13]Statistics\n\
+    [14]Find terminals\n"
                  ">>";
     int choice;
     std::cin >> choice;
@@ -200,6 +356,7 @@ int main()
       continue;
     }
     options[choice - 1](gates, selected);
+    session.commit();
     std::cout << std::endl;
   }
 }
\ No newline at end of file
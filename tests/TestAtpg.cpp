@@ -0,0 +1,172 @@
+#include "LogicGateAtpg.hpp"
+#include "LogicGatePipeline.hpp"
+#include "TestCheck.hpp"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+/**
+ *  Primary outputs under vec, with net fault (if any) stuck
+ *
+ */
+static std::vector<unsigned short> simulate(Netlist const& nl, std::vector<unsigned short> const& vec, Fault const* fault)
+{
+  std::vector<Planes> values(nl.nets(), Planes::broadcast(2));
+  for (size_t i = 0; i < vec.size(); i++)
+    values[nl.inputs()[i]] = Planes::broadcast(vec[i]);
+  if (fault)
+    values[fault->net] = Planes::broadcast(fault->stuck);
+  for (uint32_t g : nl.order())
+  {
+    nl.evaluateGate(g, values.data());
+    if (fault)
+      values[fault->net] = Planes::broadcast(fault->stuck);
+  }
+  std::vector<unsigned short> res;
+  for (NetId net : nl.outputs())
+    res.push_back(values[net].lane(0));
+  return res;
+}
+
+static bool detects(Netlist const& nl, std::vector<unsigned short> const& vec, Fault const& fault)
+{
+  auto good = simulate(nl, vec, nullptr), bad = simulate(nl, vec, &fault);
+  for (size_t o = 0; o < good.size(); o++)
+    if (good[o] != 2 && bad[o] != 2 && good[o] != bad[o])
+      return true;
+  return false;
+}
+
+static Netlist randomCircuit(GateTypeLibrary const& lib, std::vector<uint32_t> const& types, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  Netlist nl(lib);
+  std::vector<NetId> nets;
+  for (int i = 0; i < 10; i++)
+  {
+    nets.push_back(nl.addNet());
+    nl.addInput(nets.back());
+  }
+  for (int g = 0; g < 150; g++)
+  {
+    uint32_t type = types[rng() % types.size()];
+    std::vector<NetId> pins;
+    size_t low = nets.size() > 20 ? nets.size() - 20 : 0;
+    for (size_t k = 0; k < lib[type].inputs(); k++)
+      pins.push_back(nets[low + rng() % (nets.size() - low)]);
+    for (size_t k = 0; k < lib[type].outputs(); k++)
+      pins.push_back(nl.addNet());
+    nl.addGate(type, pins);
+    nets.insert(nets.end(), pins.end() - lib[type].outputs(), pins.end());
+  }
+  for (int o = 0; o < 8; o++)
+    nl.addOutput(nets[nets.size() - 1 - o * 3]);
+  return nl;
+}
+
+static void check(Netlist const& nl)
+{
+  AtpgResult res = Atpg(nl).run();
+  CHECK(res.detected + res.untestable + res.aborted <= res.faults.size());
+
+  // An independent fault simulation of the final patterns detects exactly
+  // the faults ATPG reports as detected
+  std::vector<FaultStatus> status(res.faults.size(), FaultStatus::Undetected);
+  CHECK(FaultSimulator(nl).run(res.patterns, res.faults, status) == res.detected);
+  for (size_t f = 0; f < res.faults.size(); f++)
+    CHECK((status[f] == FaultStatus::Detected) == (res.status[f] == FaultStatus::Detected));
+
+  // Serial simulation agrees, and no vector of the design detects a fault
+  // proven untestable (the designs are small enough to enumerate)
+  std::vector<std::vector<unsigned short>> vectors;
+  for (size_t p = 0; p < res.patterns.size(); p++)
+    vectors.push_back(res.patterns.vector(p));
+  size_t inputs = nl.inputs().size();
+  for (size_t f = 0; f < res.faults.size(); f++)
+  {
+    bool detected = false;
+    for (auto const& vec : vectors)
+      detected = detected || detects(nl, vec, res.faults[f]);
+    CHECK(detected == (res.status[f] == FaultStatus::Detected));
+    if (res.status[f] != FaultStatus::Untestable)
+      continue;
+    std::vector<unsigned short> vec(inputs);
+    for (uint64_t v = 0; v < 1ULL << inputs; v++)
+    {
+      for (size_t i = 0; i < inputs; i++)
+        vec[i] = v >> i & 1;
+      CHECK(!detects(nl, vec, res.faults[f]));
+    }
+  }
+
+  // Saved patterns load back and replay through the stimulus pipeline
+  res.patterns.save("TestAtpg.vec");
+  PatternSet back = PatternSet::load("TestAtpg.vec", inputs);
+  CHECK(back.size() == vectors.size());
+  std::ifstream file("TestAtpg.vec");
+  std::stringstream responses;
+  CHECK(StimulusPipeline(nl).run(file, &responses).vectors == vectors.size());
+  std::string line;
+  for (size_t p = 0; p < vectors.size(); p++)
+  {
+    CHECK(back.vector(p) == vectors[p]);
+    CHECK(std::getline(responses, line));
+    auto expect = simulate(nl, vectors[p], nullptr);
+    for (size_t o = 0; o < expect.size(); o++)
+      CHECK(line[o] == "01X"[expect[o]]);
+  }
+  std::remove("TestAtpg.vec");
+}
+
+int main()
+{
+  GateTypeLibrary lib;
+  uint32_t nand2 = lib.intern(GateType("nand2", GateFunction::Nand, 2, 1));
+  uint32_t and2  = lib.intern(GateType("and2", GateFunction::And, 2, 1));
+  uint32_t or2   = lib.intern(GateType("or2", GateFunction::Or, 2, 1));
+  std::vector<uint32_t> types = {nand2,
+                                 and2,
+                                 or2,
+                                 lib.intern(GateType("xor2", GateFunction::Xor, 2, 1)),
+                                 lib.intern(GateType("not", GateFunction::Not, 1, 1)),
+                                 lib.intern(GateType("nor3", GateFunction::Nor, 3, 1)),
+                                 lib.intern(GateType("adder", {false, false, false, true, true}, {0x96, 0xE8}))};
+
+  // ISCAS c17: every fault is testable
+  {
+    Netlist nl(lib);
+    NetId in[5];
+    for (auto& net : in)
+    {
+      net = nl.addNet();
+      nl.addInput(net);
+    }
+    NetId n10 = nl.addNet(), n11 = nl.addNet(), n16 = nl.addNet(), n19 = nl.addNet(), n22 = nl.addNet(), n23 = nl.addNet();
+    nl.addGate(nand2, {in[0], in[2], n10});
+    nl.addGate(nand2, {in[2], in[3], n11});
+    nl.addGate(nand2, {in[1], n11, n16});
+    nl.addGate(nand2, {n11, in[4], n19});
+    nl.addGate(nand2, {n10, n16, n22});
+    nl.addGate(nand2, {n16, n19, n23});
+    nl.addOutput(n22);
+    nl.addOutput(n23);
+    check(nl);
+    CHECK(Atpg(nl).run().coverage() == 1);
+  }
+  // y = a | (a & b): the AND gate is redundant
+  {
+    Netlist nl(lib);
+    NetId a = nl.addNet(), b = nl.addNet(), t = nl.addNet(), y = nl.addNet();
+    nl.addInput(a);
+    nl.addInput(b);
+    nl.addGate(and2, {a, b, t});
+    nl.addGate(or2, {a, t, y});
+    nl.addOutput(y);
+    check(nl);
+    CHECK(Atpg(nl).run().untestable > 0);
+  }
+  for (unsigned seed = 1; seed <= 2; seed++)
+    check(randomCircuit(lib, types, seed));
+  return 0;
+}
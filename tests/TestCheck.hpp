@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+/**
+ *  Fail the test unless cond holds
+ *
+ *  Unlike assert it stays active in Release builds.
+ */
+#define CHECK(cond)                                                                                                              \
+  do                                                                                                                             \
+  {                                                                                                                              \
+    if (!(cond))                                                                                                                 \
+    {                                                                                                                            \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                              \
+      std::exit(1);                                                                                                              \
+    }                                                                                                                            \
+  } while (0)
@@ -0,0 +1,69 @@
+#include "LogicGateConcurrent.hpp"
+#include "TestCheck.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int main()
+{
+  GateMap gates;
+  gates["a"] = Gate(2, 2);
+  ConcurrentGateMap map(gates);
+
+  // Readers check that every snapshot of "a" is one the writer published
+  // (all states equal) while gates come and go around it
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> torn{0}, reads{0}, missing{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++)
+    readers.emplace_back([&]() {
+      while (!stop.load(std::memory_order_relaxed))
+      {
+        auto states = map["a"].snapshot();
+        for (size_t i = 1; i < states.size(); i++)
+          torn += states[i] != states[0];
+        try
+        {
+          auto view = map["b" + std::to_string(reads % 16)];
+          CHECK(view.size() == 3);
+        }
+        catch (std::out_of_range const&)
+        {
+          missing++;
+        }
+        for (auto const& name : map.names())
+          CHECK(name == "a" || name[0] == 'b');
+        reads++;
+      }
+    });
+
+  size_t terminals = 4;
+  for (int i = 0; i < 100000; i++)
+  {
+    unsigned short state = i % 3;
+    map.setTerminalStates("a", std::vector<unsigned short>(terminals, state));
+    if (i % 1000 == 0)
+    {
+      map.addTerminal("a", Terminal(true, 0, state));
+      terminals++;
+    }
+    std::string name = "b" + std::to_string(i % 16);
+    if (i % 3)
+      map.insert(name, Gate(2, 1));
+    else
+      map.erase(name);
+  }
+  stop = true;
+  for (auto& thread : readers)
+    thread.join();
+
+  CHECK(torn == 0);
+  CHECK(reads > 0);
+  CHECK(map["a"].size() == terminals);
+  GateMap back = map.toGateMap();
+  CHECK(back.size() == map.names().size());
+  for (size_t i = 0; i < terminals; i++)
+    CHECK(back["a"][i] == 99999 % 3);
+  return 0;
+}
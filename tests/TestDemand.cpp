@@ -0,0 +1,89 @@
+#include "LogicGateDemand.hpp"
+#include "TestCheck.hpp"
+#include <random>
+
+/**
+ *  Gates in the transitive fanin cone of net
+ *
+ */
+static size_t coneSize(Netlist const& nl, NetId net)
+{
+  std::vector<char> seen(nl.gates());
+  std::vector<NetId> stack = {net};
+  size_t size = 0;
+  while (!stack.empty())
+  {
+    uint32_t g = nl.driver(stack.back());
+    stack.pop_back();
+    if (g == NoGate || seen[g])
+      continue;
+    seen[g] = 1;
+    size++;
+    for (size_t n = 0; n < nl.type(g).size(); n++)
+      if (!nl.type(g).isOutput(n))
+        stack.push_back(nl.pin(g, n));
+  }
+  return size;
+}
+
+int main()
+{
+  GateTypeLibrary lib;
+  uint32_t types[] = {lib.intern(GateType("and2", GateFunction::And, 2, 1)), lib.intern(GateType("or3", GateFunction::Or, 3, 1)),
+                      lib.intern(GateType("xor2", GateFunction::Xor, 2, 1)), lib.intern(GateType("nand2", GateFunction::Nand, 2, 1)),
+                      lib.intern(GateType("nor2", GateFunction::Nor, 2, 1))};
+  const size_t Inputs = 200;
+  std::mt19937 rng(5);
+  Netlist nl(lib);
+  std::vector<NetId> nets;
+  for (size_t i = 0; i < Inputs; i++)
+  {
+    nets.push_back(nl.addNet());
+    nl.addInput(nets.back());
+  }
+  for (int g = 0; g < 20000; g++)
+  {
+    uint32_t type = types[rng() % 5];
+    std::vector<NetId> pins;
+    for (size_t k = 0; k < lib[type].inputs(); k++)
+      pins.push_back(nets[nets.size() - 1 - rng() % std::min<size_t>(nets.size(), 300)]);
+    pins.push_back(nl.addNet());
+    nl.addGate(type, pins);
+    nets.push_back(pins.back());
+  }
+
+  DemandEvaluator demand(nl);
+  std::vector<unsigned short> inputs(Inputs);
+  for (auto& state : inputs)
+    state = rng() % 3;
+  demand.setInputs(inputs);
+  std::vector<Planes> values(nl.nets());
+  for (int it = 0; it < 60; it++)
+  {
+    if (it % 3 == 0)
+    {
+      size_t i  = rng() % Inputs;
+      inputs[i] = rng() % 3;
+      demand.setInput(i, inputs[i]);
+    }
+    std::fill(values.begin(), values.end(), Planes::broadcast(2));
+    for (size_t i = 0; i < Inputs; i++)
+      values[nl.inputs()[i]] = Planes::broadcast(inputs[i]);
+    nl.evaluate(values.data());
+    for (int k = 0; k < 5; k++)
+    {
+      NetId net       = nets[nets.size() - 1 - rng() % 2000];
+      uint64_t before = demand.evaluated();
+      CHECK(demand.state(net) == values[net].lane(0));
+      // A query evaluates at most the gates of its cone
+      CHECK(demand.evaluated() - before <= coneSize(nl, net));
+    }
+  }
+  // Repeated queries without input changes are answered from the memo
+  NetId net = nets.back();
+  demand.state(net);
+  uint64_t before = demand.evaluated();
+  CHECK(demand.state(net) == values[net].lane(0));
+  CHECK(demand.evaluated() == before);
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include "LogicGateEquivalence.hpp"
+#include "TestCheck.hpp"
+#include <random>
+
+/**
+ *  Random circuit; gate mutate (if any) gets a different type
+ *
+ */
+static Netlist randomCircuit(GateTypeLibrary const& lib, std::vector<uint32_t> const& types, size_t inputs, size_t gates,
+                             size_t undriven, uint64_t seed, size_t mutate)
+{
+  std::mt19937_64 rng(seed);
+  Netlist nl(lib);
+  std::vector<NetId> pool;
+  for (size_t i = 0; i < inputs; i++)
+  {
+    pool.push_back(nl.addNet());
+    nl.addInput(pool.back());
+  }
+  for (size_t i = 0; i < undriven; i++)
+    pool.push_back(nl.addNet());
+  for (size_t g = 0; g < gates; g++)
+  {
+    size_t pick = rng() % types.size();
+    if (g == mutate)
+      pick = (pick + 1) % types.size();
+    uint32_t type = types[pick];
+    std::vector<NetId> pins;
+    for (size_t k = 0; k < lib[type].inputs(); k++)
+      pins.push_back(pool[rng() % pool.size()]);
+    pins.push_back(nl.addNet());
+    nl.addGate(type, pins);
+    pool.push_back(pins.back());
+  }
+  for (size_t o = 0; o < 4; o++)
+    nl.addOutput(pool[pool.size() - 1 - o]);
+  return nl;
+}
+
+/**
+ *  Outputs differ under vec where both sides are known
+ *
+ */
+static bool differs(Netlist const& a, Netlist const& b, std::vector<unsigned short> const& vec, size_t output)
+{
+  unsigned short x = a.evaluate(vec)[output], y = b.evaluate(vec)[output];
+  return x != 2 && y != 2 && x != y;
+}
+
+int main()
+{
+  GateTypeLibrary lib;
+  std::vector<uint32_t> types = {
+      lib.intern(GateType("and2", GateFunction::And, 2, 1)),  lib.intern(GateType("or3", GateFunction::Or, 3, 1)),
+      lib.intern(GateType("xor2", GateFunction::Xor, 2, 1)),  lib.intern(GateType("xnor3", GateFunction::Xnor, 3, 1)),
+      lib.intern(GateType("nand2", GateFunction::Nand, 2, 1)), lib.intern(GateType("not", GateFunction::Not, 1, 1)),
+      lib.intern(GateType("maj", {false, false, false, true}, {0xE8})),
+      lib.intern(GateType("xor", {false, false, true}, {0x6}))};
+
+  // Every engine on its own must agree with exhaustive ternary simulation
+  std::mt19937_64 rng(7);
+  size_t different = 0;
+  for (size_t it = 0; it < 600; it++)
+  {
+    size_t inputs = 3 + it % 6, gates = 5 + it % 20, undriven = it % 3;
+    uint64_t seed = rng();
+    size_t mutate = it % 4 ? rng() % gates : gates;
+    Netlist a = randomCircuit(lib, types, inputs, gates, undriven, seed, gates);
+    Netlist b = randomCircuit(lib, types, inputs, gates, undriven, seed, mutate);
+
+    bool equivalent = true;
+    std::vector<unsigned short> vec(inputs);
+    for (uint64_t v = 0; v < 1ULL << inputs && equivalent; v++)
+    {
+      for (size_t i = 0; i < inputs; i++)
+        vec[i] = v >> i & 1;
+      for (size_t o = 0; o < 4; o++)
+        equivalent = equivalent && !differs(a, b, vec, o);
+    }
+    different += !equivalent;
+
+    EquivalenceChecker exhaustive(a, b), bdd(a, b), sat(a, b);
+    exhaustive.randomBlocks = bdd.randomBlocks = sat.randomBlocks = 0;
+    bdd.exhaustiveLimit     = sat.exhaustiveLimit = 0;
+    sat.bddNodeLimit        = 0;
+
+    EquivalenceResult results[] = {exhaustive.check(), bdd.check(), sat.check()};
+    char const* methods[]       = {"exhaustive", "bdd", "sat"};
+    for (size_t e = 0; e < 3; e++)
+    {
+      EquivalenceResult const& res = results[e];
+      CHECK(res.method == methods[e]);
+      CHECK(res.equivalent == equivalent);
+      if (!res.equivalent)
+      {
+        CHECK(res.counterexample.size() == inputs);
+        CHECK(differs(a, b, res.counterexample, res.output));
+      }
+    }
+  }
+  // The mutations must have produced both outcomes
+  CHECK(different > 0 && different < 600);
+  return 0;
+}
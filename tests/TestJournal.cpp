@@ -0,0 +1,156 @@
+#include "LogicGateJournal.hpp"
+#include "TestCheck.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static const std::string Path = "TestJournal.journal";
+
+static bool same(GateMap const& a, GateMap const& b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (auto const& keyval : a)
+  {
+    auto it = b.find(keyval.first);
+    if (it == b.end() || it->second.size() != keyval.second.size())
+      return false;
+    for (size_t i = 0; i < keyval.second.size(); i++)
+    {
+      Terminal const &x = keyval.second.terminal(i), &y = it->second.terminal(i);
+      if (x.isOutput != y.isOutput || x.conn_num != y.conn_num || x.state != y.state)
+        return false;
+    }
+  }
+  return true;
+}
+
+static size_t fileSize()
+{
+  std::ifstream file(Path, std::ios::binary | std::ios::ate);
+  return size_t(file.tellg());
+}
+
+/**
+ *  One group of edits, committed
+ *
+ */
+static void edit(GateMap& gates, Journal& journal, int round)
+{
+  for (int i = 0; i < 50; i++)
+  {
+    std::string name = "g" + std::to_string((i * 7 + round) % 30);
+    auto it          = gates.find(name);
+    switch ((i + round) % 6)
+    {
+    case 0:
+      gates[name] = Gate(2, 1);
+      journal.putGate(name);
+      break;
+    case 1:
+      if (it != gates.end())
+      {
+        it->second += Terminal(true, 0, 1);
+        journal.addTerminal(name);
+      }
+      break;
+    case 2:
+      if (it != gates.end() && it->second.size())
+      {
+        it->second(0, (i + round) % 3);
+        journal.setState(name, 0);
+      }
+      break;
+    case 3:
+      if (it != gates.end() && it->second.size() && it->second.terminal(0).conn_num == 0)
+      {
+        it->second.connect(0);
+        journal.connect(name, 0);
+      }
+      break;
+    case 4:
+      if (it != gates.end())
+      {
+        gates.erase(it);
+        journal.removeGate(name);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  journal.commit();
+}
+
+int main()
+{
+  std::remove(Path.c_str());
+  std::remove((Path + ".snap").c_str());
+
+  GateMap expect;
+  size_t intact, full;
+  {
+    GateMap gates;
+    Journal journal(Path, gates);
+    CHECK(journal.fresh());
+    journal.durable = false;
+    for (int round = 0; round < 5; round++)
+      edit(gates, journal, round);
+    expect = gates;
+    intact = fileSize();
+    // One large record, cut in the middle below
+    gates["torn"] = Gate(40, 40);
+    journal.putGate("torn");
+    journal.commit();
+    full = fileSize();
+  }
+  CHECK(full > intact + 16);
+  CHECK(truncate(Path.c_str(), (intact + full) / 2) == 0);
+
+  // The torn record is dropped, and cut off so later records replay
+  {
+    GateMap gates;
+    Journal journal(Path, gates);
+    CHECK(!journal.fresh());
+    CHECK(same(gates, expect));
+    CHECK(fileSize() == intact);
+    edit(gates, journal, 5);
+    expect = gates;
+  }
+  {
+    GateMap gates;
+    Journal journal(Path, gates);
+    CHECK(same(gates, expect));
+  }
+
+  // A corrupted byte in the last record fails its checksum
+  {
+    GateMap gates;
+    Journal journal(Path, gates);
+    gates["late"] = Gate(1, 1);
+    journal.putGate("late");
+    journal.commit();
+  }
+  {
+    std::fstream file(Path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-3, std::ios::end);
+    file.put('\x5a');
+  }
+  {
+    GateMap gates;
+    Journal journal(Path, gates);
+    CHECK(same(gates, expect));
+    // Compaction keeps the state across the snapshot
+    journal.compact();
+  }
+  {
+    GateMap gates;
+    Journal journal(Path, gates);
+    CHECK(same(gates, expect));
+    CHECK(journal.size() == 0);
+  }
+  std::remove(Path.c_str());
+  std::remove((Path + ".snap").c_str());
+  return 0;
+}
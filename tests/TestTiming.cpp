@@ -0,0 +1,109 @@
+#include "LogicGateLevels.hpp"
+#include "LogicGateTiming.hpp"
+#include "TestCheck.hpp"
+#include <random>
+#include <stdexcept>
+
+static const size_t Gates = 20000;
+
+/**
+ *  Fresh analysis of nl with the delays of timing
+ *
+ */
+static bool matchesFresh(Netlist const& nl, TimingAnalysis const& timing)
+{
+  TimingAnalysis fresh(nl, timing.period());
+  for (uint32_t g = 0; g < nl.gates(); g++)
+    fresh.setGateDelay(g, timing.gateDelay(g));
+  fresh.analyze();
+  for (NetId net = 0; net < nl.nets(); net++)
+    if (fresh.arrival(net) != timing.arrival(net) || fresh.required(net) != timing.required(net))
+      return false;
+  return fresh.worstSlack() == timing.worstSlack();
+}
+
+int main()
+{
+  GateTypeLibrary lib;
+  uint32_t and2 = lib.intern(GateType("and2", GateFunction::And, 2, 1));
+  uint32_t inv  = lib.intern(GateType("not", GateFunction::Not, 1, 1));
+  std::mt19937 rng(3);
+  Netlist nl(lib);
+  std::vector<NetId> nets;
+  for (int i = 0; i < 64; i++)
+  {
+    nets.push_back(nl.addNet());
+    nl.addInput(nets.back());
+  }
+  auto pick = [&]() {
+    size_t low = nets.size() > 2000 ? nets.size() - 2000 : 0;
+    return nets[low + rng() % (nets.size() - low)];
+  };
+  for (size_t g = 0; g < Gates; g++)
+  {
+    NetId out = nl.addNet();
+    if (rng() % 3)
+      nl.addGate(and2, {pick(), pick(), out});
+    else
+      nl.addGate(inv, {pick(), out});
+    nets.push_back(out);
+  }
+  for (int o = 0; o < 64; o++)
+    nl.addOutput(nets[nets.size() - 1 - o * 7]);
+  // Gate index order is still topological here
+  Netlist plain = nl;
+
+  // Edits through IncrementalLevels: every update must leave the same times
+  // as a fresh analysis of the edited netlist
+  IncrementalLevels levels(nl);
+  TimingAnalysis timing(levels, 1000);
+  for (uint32_t g = 0; g < nl.gates(); g += 97)
+    timing.setGateDelay(g, 1.5);
+  CHECK(timing.update() > 0);
+  CHECK(matchesFresh(nl, timing));
+
+  size_t edits = 0, refused = 0, recomputed = 0;
+  for (int e = 0; e < 200; e++)
+  {
+    uint32_t g = rng() % nl.gates();
+    if (e % 4 == 0)
+      timing.setGateDelay(g, 0.5 + rng() % 4);
+    else
+    {
+      NetId old = nl.pin(g, 0);
+      try
+      {
+        levels.connect(g, 0, nets[rng() % nets.size()]);
+      }
+      catch (std::runtime_error const&)
+      {
+        refused++;
+        continue;
+      }
+      timing.gateChanged(g, {old});
+    }
+    recomputed += timing.update();
+    edits++;
+    if (e % 20 == 0)
+      CHECK(matchesFresh(nl, timing));
+  }
+  CHECK(matchesFresh(nl, timing));
+  // Edits stay in their cones instead of sweeping the design
+  CHECK(edits > 100 && recomputed / edits < Gates / 4);
+
+  // Direct netlist edits relevelize, but give the same times
+  TimingAnalysis direct(plain, 1000);
+  for (uint32_t g = 0; g < plain.gates(); g += 97)
+    direct.setGateDelay(g, 1.5);
+  direct.update();
+  for (int e = 0; e < 50; e++)
+  {
+    uint32_t g = rng() % Gates;
+    NetId old  = plain.pin(g, 0);
+    plain.reconnect(g, 0, nets[rng() % (64 + g)]);
+    direct.gateChanged(g, {old});
+    direct.update();
+  }
+  CHECK(matchesFresh(plain, direct));
+  return 0;
+}